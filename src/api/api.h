@@ -39,6 +39,7 @@ extern const luaL_Reg lovrHingeJoint[];
 extern const luaL_Reg lovrMat4[];
 extern const luaL_Reg lovrMaterial[];
 extern const luaL_Reg lovrMesh[];
+extern const luaL_Reg lovrMeshShape[];
 extern const luaL_Reg lovrMicrophone[];
 extern const luaL_Reg lovrModel[];
 extern const luaL_Reg lovrModelData[];
@@ -47,10 +48,12 @@ extern const luaL_Reg lovrRandomGenerator[];
 extern const luaL_Reg lovrRasterizer[];
 extern const luaL_Reg lovrShader[];
 extern const luaL_Reg lovrShaderBlock[];
+extern const luaL_Reg lovrSharedBuffer[];
 extern const luaL_Reg lovrSliderJoint[];
 extern const luaL_Reg lovrSoundData[];
 extern const luaL_Reg lovrSource[];
 extern const luaL_Reg lovrSphereShape[];
+extern const luaL_Reg lovrTerrainShape[];
 extern const luaL_Reg lovrTexture[];
 extern const luaL_Reg lovrTextureData[];
 extern const luaL_Reg lovrThread[];
@@ -65,8 +68,10 @@ extern const char* AttributeTypes[];
 extern const char* BlendAlphaModes[];
 extern const char* BlendModes[];
 extern const char* BlockTypes[];
+extern const char* BroadphaseTypes[];
 extern const char* BufferUsages[];
 extern const char* CompareModes[];
+extern const char* ContactEventTypes[];
 extern const char* CoordinateSpaces[];
 extern const char* Devices[];
 extern const char* DeviceAxes[];
@@ -91,6 +96,7 @@ extern const char* TextureTypes[];
 extern const char* TimeUnits[];
 extern const char* UniformAccesses[];
 extern const char* VerticalAligns[];
+extern const char* ViewTypes[];
 extern const char* Windings[];
 extern const char* WrapModes[];
 
@@ -137,12 +143,24 @@ void luax_readcolor(lua_State* L, int index, struct Color* color);
 #ifdef LOVR_ENABLE_DATA
 struct Blob;
 struct Blob* luax_readblob(lua_State* L, int index, const char* debug);
+struct Blob* luax_checkblob(lua_State* L, int index);
 #endif
 
 #ifdef LOVR_ENABLE_EVENT
 struct Variant;
 void luax_checkvariant(lua_State* L, int index, struct Variant* variant);
 int luax_pushvariant(lua_State* L, struct Variant* variant);
+
+// Variants for batches live in a userdata that destroys the ones from start to count when it's
+// collected, so nothing leaks when converting a value throws partway through
+typedef struct {
+  uint32_t start;
+  uint32_t count;
+  struct Variant* variants;
+} VariantBatch;
+
+VariantBatch* luax_newvariantbatch(lua_State* L, uint32_t count);
+void luax_destroyvariantbatch(VariantBatch* batch);
 #endif
 
 #ifdef LOVR_ENABLE_GRAPHICS
@@ -159,7 +177,11 @@ void luax_readattachments(lua_State* L, int index, struct Attachment* attachment
 #include "math/randomGenerator.h" // TODO
 float* luax_tovector(lua_State* L, int index, VectorType* type);
 float* luax_checkvector(lua_State* L, int index, VectorType type, const char* expected);
+float* luax_newvector(lua_State* L, VectorType type, size_t components);
 float* luax_newtempvector(lua_State* L, VectorType type);
+void luax_drainvectors(void);
+void* luax_bindvectors(lua_State* L);
+void luax_unbindvectors(void* previous);
 int luax_readvec3(lua_State* L, int index, float* v, const char* expected);
 int luax_readscale(lua_State* L, int index, float* v, int components, const char* expected);
 int luax_readquat(lua_State* L, int index, float* q, const char* expected);
@@ -15,6 +15,19 @@ const char* SourceTypes[] = {
   NULL
 };
 
+const char* MixerTypes[] = {
+  [MIXER_OPENAL] = "openal",
+  [MIXER_SOFTWARE] = "software",
+  NULL
+};
+
+const char* SinkTypes[] = {
+  [SINK_OPENAL] = "openal",
+  [SINK_NULL] = "null",
+  [SINK_FILE] = "file",
+  NULL
+};
+
 const char* TimeUnits[] = {
   [UNIT_SECONDS] = "seconds",
   [UNIT_SAMPLES] = "samples",
@@ -98,6 +111,31 @@ static int l_lovrAudioGetVelocity(lua_State* L) {
   return 3;
 }
 
+static int l_lovrAudioGetCullThreshold(lua_State* L) {
+  lua_pushnumber(L, lovrAudioGetCullThreshold());
+  return 1;
+}
+
+static int l_lovrAudioGetStats(lua_State* L) {
+  uint32_t voices, active, virtual, stolen;
+  lovrAudioGetVoiceStats(&voices, &active, &virtual, &stolen);
+  lua_createtable(L, 0, 4);
+  lua_pushinteger(L, voices);
+  lua_setfield(L, -2, "voices");
+  lua_pushinteger(L, active);
+  lua_setfield(L, -2, "active");
+  lua_pushinteger(L, virtual);
+  lua_setfield(L, -2, "virtual");
+  lua_pushinteger(L, stolen);
+  lua_setfield(L, -2, "stolen");
+  return 1;
+}
+
+static int l_lovrAudioGetUnderruns(lua_State* L) {
+  lua_pushinteger(L, lovrAudioGetUnderruns());
+  return 1;
+}
+
 static int l_lovrAudioGetVolume(lua_State* L) {
   lua_pushnumber(L, lovrAudioGetVolume());
   return 1;
@@ -134,7 +172,7 @@ static int l_lovrAudioNewSource(lua_State* L) {
         soundData = lovrSoundDataCreateFromAudioStream(stream);
       } else {
         Blob* blob = luax_readblob(L, 1, "Source");
-        soundData = lovrSoundDataCreateFromBlob(blob);
+        soundData = lovrSoundDataCreateFromBlob(blob, true);
         lovrRelease(Blob, blob);
       }
 
@@ -147,7 +185,7 @@ static int l_lovrAudioNewSource(lua_State* L) {
       source = lovrSourceCreateStream(stream);
     } else {
       Blob* blob = luax_readblob(L, 1, "Source");
-      stream = lovrAudioStreamCreate(blob, 4096);
+      stream = lovrAudioStreamCreate(blob, lovrAudioGetBufferSize());
       lovrAssert(stream, "Could not create stream Source");
       source = lovrSourceCreateStream(stream);
       lovrRelease(Blob, blob);
@@ -160,6 +198,12 @@ static int l_lovrAudioNewSource(lua_State* L) {
   return 1;
 }
 
+static int l_lovrAudioRender(lua_State* L) {
+  uint32_t frames = luaL_checkinteger(L, 1);
+  lovrAudioRender(frames);
+  return 0;
+}
+
 static int l_lovrAudioPause(lua_State* L) {
   lovrAudioPause();
   return 0;
@@ -175,6 +219,11 @@ static int l_lovrAudioRewind(lua_State* L) {
   return 0;
 }
 
+static int l_lovrAudioSetCullThreshold(lua_State* L) {
+  lovrAudioSetCullThreshold(luax_checkfloat(L, 1));
+  return 0;
+}
+
 static int l_lovrAudioSetDopplerEffect(lua_State* L) {
   float factor = luax_optfloat(L, 1, 1.f);
   float speedOfSound = luax_optfloat(L, 2, 343.29f);
@@ -226,19 +275,24 @@ static int l_lovrAudioStop(lua_State* L) {
 
 static const luaL_Reg lovrAudio[] = {
   { "update", l_lovrAudioUpdate },
+  { "getCullThreshold", l_lovrAudioGetCullThreshold },
   { "getDopplerEffect", l_lovrAudioGetDopplerEffect },
   { "getMicrophoneNames", l_lovrAudioGetMicrophoneNames },
   { "getOrientation", l_lovrAudioGetOrientation },
   { "getPose", l_lovrAudioGetPose },
   { "getPosition", l_lovrAudioGetPosition },
+  { "getStats", l_lovrAudioGetStats },
+  { "getUnderruns", l_lovrAudioGetUnderruns },
   { "getVelocity", l_lovrAudioGetVelocity },
   { "getVolume", l_lovrAudioGetVolume },
   { "isSpatialized", l_lovrAudioIsSpatialized },
   { "newMicrophone", l_lovrAudioNewMicrophone },
   { "newSource", l_lovrAudioNewSource },
   { "pause", l_lovrAudioPause },
+  { "render", l_lovrAudioRender },
   { "resume", l_lovrAudioResume },
   { "rewind", l_lovrAudioRewind },
+  { "setCullThreshold", l_lovrAudioSetCullThreshold },
   { "setDopplerEffect", l_lovrAudioSetDopplerEffect },
   { "setOrientation", l_lovrAudioSetOrientation },
   { "setPose", l_lovrAudioSetPose },
@@ -254,8 +308,53 @@ int luaopen_lovr_audio(lua_State* L) {
   luaL_register(L, NULL, lovrAudio);
   luax_registertype(L, Microphone);
   luax_registertype(L, Source);
-  if (lovrAudioInit()) {
+
+  luax_pushconf(L);
+  lua_getfield(L, -1, "audio");
+
+  MixerType mixer = MIXER_OPENAL;
+  SinkType sink = SINK_OPENAL;
+  uint32_t sampleRate = 48000;
+  uint32_t bufferCount = 4;
+  uint32_t bufferSize = 4096;
+  uint32_t voiceCount = 64;
+  const char* filename = NULL;
+
+  if (lua_istable(L, -1)) {
+    lua_getfield(L, -1, "mixer");
+    mixer = luaL_checkoption(L, -1, "openal", MixerTypes);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "sink");
+    sink = luaL_checkoption(L, -1, "openal", SinkTypes);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "samplerate");
+    sampleRate = luaL_optinteger(L, -1, 48000);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "buffers");
+    bufferCount = luaL_optinteger(L, -1, 4);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "buffersize");
+    bufferSize = luaL_optinteger(L, -1, 4096);
+    lua_pop(L, 1);
+
+    lua_getfield(L, -1, "voices");
+    voiceCount = luaL_optinteger(L, -1, 64);
+    lua_pop(L, 1);
+
+    // The string stays alive in the conf table while the sink is initialized
+    lua_getfield(L, -1, "file");
+    filename = lua_tostring(L, -1);
+    lua_pop(L, 1);
+  }
+
+  if (lovrAudioInit(mixer, sink, sampleRate, bufferCount, bufferSize, voiceCount, filename)) {
     luax_atexit(L, lovrAudioDestroy);
   }
+
+  lua_pop(L, 2);
   return 1;
 }
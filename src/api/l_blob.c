@@ -1,5 +1,16 @@
 #include "api.h"
 #include "data/blob.h"
+#include "data/sharedBuffer.h"
+
+// SharedBuffers are Blobs underneath, so they work anywhere a Blob does
+Blob* luax_checkblob(lua_State* L, int index) {
+  Blob* blob = luax_totype(L, index, Blob);
+  if (!blob) {
+    SharedBuffer* buffer = luax_totype(L, index, SharedBuffer);
+    blob = buffer ? &buffer->blob : luax_checktype(L, index, Blob);
+  }
+  return blob;
+}
 
 static int l_lovrBlobGetName(lua_State* L) {
   Blob* blob = luax_checktype(L, 1, Blob);
@@ -22,10 +22,16 @@ static int l_lovrChannelPush(lua_State* L) {
   Variant variant;
   double timeout;
   Channel* channel = luax_checktype(L, 1, Channel);
-  luax_checkvariant(L, 2, &variant);
   luax_checktimeout(L, 3, &timeout);
+  luax_checkvariant(L, 2, &variant);
   uint64_t id;
   bool read = lovrChannelPush(channel, &variant, timeout, &id);
+
+  // The Channel only takes the message if it was pushed, which can fail for a full bounded Channel
+  if (id == 0) {
+    lovrVariantDestroy(&variant);
+  }
+
   lua_pushnumber(L, id);
   lua_pushboolean(L, read);
   return 2;
@@ -45,6 +51,50 @@ static int l_lovrChannelPop(lua_State* L) {
   return 1;
 }
 
+#define MAX_CHANNEL_BATCH 65536
+
+static int l_lovrChannelPushMany(lua_State* L) {
+  double timeout;
+  Channel* channel = luax_checktype(L, 1, Channel);
+  luaL_checktype(L, 2, LUA_TTABLE);
+  luax_checktimeout(L, 3, &timeout);
+  uint32_t count = luax_len(L, 2);
+  lovrAssert(count <= MAX_CHANNEL_BATCH, "Channel batch size must be at most %d", MAX_CHANNEL_BATCH);
+  VariantBatch* batch = luax_newvariantbatch(L, count);
+  for (uint32_t i = 0; i < count; i++) {
+    lua_rawgeti(L, 2, i + 1);
+    luax_checkvariant(L, -1, &batch->variants[i]);
+    batch->count++;
+    lua_pop(L, 1);
+  }
+  uint64_t id;
+  uint32_t pushed = lovrChannelPushMany(channel, batch->variants, count, timeout, &id);
+  batch->start = pushed;
+  luax_destroyvariantbatch(batch);
+  lua_pushnumber(L, id);
+  lua_pushinteger(L, pushed);
+  return 2;
+}
+
+static int l_lovrChannelPopMany(lua_State* L) {
+  double timeout;
+  Channel* channel = luax_checktype(L, 1, Channel);
+  lua_Integer count = luaL_checkinteger(L, 2);
+  lovrAssert(count > 0 && count <= MAX_CHANNEL_BATCH, "Channel batch size must be between 1 and %d", MAX_CHANNEL_BATCH);
+  luax_checktimeout(L, 3, &timeout);
+  lua_settop(L, 3);
+  VariantBatch* batch = luax_newvariantbatch(L, (uint32_t) count);
+  batch->count = lovrChannelPopMany(channel, batch->variants, (uint32_t) count, timeout);
+  lua_createtable(L, batch->count, 0);
+  while (batch->start < batch->count) {
+    luax_pushvariant(L, &batch->variants[batch->start]);
+    lovrVariantDestroy(&batch->variants[batch->start++]);
+    lua_rawseti(L, -2, batch->start);
+  }
+  lua_pushinteger(L, batch->count);
+  return 2;
+}
+
 static int l_lovrChannelPeek(lua_State* L) {
   Variant variant;
   Channel* channel = luax_checktype(L, 1, Channel);
@@ -74,12 +124,33 @@ static int l_lovrChannelHasRead(lua_State* L) {
   return 1;
 }
 
+static int l_lovrChannelGetCapacity(lua_State* L) {
+  Channel* channel = luax_checktype(L, 1, Channel);
+  uint32_t capacity = lovrChannelGetCapacity(channel);
+  if (capacity > 0) {
+    lua_pushinteger(L, capacity);
+  } else {
+    lua_pushnil(L);
+  }
+  return 1;
+}
+
+static int l_lovrChannelGetHighWaterMark(lua_State* L) {
+  Channel* channel = luax_checktype(L, 1, Channel);
+  lua_pushnumber(L, (double) lovrChannelGetHighWater(channel));
+  return 1;
+}
+
 const luaL_Reg lovrChannel[] = {
   { "push", l_lovrChannelPush },
   { "pop", l_lovrChannelPop },
+  { "pushMany", l_lovrChannelPushMany },
+  { "popMany", l_lovrChannelPopMany },
   { "peek", l_lovrChannelPeek },
   { "clear", l_lovrChannelClear },
   { "getCount", l_lovrChannelGetCount },
   { "hasRead", l_lovrChannelHasRead },
+  { "getCapacity", l_lovrChannelGetCapacity },
+  { "getHighWaterMark", l_lovrChannelGetHighWaterMark },
   { NULL, NULL }
 };
@@ -3,6 +3,7 @@
 #include "data/blob.h"
 #include "data/modelData.h"
 #include "data/rasterizer.h"
+#include "data/sharedBuffer.h"
 #include "data/soundData.h"
 #include "data/textureData.h"
 #include "core/ref.h"
@@ -26,10 +27,11 @@ static int l_lovrDataNewBlob(lua_State* L) {
     memcpy(data, str, size);
     data[size] = '\0';
   } else {
-    Blob* blob = luax_checktype(L, 1, Blob);
+    Blob* blob = luax_checkblob(L, 1);
     size = blob->size;
     data = malloc(size);
     lovrAssert(data, "Out of memory");
+    memcpy(data, blob->data, size);
   }
   const char* name = luaL_optstring(L, 2, "");
   Blob* blob = lovrBlobCreate(data, size, name);
@@ -38,6 +40,21 @@ static int l_lovrDataNewBlob(lua_State* L) {
   return 1;
 }
 
+// Sizes are in bytes, or in elements when a view type is given
+static int l_lovrDataNewSharedBuffer(lua_State* L) {
+  lua_Integer count = luaL_checkinteger(L, 1);
+  lovrAssert(count > 0, "SharedBuffer size must be positive");
+  size_t size = (size_t) count;
+  if (!lua_isnoneornil(L, 2)) {
+    ViewType type = luaL_checkoption(L, 2, NULL, ViewTypes);
+    size *= type == VIEW_U8 ? sizeof(uint8_t) : sizeof(int32_t);
+  }
+  SharedBuffer* buffer = lovrSharedBufferCreate(size);
+  luax_pushtype(L, SharedBuffer, buffer);
+  lovrRelease(SharedBuffer, buffer);
+  return 1;
+}
+
 static int l_lovrDataNewAudioStream(lua_State* L) {
   Blob* blob = luax_readblob(L, 1, "AudioStream");
   int bufferSize = luaL_optinteger(L, 2, 4096);
@@ -96,7 +113,8 @@ static int l_lovrDataNewSoundData(lua_State* L) {
   }
 
   Blob* blob = luax_readblob(L, 1, "SoundData");
-  SoundData* soundData = lovrSoundDataCreateFromBlob(blob);
+  bool decode = lua_isnoneornil(L, 2) || lua_toboolean(L, 2);
+  SoundData* soundData = lovrSoundDataCreateFromBlob(blob, decode);
   luax_pushtype(L, SoundData, soundData);
   lovrRelease(Blob, blob);
   lovrRelease(SoundData, soundData);
@@ -109,7 +127,12 @@ static int l_lovrDataNewTextureData(lua_State* L) {
     int width = luaL_checkinteger(L, 1);
     int height = luaL_checkinteger(L, 2);
     TextureFormat format = luaL_checkoption(L, 3, "rgba", TextureFormats);
-    textureData = lovrTextureDataCreate(width, height, 0x0, format);
+    if (lua_isnoneornil(L, 4)) {
+      textureData = lovrTextureDataCreate(width, height, 0x0, format);
+    } else {
+      Blob* pixels = luax_checkblob(L, 4);
+      textureData = lovrTextureDataCreateFromPixels(width, height, format, pixels);
+    }
   } else {
     Blob* blob = luax_readblob(L, 1, "Texture");
     bool flip = lua_isnoneornil(L, 2) ? true : lua_toboolean(L, 2);
@@ -124,6 +147,7 @@ static int l_lovrDataNewTextureData(lua_State* L) {
 
 static const luaL_Reg lovrData[] = {
   { "newBlob", l_lovrDataNewBlob },
+  { "newSharedBuffer", l_lovrDataNewSharedBuffer },
   { "newAudioStream", l_lovrDataNewAudioStream },
   { "newModelData", l_lovrDataNewModelData },
   { "newRasterizer", l_lovrDataNewRasterizer },
@@ -139,6 +163,7 @@ int luaopen_lovr_data(lua_State* L) {
   luax_registertype(L, AudioStream);
   luax_registertype(L, ModelData);
   luax_registertype(L, Rasterizer);
+  luax_registertype(L, SharedBuffer);
   luax_registertype(L, SoundData);
   luax_registertype(L, TextureData);
   return 1;
@@ -2,6 +2,7 @@
 #include "util.h"
 #include "event/event.h"
 #include "thread/thread.h"
+#include "core/arr.h"
 #include "core/platform.h"
 #include "core/ref.h"
 #include <stdlib.h>
@@ -17,8 +18,190 @@ const char* EventTypes[] = {
 
 static LOVR_THREAD_LOCAL int pollRef;
 
+// poll drains every queued event into a batch up front, so the queue is touched once per frame.
+// Events pushed while iterating show up on the next poll.
+#define EVENT_DRAIN_SIZE 64
+
+static struct {
+  arr_t(Event) events;
+  size_t head;
+} batch;
+
+// Any thread can push events, but only the thread that set up the module consumes them
+static LOVR_THREAD_LOCAL bool consumer;
+
+// Packed values are a tag byte followed by a payload.  Tables are a list of keys and values ending
+// with PACK_END.  Numbers and lengths are unaligned and in native byte order, since packed values
+// never leave the process.
+enum {
+  PACK_END,
+  PACK_NIL,
+  PACK_FALSE,
+  PACK_TRUE,
+  PACK_NUMBER,
+  PACK_STRING,
+  PACK_TABLE,
+  PACK_VECTOR
+};
+
+// Also catches tables that contain themselves
+#define MAX_PACK_DEPTH 32
+
+typedef arr_t(char) arr_char_t;
+
+#ifdef LOVR_ENABLE_MATH
+static const uint8_t vectorComponents[] = {
+  [V_VEC2] = 2,
+  [V_VEC3] = 4,
+  [V_VEC4] = 4,
+  [V_QUAT] = 4,
+  [V_MAT4] = 16
+};
+#endif
+
+static void packValue(lua_State* L, int index, arr_char_t* buffer, int depth) {
+  int type = lua_type(L, index);
+  switch (type) {
+    case LUA_TNIL:
+      arr_push(buffer, PACK_NIL);
+      return;
+
+    case LUA_TBOOLEAN:
+      arr_push(buffer, lua_toboolean(L, index) ? PACK_TRUE : PACK_FALSE);
+      return;
+
+    case LUA_TNUMBER: {
+      double number = lua_tonumber(L, index);
+      arr_push(buffer, PACK_NUMBER);
+      arr_append(buffer, (char*) &number, sizeof(number));
+      return;
+    }
+
+    case LUA_TSTRING: {
+      size_t length;
+      const char* string = lua_tolstring(L, index, &length);
+      uint32_t length32 = (uint32_t) length;
+      arr_push(buffer, PACK_STRING);
+      arr_append(buffer, (char*) &length32, sizeof(length32));
+      arr_append(buffer, string, length);
+      return;
+    }
+
+    case LUA_TTABLE:
+      if (depth >= MAX_PACK_DEPTH || !lua_checkstack(L, 3)) {
+        arr_free(buffer);
+        lovrThrow("Table is nested too deeply to send to another thread");
+      }
+
+      index = index < 0 ? lua_gettop(L) + index + 1 : index;
+      arr_push(buffer, PACK_TABLE);
+      lua_pushnil(L);
+      while (lua_next(L, index)) {
+        packValue(L, -2, buffer, depth + 1);
+        packValue(L, -1, buffer, depth + 1);
+        lua_pop(L, 1);
+      }
+      arr_push(buffer, PACK_END);
+      return;
+
+#ifdef LOVR_ENABLE_MATH
+    case LUA_TUSERDATA:
+    case LUA_TLIGHTUSERDATA: {
+      VectorType vectorType;
+      float* vector = luax_tovector(L, index, &vectorType);
+      if (vector) {
+        arr_push(buffer, PACK_VECTOR);
+        arr_push(buffer, (char) vectorType);
+        arr_append(buffer, (char*) vector, vectorComponents[vectorType] * sizeof(float));
+        return;
+      }
+      break;
+    }
+#endif
+
+    default: break;
+  }
+
+  arr_free(buffer);
+  lovrThrow("Can't send a %s to another thread inside of a table", lua_typename(L, type));
+}
+
+// Vectors come back as permanent vectors, since temporary ones belong to the thread that made them
+static const char* unpackValue(lua_State* L, const char* data) {
+  switch (*data++) {
+    case PACK_NIL:
+      lua_pushnil(L);
+      return data;
+
+    case PACK_FALSE:
+    case PACK_TRUE:
+      lua_pushboolean(L, data[-1] == PACK_TRUE);
+      return data;
+
+    case PACK_NUMBER: {
+      double number;
+      memcpy(&number, data, sizeof(number));
+      lua_pushnumber(L, number);
+      return data + sizeof(number);
+    }
+
+    case PACK_STRING: {
+      uint32_t length;
+      memcpy(&length, data, sizeof(length));
+      data += sizeof(length);
+      lua_pushlstring(L, data, length);
+      return data + length;
+    }
+
+    case PACK_TABLE:
+      luaL_checkstack(L, 3, NULL);
+      lua_newtable(L);
+      while (*data != PACK_END) {
+        data = unpackValue(L, data);
+        data = unpackValue(L, data);
+        lua_rawset(L, -3);
+      }
+      return data + 1;
+
+#ifdef LOVR_ENABLE_MATH
+    case PACK_VECTOR: {
+      VectorType type = (VectorType) *data++;
+      size_t size = vectorComponents[type] * sizeof(float);
+      float* vector = luax_newvector(L, type, vectorComponents[type]);
+      memcpy(vector, data, size);
+      return data + size;
+    }
+#endif
+
+    default:
+      lovrThrow("Unreachable");
+      return NULL;
+  }
+}
+
+static bool isVector(lua_State* L, int index) {
+#ifdef LOVR_ENABLE_MATH
+  VectorType type;
+  return luax_tovector(L, index, &type) != NULL;
+#else
+  return false;
+#endif
+}
+
 void luax_checkvariant(lua_State* L, int index, Variant* variant) {
   int type = lua_type(L, index);
+
+  if (type == LUA_TTABLE || ((type == LUA_TUSERDATA || type == LUA_TLIGHTUSERDATA) && isVector(L, index))) {
+    arr_char_t buffer;
+    arr_init(&buffer);
+    arr_reserve(&buffer, 256);
+    packValue(L, index, &buffer, 0);
+    variant->type = TYPE_PACKED;
+    variant->value.packed.data = buffer.data;
+    variant->value.packed.size = buffer.length;
+    return;
+  }
+
   switch (type) {
     case LUA_TNIL:
       variant->type = TYPE_NIL;
@@ -38,10 +221,11 @@ void luax_checkvariant(lua_State* L, int index, Variant* variant) {
       variant->type = TYPE_STRING;
       size_t length;
       const char* string = lua_tolstring(L, index, &length);
-      variant->value.string = malloc(length + 1);
-      lovrAssert(variant->value.string, "Out of memory");
-      memcpy(variant->value.string, string, length);
-      variant->value.string[length] = '\0';
+      variant->value.string.pointer = malloc(length + 1);
+      lovrAssert(variant->value.string.pointer, "Out of memory");
+      memcpy(variant->value.string.pointer, string, length);
+      variant->value.string.pointer[length] = '\0';
+      variant->value.string.length = length;
       break;
 
     case LUA_TUSERDATA:
@@ -75,19 +259,45 @@ int luax_pushvariant(lua_State* L, Variant* variant) {
     case TYPE_NIL: lua_pushnil(L); return 1;
     case TYPE_BOOLEAN: lua_pushboolean(L, variant->value.boolean); return 1;
     case TYPE_NUMBER: lua_pushnumber(L, variant->value.number); return 1;
-    case TYPE_STRING: lua_pushstring(L, variant->value.string); return 1;
+    case TYPE_STRING: lua_pushlstring(L, variant->value.string.pointer, variant->value.string.length); return 1;
     case TYPE_OBJECT: _luax_pushtype(L, variant->value.object.type, hash64(variant->value.object.type, strlen(variant->value.object.type)), variant->value.object.pointer); return 1;
+    case TYPE_PACKED: unpackValue(L, variant->value.packed.data); return 1;
     default: return 0;
   }
 }
 
-static int nextEvent(lua_State* L) {
-  Event event;
+void luax_destroyvariantbatch(VariantBatch* batch) {
+  for (uint32_t i = batch->start; i < batch->count; i++) {
+    lovrVariantDestroy(&batch->variants[i]);
+  }
+  batch->start = batch->count = 0;
+}
 
-  if (!lovrEventPoll(&event)) {
+static int l_lovrVariantBatch__gc(lua_State* L) {
+  luax_destroyvariantbatch(lua_touserdata(L, 1));
+  return 0;
+}
+
+// The Variants are stored right after the header, in the same userdata
+VariantBatch* luax_newvariantbatch(lua_State* L, uint32_t count) {
+  VariantBatch* batch = lua_newuserdata(L, sizeof(VariantBatch) + count * sizeof(Variant));
+  batch->start = batch->count = 0;
+  batch->variants = (Variant*) (batch + 1);
+  if (luaL_newmetatable(L, "VariantBatch")) {
+    lua_pushcfunction(L, l_lovrVariantBatch__gc);
+    lua_setfield(L, -2, "__gc");
+  }
+  lua_setmetatable(L, -2);
+  return batch;
+}
+
+static int nextEvent(lua_State* L) {
+  if (batch.head == batch.events.length) {
     return 0;
   }
 
+  Event event = batch.events.data[batch.head++];
+
   if (event.type == EVENT_CUSTOM) {
     lua_pushstring(L, event.data.custom.name);
   } else {
@@ -141,11 +351,31 @@ static void hotkeyHandler(KeyCode key, ButtonAction action) {
 }
 
 static int l_lovrEventClear(lua_State* L) {
+  lovrAssert(consumer, "Events can only be cleared on the main thread");
+  for (size_t i = batch.head; i < batch.events.length; i++) {
+    lovrEventDiscard(&batch.events.data[i]);
+  }
+  arr_clear(&batch.events);
+  batch.head = 0;
   lovrEventClear();
   return 0;
 }
 
+// Events left over from a loop that stopped early are kept in front of the new ones
 static int l_lovrEventPoll(lua_State* L) {
+  lovrAssert(consumer, "Events can only be polled on the main thread");
+  if (batch.head > 0) {
+    arr_splice(&batch.events, 0, batch.head);
+    batch.head = 0;
+  }
+
+  uint32_t count;
+  do {
+    arr_reserve(&batch.events, batch.events.length + EVENT_DRAIN_SIZE);
+    count = lovrEventDrain(batch.events.data + batch.events.length, EVENT_DRAIN_SIZE);
+    batch.events.length += count;
+  } while (count == EVENT_DRAIN_SIZE);
+
   lua_rawgeti(L, LUA_REGISTRYINDEX, pollRef);
   return 1;
 }
@@ -188,6 +418,16 @@ static int l_lovrEventQuit(lua_State* L) {
   return 0;
 }
 
+static void destroyModule() {
+  for (size_t i = batch.head; i < batch.events.length; i++) {
+    lovrEventDiscard(&batch.events.data[i]);
+  }
+  arr_free(&batch.events);
+  batch.head = 0;
+  consumer = false;
+  lovrEventDestroy();
+}
+
 static const luaL_Reg lovrEvent[] = {
   { "clear", l_lovrEventClear },
   { "poll", l_lovrEventPoll },
@@ -205,15 +445,19 @@ int luaopen_lovr_event(lua_State* L) {
   lua_pushcfunction(L, nextEvent);
   pollRef = luaL_ref(L, LUA_REGISTRYINDEX);
 
+  // Threads can require the module to push events, only the main thread sets it up
   if (lovrEventInit()) {
-    luax_atexit(L, lovrEventDestroy);
+    arr_init(&batch.events);
+    consumer = true;
+    luax_atexit(L, destroyModule);
+
+    luax_pushconf(L);
+    lua_getfield(L, -1, "hotkeys");
+    if (lua_toboolean(L, -1)) {
+      lovrPlatformOnKeyboardEvent(hotkeyHandler);
+    }
+    lua_pop(L, 2);
   }
 
-  luax_pushconf(L);
-  lua_getfield(L, -1, "hotkeys");
-  if (lua_toboolean(L, -1)) {
-    lovrPlatformOnKeyboardEvent(hotkeyHandler);
-  }
-  lua_pop(L, 2);
   return 1;
 }
@@ -10,7 +10,7 @@
 // Returns a Blob, leaving stack unchanged.  The Blob must be released when finished.
 Blob* luax_readblob(lua_State* L, int index, const char* debug) {
   if (lua_type(L, index) == LUA_TUSERDATA) {
-    Blob* blob = luax_checktype(L, index, Blob);
+    Blob* blob = luax_checkblob(L, index);
     lovrRetain(blob);
     return blob;
   } else {
@@ -299,6 +299,16 @@ static void stencilCallback(void* userdata) {
   lua_call(L, 0, 0);
 }
 
+static int memoryBudgetRef = LUA_NOREF;
+
+static void memoryBudgetCallback(void* userdata, size_t memory, size_t budget) {
+  lua_State* L = userdata;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, memoryBudgetRef);
+  lua_pushinteger(L, memory);
+  lua_pushinteger(L, budget);
+  lua_call(L, 2, 0);
+}
+
 // Must be released when done
 static TextureData* luax_checktexturedata(lua_State* L, int index, bool flip) {
   TextureData* textureData = luax_totype(L, index, TextureData);
@@ -455,7 +465,7 @@ static int l_lovrGraphicsGetStats(lua_State* L) {
     luaL_checktype(L, 1, LUA_TTABLE);
     lua_settop(L, 1);
   } else {
-    lua_createtable(L, 0, 2);
+    lua_createtable(L, 0, 9);
   }
 
   lovrGraphicsFlush();
@@ -464,9 +474,58 @@ static int l_lovrGraphicsGetStats(lua_State* L) {
   lua_setfield(L, 1, "drawcalls");
   lua_pushinteger(L, stats->shaderSwitches);
   lua_setfield(L, 1, "shaderswitches");
+  lua_pushinteger(L, stats->memory);
+  lua_setfield(L, 1, "memory");
+  lua_pushinteger(L, stats->typeMemory[MEMORY_TEXTURE]);
+  lua_setfield(L, 1, "texturememory");
+  lua_pushinteger(L, stats->typeMemory[MEMORY_BUFFER]);
+  lua_setfield(L, 1, "buffermemory");
+  lua_pushinteger(L, stats->typeMemory[MEMORY_CANVAS]);
+  lua_setfield(L, 1, "canvasmemory");
+  lua_pushinteger(L, stats->typeCount[MEMORY_TEXTURE]);
+  lua_setfield(L, 1, "textures");
+  lua_pushinteger(L, stats->typeCount[MEMORY_BUFFER]);
+  lua_setfield(L, 1, "buffers");
+  lua_pushinteger(L, stats->typeCount[MEMORY_CANVAS]);
+  lua_setfield(L, 1, "canvases");
+  return 1;
+}
+
+static int l_lovrGraphicsGetMemoryBudget(lua_State* L) {
+  size_t budget = lovrGraphicsGetMemoryBudget();
+  if (budget == 0) {
+    lua_pushnil(L);
+  } else {
+    lua_pushinteger(L, budget);
+  }
   return 1;
 }
 
+static int l_lovrGraphicsSetMemoryBudget(lua_State* L) {
+  size_t budget = lua_isnoneornil(L, 1) ? 0 : (size_t) luaL_checkinteger(L, 1);
+  bool hasCallback = !lua_isnoneornil(L, 2);
+  if (hasCallback) {
+    luaL_checktype(L, 2, LUA_TFUNCTION);
+  }
+
+  if (memoryBudgetRef != LUA_NOREF) {
+    luaL_unref(L, LUA_REGISTRYINDEX, memoryBudgetRef);
+    memoryBudgetRef = LUA_NOREF;
+  }
+
+  if (hasCallback) {
+    lua_settop(L, 2);
+    memoryBudgetRef = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    lovrGraphicsSetMemoryBudget(budget, memoryBudgetCallback, lua_tothread(L, -1));
+    lua_pop(L, 1);
+  } else {
+    lovrGraphicsSetMemoryBudget(budget, NULL, NULL);
+  }
+
+  return 0;
+}
+
 // State
 
 static int l_lovrGraphicsReset(lua_State* L) {
@@ -1463,9 +1522,9 @@ static int l_lovrGraphicsNewShader(lua_State* L) {
 
     // Builtin uniforms
     if (shaderType == SHADER_STANDARD) {
-      lovrShaderSetFloats(shader, "lovrExposure", (float[1]) { 1.f }, 0, 1);
-      lovrShaderSetFloats(shader, "lovrLightDirection", (float[3]) { -1.f, -1.f, -1.f }, 0, 3);
-      lovrShaderSetFloats(shader, "lovrLightColor", (float[4]) { 1.f, 1.f, 1.f, 1.f }, 0, 4);
+      lovrShaderSetFloats(shader, &(istr_t) { .string = "lovrExposure" }, (float[1]) { 1.f }, 0, 1);
+      lovrShaderSetFloats(shader, &(istr_t) { .string = "lovrLightDirection" }, (float[3]) { -1.f, -1.f, -1.f }, 0, 3);
+      lovrShaderSetFloats(shader, &(istr_t) { .string = "lovrLightColor" }, (float[4]) { 1.f, 1.f, 1.f, 1.f }, 0, 4);
     }
   } else {
     luax_readshadersource(L, 1);
@@ -1611,6 +1670,8 @@ static const luaL_Reg lovrGraphics[] = {
   { "getFeatures", l_lovrGraphicsGetFeatures },
   { "getLimits", l_lovrGraphicsGetLimits },
   { "getStats", l_lovrGraphicsGetStats },
+  { "getMemoryBudget", l_lovrGraphicsGetMemoryBudget },
+  { "setMemoryBudget", l_lovrGraphicsSetMemoryBudget },
 
   // State
   { "reset", l_lovrGraphicsReset },
@@ -1701,6 +1762,7 @@ int luaopen_lovr_graphics(lua_State* L) {
   luax_registertype(L, ShaderBlock);
   luax_registertype(L, Texture);
   lovrGraphicsInit();
+  memoryBudgetRef = LUA_NOREF;
 
   luax_pushconf(L);
   lua_pushcfunction(L, l_lovrGraphicsCreateWindow);
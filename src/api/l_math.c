@@ -6,6 +6,9 @@
 #include "core/maf.h"
 #include "core/ref.h"
 #include "core/util.h"
+#ifdef LOVR_ENABLE_DATA
+#include "data/blob.h"
+#endif
 #include <stdlib.h>
 
 int l_lovrRandomGeneratorRandom(lua_State* L);
@@ -18,6 +21,8 @@ int l_lovrVec4Set(lua_State* L);
 int l_lovrQuatSet(lua_State* L);
 int l_lovrMat4Set(lua_State* L);
 
+// Each Lua state owns a Pool, kept in its registry.  Temporary vectors resolve against the Pool
+// bound to the current thread, so running a different state on a thread has to rebind it.
 static LOVR_THREAD_LOCAL Pool* pool;
 
 static const luaL_Reg* lovrVectorMetatables[] = {
@@ -44,8 +49,29 @@ static const char* lovrVectorTypeNames[] = {
   [V_MAT4] = "mat4"
 };
 
-static void luax_destroypool(void) {
-  lovrRelease(Pool, pool);
+static int luax_destroypool(lua_State* L) {
+  Pool** p = lua_touserdata(L, 1);
+  if (pool == *p) {
+    pool = NULL;
+  }
+  lovrRelease(Pool, *p);
+  *p = NULL;
+  return 0;
+}
+
+// Binds the Pool of a state to this thread (or nothing, if it hasn't loaded lovr.math), returning
+// the previous binding so it can be restored with luax_unbindvectors
+void* luax_bindvectors(lua_State* L) {
+  Pool* previous = pool;
+  lua_getfield(L, LUA_REGISTRYINDEX, "_lovrpool");
+  Pool** p = lua_touserdata(L, -1);
+  pool = p ? *p : NULL;
+  lua_pop(L, 1);
+  return previous;
+}
+
+void luax_unbindvectors(void* previous) {
+  pool = previous;
 }
 
 float* luax_tovector(lua_State* L, int index, VectorType* type) {
@@ -78,7 +104,7 @@ float* luax_checkvector(lua_State* L, int index, VectorType type, const char* ex
   return p;
 }
 
-static float* luax_newvector(lua_State* L, VectorType type, size_t components) {
+float* luax_newvector(lua_State* L, VectorType type, size_t components) {
   VectorType* p = lua_newuserdata(L, sizeof(VectorType) + components * sizeof(float));
   *p = type;
   lua_rawgeti(L, LUA_REGISTRYINDEX, lovrVectorMetatableRefs[type]);
@@ -266,11 +292,99 @@ static int l_lovrMathMat4(lua_State* L) {
   return l_lovrMat4Set(L);
 }
 
+#ifdef LOVR_ENABLE_DATA
+// Batch functions take Blobs (or SharedBuffers) of tightly packed floats and write to an optional
+// output Blob, which defaults to the input
+static Blob* luax_checkbatch(lua_State* L, int index, int outputIndex, size_t stride, uint32_t* count, Blob** output) {
+  Blob* blob = luax_checkblob(L, index);
+  *count = (uint32_t) (blob->size / stride);
+  *output = lua_isnoneornil(L, outputIndex) ? blob : luax_checkblob(L, outputIndex);
+  lovrAssert((*output)->size >= *count * stride, "Output Blob is too small (%zu bytes, need %zu)", (*output)->size, *count * stride);
+  return blob;
+}
+
+static int l_lovrMathTransformPoints(lua_State* L) {
+  float* transform = luax_checkvector(L, 1, V_MAT4, NULL);
+  uint32_t count;
+  Blob* output;
+  Blob* points = luax_checkbatch(L, 2, 3, 3 * sizeof(float), &count, &output);
+  lovrMathTransformPoints(transform, points->data, output->data, count);
+  return 0;
+}
+
+static int l_lovrMathNormalizeVectors(lua_State* L) {
+  uint32_t count;
+  Blob* output;
+  Blob* vectors = luax_checkbatch(L, 1, 2, 3 * sizeof(float), &count, &output);
+  lovrMathNormalizeVectors(vectors->data, output->data, count);
+  return 0;
+}
+
+static int l_lovrMathSlerpQuaternions(lua_State* L) {
+  uint32_t count;
+  Blob* output;
+  Blob* a = luax_checkbatch(L, 1, 4, 4 * sizeof(float), &count, &output);
+  Blob* b = luax_checkblob(L, 2);
+  float t = luax_checkfloat(L, 3);
+  lovrAssert(b->size >= count * 4 * sizeof(float), "Quaternion Blobs must be the same size");
+  lovrMathSlerpQuaternions(a->data, b->data, t, output->data, count);
+  return 0;
+}
+
+static int l_lovrMathMultiplyMatrices(lua_State* L) {
+  float* transform = luax_checkvector(L, 1, V_MAT4, NULL);
+  uint32_t count;
+  Blob* output;
+  Blob* matrices = luax_checkbatch(L, 2, 3, 16 * sizeof(float), &count, &output);
+  lovrMathMultiplyMatrices(transform, matrices->data, output->data, count);
+  return 0;
+}
+
+static int l_lovrMathGetBoundingBox(lua_State* L) {
+  Blob* points = luax_checkblob(L, 1);
+  float aabb[6];
+  lovrMathGetBoundingBox(points->data, (uint32_t) (points->size / (3 * sizeof(float))), aabb);
+  for (int i = 0; i < 6; i++) {
+    lua_pushnumber(L, aabb[i]);
+  }
+  return 6;
+}
+#endif
+
+// Threads drain their pool after each run, job workers after each job, and the main thread once per
+// frame in boot.lua
+void luax_drainvectors(void) {
+  if (pool) {
+    lovrPoolDrain(pool);
+  }
+}
+
 static int l_lovrMathDrain(lua_State* L) {
   lovrPoolDrain(pool);
   return 0;
 }
 
+static int l_lovrMathGetPoolStats(lua_State* L) {
+  if (lua_gettop(L) > 0) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_settop(L, 1);
+  } else {
+    lua_createtable(L, 0, 4);
+  }
+
+  PoolStats stats;
+  lovrPoolGetStats(pool, &stats);
+  lua_pushinteger(L, stats.used);
+  lua_setfield(L, 1, "used");
+  lua_pushinteger(L, stats.peak);
+  lua_setfield(L, 1, "peak");
+  lua_pushinteger(L, stats.capacity);
+  lua_setfield(L, 1, "capacity");
+  lua_pushinteger(L, stats.segments);
+  lua_setfield(L, 1, "segments");
+  return 1;
+}
+
 static const luaL_Reg lovrMath[] = {
   { "newCurve", l_lovrMathNewCurve },
   { "newRandomGenerator", l_lovrMathNewRandomGenerator },
@@ -292,6 +406,14 @@ static const luaL_Reg lovrMath[] = {
   { "quat", l_lovrMathQuat },
   { "mat4", l_lovrMathMat4 },
   { "drain", l_lovrMathDrain },
+  { "getPoolStats", l_lovrMathGetPoolStats },
+#ifdef LOVR_ENABLE_DATA
+  { "transformPoints", l_lovrMathTransformPoints },
+  { "normalizeVectors", l_lovrMathNormalizeVectors },
+  { "slerpQuaternions", l_lovrMathSlerpQuaternions },
+  { "multiplyMatrices", l_lovrMathMultiplyMatrices },
+  { "getBoundingBox", l_lovrMathGetBoundingBox },
+#endif
   { NULL, NULL }
 };
 
@@ -376,9 +498,14 @@ int luaopen_lovr_math(lua_State* L) {
     luax_atexit(L, lovrMathDestroy);
   }
 
-  // Each Lua state gets its own thread-local Pool
-  pool = lovrPoolCreate();
-  luax_atexit(L, luax_destroypool);
+  // Each state gets its own Pool, segments are only allocated once it makes a temporary vector
+  Pool** p = lua_newuserdata(L, sizeof(Pool*));
+  *p = pool = lovrPoolCreate();
+  lua_createtable(L, 0, 1);
+  lua_pushcfunction(L, luax_destroypool);
+  lua_setfield(L, -2, "__gc");
+  lua_setmetatable(L, -2);
+  lua_setfield(L, LUA_REGISTRYINDEX, "_lovrpool");
 
   // Globals
   luax_pushconf(L);
@@ -269,9 +269,28 @@ static int l_lovrMeshSetVertexAttribute(lua_State* L) {
   return 0;
 }
 
+// Blobs and SharedBuffers are copied straight into the vertex buffer, they should already be laid
+// out in the Mesh's vertex format
 static int l_lovrMeshSetVertices(lua_State* L) {
   Mesh* mesh = luax_checktype(L, 1, Mesh);
   uint32_t capacity = lovrMeshGetVertexCount(mesh);
+
+  if (lua_type(L, 2) == LUA_TUSERDATA) {
+    Blob* blob = luax_checkblob(L, 2);
+    if (!mesh->vertexBuffer || mesh->attributeCount == 0 || mesh->attributes[0].buffer != mesh->vertexBuffer) {
+      lovrThrow("Mesh does not have a vertex buffer");
+    }
+    size_t stride = mesh->attributes[0].stride;
+    uint32_t start = luaL_optinteger(L, 3, 1) - 1;
+    uint32_t count = luaL_optinteger(L, 4, (lua_Integer) (blob->size / stride));
+    lovrAssert(start + count <= capacity, "Overflow in Mesh:setVertices: Mesh can only hold %d vertices", capacity);
+    lovrAssert(count * stride <= blob->size, "Cannot set %d vertices on Mesh: Blob only has %zu bytes", count, blob->size);
+    void* data = lovrBufferMap(mesh->vertexBuffer, start * stride);
+    memcpy(data, blob->data, count * stride);
+    lovrBufferFlush(mesh->vertexBuffer, start * stride, count * stride);
+    return 0;
+  }
+
   luaL_checktype(L, 2, LUA_TTABLE);
   uint32_t sourceSize = luax_len(L, 2);
   uint32_t start = luaL_optinteger(L, 3, 1) - 1;
@@ -336,7 +355,7 @@ static int l_lovrMeshGetVertexMap(lua_State* L) {
   if (lua_istable(L, 2)) {
     lua_settop(L, 2);
   } else if (lua_isuserdata(L, 2)) {
-    Blob* blob = luax_checktype(L, 2, Blob);
+    Blob* blob = luax_checkblob(L, 2);
     lovrAssert(size * count <= blob->size, "Mesh vertex map is %zu bytes, but Blob can only hold %zu", size * count, blob->size);
     memcpy(blob->data, indices.raw, size * count);
     return 0;
@@ -363,7 +382,7 @@ static int l_lovrMeshSetVertexMap(lua_State* L) {
   }
 
   if (lua_type(L, 2) == LUA_TUSERDATA) {
-    Blob* blob = luax_checktype(L, 2, Blob);
+    Blob* blob = luax_checkblob(L, 2);
     size_t size = luaL_optinteger(L, 3, 4);
     lovrAssert(size == 2 || size == 4, "Size of Mesh indices should be 2 bytes or 4 bytes");
     lovrAssert(blob->size / size < UINT32_MAX, "Too many Mesh indices");
@@ -1,12 +1,31 @@
 #include "api.h"
 #include "physics/physics.h"
+#include "data/blob.h"
+#include "data/modelData.h"
 #include "core/ref.h"
 
+const char* BroadphaseTypes[] = {
+  [BROADPHASE_HASH] = "hash",
+  [BROADPHASE_SAP] = "sap",
+  [BROADPHASE_QUADTREE] = "quadtree",
+  [BROADPHASE_SIMPLE] = "simple",
+  NULL
+};
+
+const char* ContactEventTypes[] = {
+  [CONTACT_BEGIN] = "begin",
+  [CONTACT_PERSIST] = "persist",
+  [CONTACT_END] = "end",
+  NULL
+};
+
 const char* ShapeTypes[] = {
   [SHAPE_SPHERE] = "sphere",
   [SHAPE_BOX] = "box",
   [SHAPE_CAPSULE] = "capsule",
   [SHAPE_CYLINDER] = "cylinder",
+  [SHAPE_MESH] = "mesh",
+  [SHAPE_TERRAIN] = "terrain",
   NULL
 };
 
@@ -23,10 +42,11 @@ static int l_lovrPhysicsNewWorld(lua_State* L) {
   float yg = luax_optfloat(L, 2, -9.81f);
   float zg = luax_optfloat(L, 3, 0.f);
   bool allowSleep = lua_gettop(L) < 4 || lua_toboolean(L, 4);
-  const char* tags[16];
+  const char* tags[MAX_TAGS];
   int tagCount;
   if (lua_type(L, 5) == LUA_TTABLE) {
     tagCount = luax_len(L, 5);
+    lovrAssert(tagCount <= MAX_TAGS, "Worlds can only have %d tags", MAX_TAGS);
     for (int i = 0; i < tagCount; i++) {
       lua_rawgeti(L, -1, i + 1);
       if (lua_isstring(L, -1)) {
@@ -39,7 +59,8 @@ static int l_lovrPhysicsNewWorld(lua_State* L) {
   } else {
     tagCount = 0;
   }
-  World* world = lovrWorldCreate(xg, yg, zg, allowSleep, tags, tagCount);
+  BroadphaseType broadphase = luaL_checkoption(L, 6, "hash", BroadphaseTypes);
+  World* world = lovrWorldCreate(xg, yg, zg, allowSleep, tags, tagCount, broadphase);
   luax_pushtype(L, World, world);
   lovrRelease(World, world);
   return 1;
@@ -115,6 +136,14 @@ static int l_lovrPhysicsNewHingeJoint(lua_State* L) {
   return 1;
 }
 
+static int l_lovrPhysicsNewMeshShape(lua_State* L) {
+  ModelData* modelData = luax_checktype(L, 1, ModelData);
+  MeshShape* mesh = lovrMeshShapeCreate(modelData);
+  luax_pushtype(L, MeshShape, mesh);
+  lovrRelease(Shape, mesh);
+  return 1;
+}
+
 static int l_lovrPhysicsNewSliderJoint(lua_State* L) {
   Collider* a = luax_checktype(L, 1, Collider);
   Collider* b = luax_checktype(L, 2, Collider);
@@ -135,6 +164,37 @@ static int l_lovrPhysicsNewSphereShape(lua_State* L) {
   return 1;
 }
 
+// Heights are a Blob of floats or a table of numbers, in rows along the x axis
+static int l_lovrPhysicsNewTerrainShape(lua_State* L) {
+  float width = luax_checkfloat(L, 1);
+  float depth = luax_checkfloat(L, 2);
+  uint32_t samplesX = luaL_checkinteger(L, 3);
+  uint32_t samplesZ = luaL_checkinteger(L, 4);
+  float scale = luax_optfloat(L, 6, 1.f);
+  uint32_t count = samplesX * samplesZ;
+  TerrainShape* terrain;
+
+  Blob* blob = luax_totype(L, 5, Blob);
+  if (blob) {
+    lovrAssert(blob->size >= count * sizeof(float), "Blob is too small for %d x %d heights", samplesX, samplesZ);
+    terrain = lovrTerrainShapeCreate(width, depth, samplesX, samplesZ, blob->data, scale);
+  } else {
+    luaL_checktype(L, 5, LUA_TTABLE);
+    lovrAssert((uint32_t) luax_len(L, 5) >= count, "Expected %d heights", count);
+    float* heights = lua_newuserdata(L, count * sizeof(float));
+    for (uint32_t i = 0; i < count; i++) {
+      lua_rawgeti(L, 5, i + 1);
+      heights[i] = lua_tonumber(L, -1);
+      lua_pop(L, 1);
+    }
+    terrain = lovrTerrainShapeCreate(width, depth, samplesX, samplesZ, heights, scale);
+  }
+
+  luax_pushtype(L, TerrainShape, terrain);
+  lovrRelease(Shape, terrain);
+  return 1;
+}
+
 static const luaL_Reg lovrPhysics[] = {
   { "newWorld", l_lovrPhysicsNewWorld },
   { "newBallJoint", l_lovrPhysicsNewBallJoint },
@@ -143,8 +203,10 @@ static const luaL_Reg lovrPhysics[] = {
   { "newCylinderShape", l_lovrPhysicsNewCylinderShape },
   { "newDistanceJoint", l_lovrPhysicsNewDistanceJoint },
   { "newHingeJoint", l_lovrPhysicsNewHingeJoint },
+  { "newMeshShape", l_lovrPhysicsNewMeshShape },
   { "newSliderJoint", l_lovrPhysicsNewSliderJoint },
   { "newSphereShape", l_lovrPhysicsNewSphereShape },
+  { "newTerrainShape", l_lovrPhysicsNewTerrainShape },
   { NULL, NULL }
 };
 
@@ -161,6 +223,8 @@ int luaopen_lovr_physics(lua_State* L) {
   luax_registertype(L, BoxShape);
   luax_registertype(L, CapsuleShape);
   luax_registertype(L, CylinderShape);
+  luax_registertype(L, MeshShape);
+  luax_registertype(L, TerrainShape);
   if (lovrPhysicsInit()) {
     luax_atexit(L, lovrPhysicsDestroy);
   }
@@ -192,7 +192,7 @@ static int l_lovrShaderGetType(lua_State* L) {
 static int l_lovrShaderHasUniform(lua_State* L) {
   Shader* shader = luax_checktype(L, 1, Shader);
   const char* name = luaL_checkstring(L, 2);
-  lua_pushboolean(L, lovrShaderHasUniform(shader, name));
+  lua_pushboolean(L, lovrShaderHasUniform(shader, &(istr_t) { .string = name }));
   return 1;
 }
 
@@ -208,12 +208,13 @@ static int l_lovrShaderSend(lua_State* L) {
   }
 
   luax_checkuniform(L, 3, uniform, tempData.data, name);
+  istr_t uniformName = { .string = uniform->name, .hash = uniform->hash };
   switch (uniform->type) {
-    case UNIFORM_FLOAT: lovrShaderSetFloats(shader, uniform->name, tempData.data, 0, uniform->count * uniform->components); break;
-    case UNIFORM_INT: lovrShaderSetInts(shader, uniform->name, tempData.data, 0, uniform->count * uniform->components); break;
-    case UNIFORM_MATRIX: lovrShaderSetMatrices(shader, uniform->name, tempData.data, 0, uniform->count * uniform->components * uniform->components); break;
-    case UNIFORM_SAMPLER: lovrShaderSetTextures(shader, uniform->name, tempData.data, 0, uniform->count); break;
-    case UNIFORM_IMAGE: lovrShaderSetImages(shader, uniform->name, tempData.data, 0, uniform->count); break;
+    case UNIFORM_FLOAT: lovrShaderSetFloats(shader, &uniformName, tempData.data, 0, uniform->count * uniform->components); break;
+    case UNIFORM_INT: lovrShaderSetInts(shader, &uniformName, tempData.data, 0, uniform->count * uniform->components); break;
+    case UNIFORM_MATRIX: lovrShaderSetMatrices(shader, &uniformName, tempData.data, 0, uniform->count * uniform->components * uniform->components); break;
+    case UNIFORM_SAMPLER: lovrShaderSetTextures(shader, &uniformName, tempData.data, 0, uniform->count); break;
+    case UNIFORM_IMAGE: lovrShaderSetImages(shader, &uniformName, tempData.data, 0, uniform->count); break;
   }
   return 0;
 }
@@ -224,7 +225,7 @@ static int l_lovrShaderSendBlock(lua_State* L) {
   ShaderBlock* block = luax_checktype(L, 3, ShaderBlock);
   UniformAccess access = luaL_checkoption(L, 4, "readwrite", UniformAccesses);
   Buffer* buffer = lovrShaderBlockGetBuffer(block);
-  lovrShaderSetBlock(shader, name, buffer, 0, lovrBufferGetSize(buffer), access);
+  lovrShaderSetBlock(shader, &(istr_t) { .string = name }, buffer, 0, lovrBufferGetSize(buffer), access);
   return 0;
 }
 
@@ -243,7 +244,7 @@ static int l_lovrShaderSendImage(lua_State* L) {
   int mipmap = luax_optmipmap(L, index++, texture);
   UniformAccess access = luaL_checkoption(L, index++, "readwrite", UniformAccesses);
   Image image = { .texture = texture, .slice = slice, .mipmap = mipmap, .access = access };
-  lovrShaderSetImages(shader, name, &image, start, 1);
+  lovrShaderSetImages(shader, &(istr_t) { .string = name }, &image, start, 1);
   return 0;
 }
 
@@ -1,5 +1,7 @@
 #include "api.h"
 #include "physics/physics.h"
+#include "core/ref.h"
+#include <stdlib.h>
 
 void luax_pushshape(lua_State* L, Shape* shape) {
   switch (shape->type) {
@@ -7,6 +9,8 @@ void luax_pushshape(lua_State* L, Shape* shape) {
     case SHAPE_BOX: luax_pushtype(L, BoxShape, shape); break;
     case SHAPE_CAPSULE: luax_pushtype(L, CapsuleShape, shape); break;
     case SHAPE_CYLINDER: luax_pushtype(L, CylinderShape, shape); break;
+    case SHAPE_MESH: luax_pushtype(L, MeshShape, shape); break;
+    case SHAPE_TERRAIN: luax_pushtype(L, TerrainShape, shape); break;
     default: lovrThrow("Unreachable");
   }
 }
@@ -19,7 +23,9 @@ Shape* luax_checkshape(lua_State* L, int index) {
       hash64("SphereShape", strlen("SphereShape")),
       hash64("BoxShape", strlen("BoxShape")),
       hash64("CapsuleShape", strlen("CapsuleShape")),
-      hash64("CylinderShape", strlen("CylinderShape"))
+      hash64("CylinderShape", strlen("CylinderShape")),
+      hash64("MeshShape", strlen("MeshShape")),
+      hash64("TerrainShape", strlen("TerrainShape"))
     };
 
     for (size_t i = 0; i < sizeof(hashes) / sizeof(hashes[0]); i++) {
@@ -301,3 +307,36 @@ const luaL_Reg lovrCylinderShape[] = {
   { "setLength", l_lovrCylinderShapeSetLength },
   { NULL, NULL }
 };
+
+static int l_lovrMeshShapeClone(lua_State* L) {
+  MeshShape* mesh = luax_checktype(L, 1, MeshShape);
+  MeshShape* clone = lovrMeshShapeClone(mesh);
+  luax_pushtype(L, MeshShape, clone);
+  lovrRelease(Shape, clone);
+  return 1;
+}
+
+static int l_lovrMeshShapeGetVertexCount(lua_State* L) {
+  MeshShape* mesh = luax_checktype(L, 1, MeshShape);
+  lua_pushinteger(L, lovrMeshShapeGetVertexCount(mesh));
+  return 1;
+}
+
+static int l_lovrMeshShapeGetTriangleCount(lua_State* L) {
+  MeshShape* mesh = luax_checktype(L, 1, MeshShape);
+  lua_pushinteger(L, lovrMeshShapeGetTriangleCount(mesh));
+  return 1;
+}
+
+const luaL_Reg lovrMeshShape[] = {
+  lovrShape,
+  { "clone", l_lovrMeshShapeClone },
+  { "getVertexCount", l_lovrMeshShapeGetVertexCount },
+  { "getTriangleCount", l_lovrMeshShapeGetTriangleCount },
+  { NULL, NULL }
+};
+
+const luaL_Reg lovrTerrainShape[] = {
+  lovrShape,
+  { NULL, NULL }
+};
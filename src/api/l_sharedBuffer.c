@@ -0,0 +1,139 @@
+#include "api.h"
+#include "data/sharedBuffer.h"
+
+const char* ViewTypes[] = {
+  [VIEW_U8] = "u8",
+  [VIEW_I32] = "i32",
+  [VIEW_F32] = "f32",
+  NULL
+};
+
+static size_t luax_checkindex(lua_State* L, int index) {
+  lua_Integer i = luaL_checkinteger(L, index);
+  lovrAssert(i >= 1, "SharedBuffer index must be positive");
+  return (size_t) i - 1;
+}
+
+static int l_lovrSharedBufferGetPointer(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  lua_pushlightuserdata(L, buffer->blob.data);
+  return 1;
+}
+
+static int l_lovrSharedBufferGetSize(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  lua_pushinteger(L, buffer->blob.size);
+  return 1;
+}
+
+static int l_lovrSharedBufferGetCount(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  ViewType type = luaL_checkoption(L, 2, NULL, ViewTypes);
+  lua_pushinteger(L, lovrSharedBufferGetCount(buffer, type));
+  return 1;
+}
+
+static int l_lovrSharedBufferGet(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  ViewType type = luaL_checkoption(L, 2, NULL, ViewTypes);
+  size_t start = luax_checkindex(L, 3);
+  int count = luaL_optinteger(L, 4, 1);
+  lovrAssert(count >= 1, "SharedBuffer:get count must be positive");
+  lovrSharedBufferGetElement(buffer, type, start + count - 1);
+  luaL_checkstack(L, count, "Too many SharedBuffer values");
+  union { void* raw; uint8_t* u8; int32_t* i32; float* f32; } data = { lovrSharedBufferGetElement(buffer, type, start) };
+  for (int i = 0; i < count; i++) {
+    switch (type) {
+      case VIEW_U8: lua_pushinteger(L, data.u8[i]); break;
+      case VIEW_I32: lua_pushinteger(L, data.i32[i]); break;
+      case VIEW_F32: lua_pushnumber(L, data.f32[i]); break;
+    }
+  }
+  return count;
+}
+
+// Values can be passed as arguments or as a table
+static int l_lovrSharedBufferSet(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  ViewType type = luaL_checkoption(L, 2, NULL, ViewTypes);
+  size_t start = luax_checkindex(L, 3);
+  bool table = lua_istable(L, 4);
+  int count = table ? luax_len(L, 4) : lua_gettop(L) - 3;
+  if (count == 0) {
+    return 0;
+  }
+
+  lovrSharedBufferGetElement(buffer, type, start + count - 1);
+  union { void* raw; uint8_t* u8; int32_t* i32; float* f32; } data = { lovrSharedBufferGetElement(buffer, type, start) };
+  for (int i = 0; i < count; i++) {
+    int index = 4 + i;
+    if (table) {
+      lua_rawgeti(L, 4, i + 1);
+      index = -1;
+    }
+
+    switch (type) {
+      case VIEW_U8: data.u8[i] = (uint8_t) luaL_checkinteger(L, index); break;
+      case VIEW_I32: data.i32[i] = (int32_t) luaL_checkinteger(L, index); break;
+      case VIEW_F32: data.f32[i] = luax_checkfloat(L, index); break;
+    }
+
+    if (table) {
+      lua_pop(L, 1);
+    }
+  }
+  return 0;
+}
+
+static int l_lovrSharedBufferAtomicLoad(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  size_t index = luax_checkindex(L, 2);
+  lua_pushinteger(L, lovrSharedBufferAtomicLoad(buffer, index));
+  return 1;
+}
+
+static int l_lovrSharedBufferAtomicStore(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  size_t index = luax_checkindex(L, 2);
+  int32_t value = (int32_t) luaL_checkinteger(L, 3);
+  lovrSharedBufferAtomicStore(buffer, index, value);
+  return 0;
+}
+
+static int l_lovrSharedBufferAtomicAdd(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  size_t index = luax_checkindex(L, 2);
+  int32_t value = (int32_t) luaL_optinteger(L, 3, 1);
+  lua_pushinteger(L, lovrSharedBufferAtomicAdd(buffer, index, value));
+  return 1;
+}
+
+static int l_lovrSharedBufferAtomicCompareExchange(lua_State* L) {
+  SharedBuffer* buffer = luax_checktype(L, 1, SharedBuffer);
+  size_t index = luax_checkindex(L, 2);
+  int32_t expected = (int32_t) luaL_checkinteger(L, 3);
+  int32_t desired = (int32_t) luaL_checkinteger(L, 4);
+  bool success = lovrSharedBufferAtomicCompareExchange(buffer, index, &expected, desired);
+  lua_pushboolean(L, success);
+  lua_pushinteger(L, expected);
+  return 2;
+}
+
+static int l_lovrSharedBufferFence(lua_State* L) {
+  lovrSharedBufferFence();
+  return 0;
+}
+
+const luaL_Reg lovrSharedBuffer[] = {
+  { "getPointer", l_lovrSharedBufferGetPointer },
+  { "getSize", l_lovrSharedBufferGetSize },
+  { "getCount", l_lovrSharedBufferGetCount },
+  { "get", l_lovrSharedBufferGet },
+  { "set", l_lovrSharedBufferSet },
+  { "atomicLoad", l_lovrSharedBufferAtomicLoad },
+  { "atomicStore", l_lovrSharedBufferAtomicStore },
+  { "atomicAdd", l_lovrSharedBufferAtomicAdd },
+  { "atomicCompareExchange", l_lovrSharedBufferAtomicCompareExchange },
+  { "fence", l_lovrSharedBufferFence },
+  { NULL, NULL }
+};
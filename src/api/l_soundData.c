@@ -38,6 +38,12 @@ static int l_lovrSoundDataGetSampleRate(lua_State* L) {
   return 1;
 }
 
+static int l_lovrSoundDataIsCompressed(lua_State* L) {
+  SoundData* soundData = luax_checktype(L, 1, SoundData);
+  lua_pushboolean(L, lovrSoundDataIsCompressed(soundData));
+  return 1;
+}
+
 static int l_lovrSoundDataSetSample(lua_State* L) {
   SoundData* soundData = luax_checktype(L, 1, SoundData);
   int index = luaL_checkinteger(L, 2);
@@ -48,6 +54,7 @@ static int l_lovrSoundDataSetSample(lua_State* L) {
 
 static int l_lovrSoundDataGetPointer(lua_State* L) {
   SoundData* soundData = luax_checktype(L, 1, SoundData);
+  lovrAssert(!lovrSoundDataIsCompressed(soundData), "Compressed SoundData does not have a pointer to its samples");
   lua_pushlightuserdata(L, soundData->blob.data);
   return 1;
 }
@@ -59,6 +66,7 @@ const luaL_Reg lovrSoundData[] = {
   { "getSample", l_lovrSoundDataGetSample },
   { "getSampleCount", l_lovrSoundDataGetSampleCount },
   { "getSampleRate", l_lovrSoundDataGetSampleRate },
+  { "isCompressed", l_lovrSoundDataIsCompressed },
   { "setSample", l_lovrSoundDataSetSample },
   { "getPointer", l_lovrSoundDataGetPointer },
   { NULL, NULL }
@@ -2,7 +2,17 @@
 #include "audio/audio.h"
 #include "audio/source.h"
 #include "core/maf.h"
+#include "core/ref.h"
 #include <stdbool.h>
+#include <stdlib.h>
+
+static int l_lovrSourceClone(lua_State* L) {
+  Source* source = luax_checktype(L, 1, Source);
+  Source* clone = lovrSourceClone(source);
+  luax_pushtype(L, Source, clone);
+  lovrRelease(Source, clone);
+  return 1;
+}
 
 static int l_lovrSourceGetBitDepth(lua_State* L) {
   Source* source = luax_checktype(L, 1, Source);
@@ -93,6 +103,12 @@ static int l_lovrSourceGetPosition(lua_State* L) {
   return 3;
 }
 
+static int l_lovrSourceGetPriority(lua_State* L) {
+  Source* source = luax_checktype(L, 1, Source);
+  lua_pushinteger(L, lovrSourceGetPriority(source));
+  return 1;
+}
+
 static int l_lovrSourceGetSampleRate(lua_State* L) {
   Source* source = luax_checktype(L, 1, Source);
   lua_pushinteger(L, lovrSourceGetSampleRate(source));
@@ -246,6 +262,13 @@ static int l_lovrSourceSetPosition(lua_State* L) {
   return 0;
 }
 
+static int l_lovrSourceSetPriority(lua_State* L) {
+  Source* source = luax_checktype(L, 1, Source);
+  int priority = luaL_checkinteger(L, 2);
+  lovrSourceSetPriority(source, priority);
+  return 0;
+}
+
 static int l_lovrSourceSetRelative(lua_State* L) {
   Source* source = luax_checktype(L, 1, Source);
   bool isRelative = lua_toboolean(L, 2);
@@ -291,6 +314,7 @@ static int l_lovrSourceTell(lua_State* L) {
 }
 
 const luaL_Reg lovrSource[] = {
+  { "clone", l_lovrSourceClone },
   { "getBitDepth", l_lovrSourceGetBitDepth },
   { "getChannelCount", l_lovrSourceGetChannelCount },
   { "getCone", l_lovrSourceGetCone },
@@ -300,6 +324,7 @@ const luaL_Reg lovrSource[] = {
   { "getPitch", l_lovrSourceGetPitch },
   { "getPose", l_lovrSourceGetPose },
   { "getPosition", l_lovrSourceGetPosition },
+  { "getPriority", l_lovrSourceGetPriority },
   { "getSampleRate", l_lovrSourceGetSampleRate },
   { "getType", l_lovrSourceGetType },
   { "getVelocity", l_lovrSourceGetVelocity },
@@ -322,6 +347,7 @@ const luaL_Reg lovrSource[] = {
   { "setPitch", l_lovrSourceSetPitch },
   { "setPose", l_lovrSourceSetPose },
   { "setPosition", l_lovrSourceSetPosition },
+  { "setPriority", l_lovrSourceSetPriority },
   { "setRelative", l_lovrSourceSetRelative },
   { "setVelocity", l_lovrSourceSetVelocity },
   { "setVolume", l_lovrSourceSetVolume },
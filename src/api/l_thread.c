@@ -30,10 +30,17 @@ static int l_lovrThreadIsRunning(lua_State* L) {
   return 1;
 }
 
+static int l_lovrThreadGetStartupTime(lua_State* L) {
+  Thread* thread = luax_checktype(L, 1, Thread);
+  lua_pushnumber(L, lovrThreadGetStartupTime(thread));
+  return 1;
+}
+
 const luaL_Reg lovrThread[] = {
   { "start", l_lovrThreadStart },
   { "wait", l_lovrThreadWait },
   { "getError", l_lovrThreadGetError },
   { "isRunning", l_lovrThreadIsRunning },
+  { "getStartupTime", l_lovrThreadGetStartupTime },
   { NULL, NULL }
 };
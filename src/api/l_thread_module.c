@@ -3,28 +3,189 @@
 #include "filesystem/filesystem.h"
 #include "thread/thread.h"
 #include "thread/channel.h"
+#include "thread/job.h"
+#include "core/arr.h"
+#include "core/atomic.h"
+#include "core/map.h"
+#include "core/platform.h"
 #include "core/ref.h"
 #include <stdlib.h>
 #include <string.h>
 
+// Code run by parallelFor, shared by every job in the batch
+typedef struct {
+  const char* code;
+  size_t length;
+  Variant* arguments;
+  uint32_t argumentCount;
+  volatile uint32_t failed;
+  char* error;
+} LuaJob;
+
+// Pool threads and job workers each keep a Lua state that lives as long as the OS thread, closed by
+// the thread-specific storage destructor when the thread exits
+static tss_t threadState;
+
+// How many runs (Thread bodies or jobs) are using this thread's state, temporary vectors are only
+// drained once the outermost one finishes since nested jobs share the state
+static LOVR_THREAD_LOCAL uint32_t depth;
+
+// Bytecode for thread bodies, shared by every state.  Chunks are found by the hash of their source
+// and then compared with it, and are kept until the module is destroyed, so the cache stops taking
+// new bodies once it's full.
+#define MAX_BYTECODE_CHUNKS 64
+
+typedef struct {
+  Blob* source;
+  char* data;
+  size_t size;
+} Bytecode;
+
+static struct {
+  mtx_t lock;
+  arr_t(Bytecode) chunks;
+  map_t map;
+} bytecode;
+
+typedef arr_t(char) arr_char_t;
+
+static void closeState(void* L) {
+  lua_close(L);
+}
+
+static lua_State* getState() {
+  lua_State* L = tss_get(threadState);
+
+  if (!L) {
+    L = luaL_newstate();
+    luaL_openlibs(L);
+
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "preload");
+    luaL_register(L, NULL, lovrModules);
+    lua_pop(L, 2);
+    tss_set(threadState, L);
+  }
+
+  return L;
+}
+
+static int writeBytecode(lua_State* L, const void* data, size_t size, void* userdata) {
+  arr_char_t* buffer = userdata;
+  arr_append(buffer, (const char*) data, size);
+  return 0;
+}
+
+// Pushes the compiled body, or an error message.  The first state to compile a body shares its
+// bytecode so the source is only parsed once, and states keep the functions for shared chunks in a
+// table indexed by chunk.
+static int loadBody(lua_State* L, Blob* body) {
+  uint64_t hash = hash64(body->data, body->size);
+
+  mtx_lock(&bytecode.lock);
+  uint64_t index = map_get(&bytecode.map, hash);
+  Bytecode chunk = index == MAP_NIL ? (Bytecode) { NULL, NULL, 0 } : bytecode.chunks.data[index];
+  bool cacheable = index == MAP_NIL && bytecode.chunks.length < MAX_BYTECODE_CHUNKS;
+  mtx_unlock(&bytecode.lock);
+
+  // A different body with the same hash is compiled every time
+  if (chunk.source) {
+    Blob* source = chunk.source;
+    if (source->size != body->size || memcmp(source->data, body->data, body->size)) {
+      chunk.data = NULL;
+    }
+  }
+
+  if (chunk.data) {
+    lua_getfield(L, LUA_REGISTRYINDEX, "_lovrchunks");
+    if (lua_isnil(L, -1)) {
+      lua_pop(L, 1);
+      lua_newtable(L);
+      lua_pushvalue(L, -1);
+      lua_setfield(L, LUA_REGISTRYINDEX, "_lovrchunks");
+    }
+
+    lua_rawgeti(L, -1, (int) index + 1);
+    if (lua_isfunction(L, -1)) {
+      lua_remove(L, -2);
+      return 0;
+    }
+    lua_pop(L, 1);
+
+    if (luaL_loadbuffer(L, chunk.data, chunk.size, "thread")) {
+      lua_remove(L, -2);
+      return 1;
+    }
+
+    lua_pushvalue(L, -1);
+    lua_rawseti(L, -3, (int) index + 1);
+    lua_remove(L, -2);
+    return 0;
+  }
+
+  if (luaL_loadbuffer(L, body->data, body->size, "thread")) {
+    return 1;
+  }
+
+  if (cacheable) {
+    arr_char_t buffer;
+    arr_init(&buffer);
+    lua_dump(L, writeBytecode, &buffer);
+
+    mtx_lock(&bytecode.lock);
+    if (map_get(&bytecode.map, hash) == MAP_NIL && bytecode.chunks.length < MAX_BYTECODE_CHUNKS) {
+      lovrRetain(body);
+      map_set(&bytecode.map, hash, bytecode.chunks.length);
+      arr_push(&bytecode.chunks, ((Bytecode) { body, buffer.data, buffer.length }));
+    } else {
+      arr_free(&buffer);
+    }
+    mtx_unlock(&bytecode.lock);
+  }
+
+  return 0;
+}
+
+// Each run gets its own globals that fall back to the shared ones, so runs in the same state don't
+// see each other's globals.  Loaded modules stay loaded.
+static void setEnvironment(lua_State* L) {
+  lua_newtable(L);
+  lua_createtable(L, 0, 1);
+#if LUA_VERSION_NUM < 502
+  lua_pushvalue(L, LUA_GLOBALSINDEX);
+  lua_setfield(L, -2, "__index");
+  lua_setmetatable(L, -2);
+  lua_setfenv(L, -2);
+#else
+  lua_pushglobaltable(L);
+  lua_setfield(L, -2, "__index");
+  lua_setmetatable(L, -2);
+  lua_setupvalue(L, -2, 1);
+#endif
+}
+
 static int threadRunner(void* data) {
   Thread* thread = (Thread*) data;
+  lua_State* L = getState();
 
-  lovrRetain(thread);
-  mtx_lock(&thread->lock);
-  thread->running = true;
-  mtx_unlock(&thread->lock);
+  if (!thread) {
+    return 0;
+  }
 
-  lua_State* L = luaL_newstate();
-  luaL_openlibs(L);
   lovrSetErrorCallback((errorFn*) luax_vthrow, L);
+  depth++;
 
-  lua_getglobal(L, "package");
-  lua_getfield(L, -1, "preload");
-  luaL_register(L, NULL, lovrModules);
-  lua_pop(L, 2);
+  int status = loadBody(L, thread->body);
 
-  if (luaL_loadbuffer(L, thread->body->data, thread->body->size, "thread") || lua_pcall(L, 0, 0, 0)) {
+  if (!status) {
+    setEnvironment(L);
+    mtx_lock(&thread->lock);
+    thread->startupTime = lovrPlatformGetTime() - thread->startTime;
+    mtx_unlock(&thread->lock);
+    status = lua_pcall(L, 0, 0, 0);
+  }
+
+  if (status) {
     size_t length;
     const char* error = lua_tolstring(L, -1, &length);
     mtx_lock(&thread->lock);
@@ -36,19 +197,18 @@ static int threadRunner(void* data) {
         .data.thread = { thread, thread->error }
       });
     }
-    thread->running = false;
     mtx_unlock(&thread->lock);
-    lovrRelease(Thread, thread);
-    lua_close(L);
-    return 1;
   }
 
-  mtx_lock(&thread->lock);
-  thread->running = false;
-  mtx_unlock(&thread->lock);
-  lovrRelease(Thread, thread);
-  lua_close(L);
-  return 0;
+  // Release anything the run was holding on to, closing the state used to do this
+  lua_settop(L, 0);
+  depth--;
+#ifdef LOVR_ENABLE_MATH
+  luax_drainvectors();
+#endif
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  lovrSetErrorCallback(NULL, NULL);
+  return status ? 1 : 0;
 }
 
 static int l_lovrThreadNewThread(lua_State* L) {
@@ -84,19 +244,191 @@ static int l_lovrThreadGetChannel(lua_State* L) {
   return 1;
 }
 
+// Unnamed Channels are bounded, they can be sent to other threads through named Channels
+static int l_lovrThreadNewChannel(lua_State* L) {
+  lua_Integer capacity = luaL_checkinteger(L, 1);
+  lovrAssert(capacity > 0 && capacity <= UINT32_MAX, "Channel capacity must be positive");
+  Channel* channel = lovrChannelCreate(0, (uint32_t) capacity);
+  luax_pushtype(L, Channel, channel);
+  lovrRelease(Channel, channel);
+  return 1;
+}
+
+static int runLuaJob(lua_State* L) {
+  LuaJob* job = lua_touserdata(L, 1);
+
+  lua_getfield(L, LUA_REGISTRYINDEX, "_lovrjobs");
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    lua_newtable(L);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, LUA_REGISTRYINDEX, "_lovrjobs");
+  }
+
+  lua_pushlstring(L, job->code, job->length);
+  lua_rawget(L, -2);
+  if (lua_isnil(L, -1)) {
+    lua_pop(L, 1);
+    if (luaL_loadbuffer(L, job->code, job->length, "parallelFor")) {
+      return lua_error(L);
+    }
+    lua_call(L, 0, 1);
+    lovrAssert(lua_isfunction(L, -1), "parallelFor code must return a function");
+    lua_pushlstring(L, job->code, job->length);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, -4);
+  }
+
+  lua_pushvalue(L, 2);
+  lua_pushvalue(L, 3);
+  for (uint32_t i = 0; i < job->argumentCount; i++) {
+    luax_pushvariant(L, &job->arguments[i]);
+  }
+  lua_call(L, 2 + job->argumentCount, 0);
+  return 0;
+}
+
+// Runs on whichever thread picks up the job, so it swaps in its own error handler and vector pool
+// around the call.  This can be a thread with its own Lua state, like the main thread helping out
+// in lovrJobWait, and that state's pool has to survive.
+static void luaJobRunner(void* context, uint32_t start, uint32_t count) {
+  LuaJob* job = context;
+
+  if (atomic_load32(&job->failed)) {
+    return;
+  }
+
+  lua_State* L = getState();
+  errorFn* callback = lovrErrorCallback;
+  void* userdata = lovrErrorUserdata;
+  lovrSetErrorCallback((errorFn*) luax_vthrow, L);
+#ifdef LOVR_ENABLE_MATH
+  void* vectors = luax_bindvectors(L);
+#endif
+  depth++;
+
+  lua_pushcfunction(L, runLuaJob);
+  lua_pushlightuserdata(L, job);
+  lua_pushinteger(L, start + 1);
+  lua_pushinteger(L, start + count);
+  if (lua_pcall(L, 3, 0, 0)) {
+    if (atomic_add32(&job->failed, 1) == 1) {
+      size_t length;
+      const char* error = lua_tolstring(L, -1, &length);
+      job->error = malloc(length + 1);
+      if (job->error) {
+        memcpy(job->error, error, length + 1);
+      }
+    }
+    lua_pop(L, 1);
+  }
+
+  depth--;
+#ifdef LOVR_ENABLE_MATH
+  if (depth == 0) {
+    luax_drainvectors();
+  }
+  luax_unbindvectors(vectors);
+#endif
+  lovrSetErrorCallback(callback, userdata);
+}
+
+// Calls the function returned by the code with ranges of indices (first, last, ...) on the job
+// workers and waits for all of them.  The code runs in separate Lua states, so arguments are copied
+// like Channel messages and writes have to go through objects like Blobs.
+static int l_lovrThreadParallelFor(lua_State* L) {
+  LuaJob job = { 0 };
+  Blob* blob = luax_totype(L, 1, Blob);
+  if (blob) {
+    job.code = blob->data;
+    job.length = blob->size;
+  } else {
+    job.code = luaL_checklstring(L, 1, &job.length);
+  }
+
+  lua_Integer count = luaL_checkinteger(L, 2);
+  lovrAssert(count >= 0 && count <= UINT32_MAX, "parallelFor count must be between 0 and 2^32 - 1");
+
+  job.argumentCount = lua_gettop(L) - 2;
+  VariantBatch* arguments = luax_newvariantbatch(L, job.argumentCount);
+  for (uint32_t i = 0; i < job.argumentCount; i++) {
+    luax_checkvariant(L, 3 + i, &arguments->variants[i]);
+    arguments->count++;
+  }
+
+  job.arguments = arguments->variants;
+  lovrJobsParallelFor(luaJobRunner, &job, (uint32_t) count, 0);
+  luax_destroyvariantbatch(arguments);
+
+  if (job.failed) {
+    lua_pushstring(L, job.error ? job.error : "Out of memory");
+    free(job.error);
+    return lua_error(L);
+  }
+
+  return 0;
+}
+
+static int l_lovrThreadPrewarm(lua_State* L) {
+  lua_Integer count = luaL_checkinteger(L, 1);
+  luaL_argcheck(L, count >= 0, 1, "count must be non-negative");
+  lovrThreadPrewarm((uint32_t) MIN(count, UINT32_MAX), threadRunner);
+  return 0;
+}
+
+static int l_lovrThreadGetPoolSize(lua_State* L) {
+  uint32_t total, idle;
+  lovrThreadGetPoolSize(&total, &idle);
+  lua_pushinteger(L, total);
+  lua_pushinteger(L, idle);
+  return 2;
+}
+
+static int l_lovrThreadGetWorkerCount(lua_State* L) {
+  lua_pushinteger(L, lovrJobsGetWorkerCount());
+  return 1;
+}
+
 static const luaL_Reg lovrThreadModule[] = {
   { "newThread", l_lovrThreadNewThread },
+  { "newChannel", l_lovrThreadNewChannel },
   { "getChannel", l_lovrThreadGetChannel },
+  { "parallelFor", l_lovrThreadParallelFor },
+  { "getWorkerCount", l_lovrThreadGetWorkerCount },
+  { "prewarm", l_lovrThreadPrewarm },
+  { "getPoolSize", l_lovrThreadGetPoolSize },
   { NULL, NULL }
 };
 
+// Pool threads and workers close their own states as they exit, the one on this thread (from
+// helping with jobs) is closed here
+static void destroyModule() {
+  lovrThreadModuleDestroy();
+  lua_State* L = tss_get(threadState);
+  if (L) {
+    lua_close(L);
+  }
+  tss_delete(threadState);
+  for (size_t i = 0; i < bytecode.chunks.length; i++) {
+    lovrRelease(Blob, bytecode.chunks.data[i].source);
+    free(bytecode.chunks.data[i].data);
+  }
+  arr_free(&bytecode.chunks);
+  map_free(&bytecode.map);
+  mtx_destroy(&bytecode.lock);
+}
+
 int luaopen_lovr_thread(lua_State* L) {
   lua_newtable(L);
   luaL_register(L, NULL, lovrThreadModule);
   luax_registertype(L, Thread);
   luax_registertype(L, Channel);
   if (lovrThreadModuleInit()) {
-    luax_atexit(L, lovrThreadModuleDestroy);
+    tss_create(&threadState, closeState);
+    mtx_init(&bytecode.lock, mtx_plain);
+    arr_init(&bytecode.chunks);
+    map_init(&bytecode.map, 0);
+    luax_atexit(L, destroyModule);
   }
   return 1;
 }
@@ -1,7 +1,12 @@
 #include "api.h"
 #include "physics/physics.h"
+#include "data/blob.h"
+#include "data/modelData.h"
+#include "core/maf.h"
 #include "core/ref.h"
 #include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 static void collisionResolver(World* world, void* userdata) {
   lua_State* L = userdata;
@@ -38,6 +43,88 @@ static void raycastCallback(Shape* shape, float x, float y, float z, float nx, f
   lua_call(L, 7, 0);
 }
 
+// Tags can be nil (everything), a tag name, or a table of tag names
+static uint64_t luax_checktagmask(lua_State* L, int index, World* world) {
+  switch (lua_type(L, index)) {
+    case LUA_TNIL:
+    case LUA_TNONE:
+      return ~0ull;
+    case LUA_TSTRING: {
+      const char* name = lua_tostring(L, index);
+      uint32_t tag = lovrWorldFindTag(world, name);
+      lovrAssert(tag != NO_TAG, "Unknown tag '%s'", name);
+      return 1ull << tag;
+    }
+    default: {
+      luaL_checktype(L, index, LUA_TTABLE);
+      uint64_t mask = 0;
+      int length = luax_len(L, index);
+      for (int i = 0; i < length; i++) {
+        lua_rawgeti(L, index, i + 1);
+        const char* name = luaL_checkstring(L, -1);
+        uint32_t tag = lovrWorldFindTag(world, name);
+        lovrAssert(tag != NO_TAG, "Unknown tag '%s'", name);
+        mask |= 1ull << tag;
+        lua_pop(L, 1);
+      }
+      return mask;
+    }
+  }
+}
+
+// Queries are either a Blob or a table of numbers, with 6 floats (start and end points) per query.
+// Results are written to a table, 8 values per query: the Shape (or false), the hit position, the
+// normal, and the fraction of the query where the hit happened.
+static int luax_cast(lua_State* L, int index, World* world, CastType type, float size[3], float orientation[4]) {
+  const float* queries;
+  float* copy = NULL;
+  uint32_t count;
+
+  luaL_checktype(L, index + 1, LUA_TTABLE);
+  uint64_t tagMask = luax_checktagmask(L, index + 2, world);
+
+  Blob* blob = luax_totype(L, index, Blob);
+  if (blob) {
+    count = (uint32_t) (blob->size / (6 * sizeof(float)));
+    queries = blob->data;
+  } else {
+    luaL_checktype(L, index, LUA_TTABLE);
+    count = luax_len(L, index) / 6;
+    queries = copy = malloc(6 * count * sizeof(float));
+    lovrAssert(!count || copy, "Out of memory");
+    for (uint32_t i = 0; i < 6 * count; i++) {
+      lua_rawgeti(L, index, i + 1);
+      copy[i] = (float) lua_tonumber(L, -1);
+      lua_pop(L, 1);
+    }
+  }
+
+  CastHit* hits;
+  uint32_t hitCount = lovrWorldCast(world, type, size, orientation, tagMask, queries, count, &hits);
+  free(copy);
+
+  for (uint32_t i = 0; i < count; i++) {
+    CastHit* hit = &hits[i];
+    if (hit->shape) {
+      luax_pushshape(L, hit->shape);
+    } else {
+      lua_pushboolean(L, false);
+    }
+    lua_rawseti(L, index + 1, 8 * i + 1);
+    for (int j = 0; j < 3; j++) {
+      lua_pushnumber(L, hit->shape ? hit->position[j] : 0.);
+      lua_rawseti(L, index + 1, 8 * i + 2 + j);
+      lua_pushnumber(L, hit->shape ? hit->normal[j] : 0.);
+      lua_rawseti(L, index + 1, 8 * i + 5 + j);
+    }
+    lua_pushnumber(L, hit->fraction);
+    lua_rawseti(L, index + 1, 8 * i + 8);
+  }
+
+  lua_pushinteger(L, hitCount);
+  return 1;
+}
+
 static int l_lovrWorldNewCollider(lua_State* L) {
   World* world = luax_checktype(L, 1, World);
   float x = luax_optfloat(L, 2, 0.f);
@@ -98,6 +185,20 @@ static int l_lovrWorldNewCylinderCollider(lua_State* L) {
   return 1;
 }
 
+// Mesh colliders are kinematic, since triangle meshes are mostly used for static level geometry
+static int l_lovrWorldNewMeshCollider(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  ModelData* modelData = luax_checktype(L, 2, ModelData);
+  Collider* collider = lovrColliderCreate(world, 0.f, 0.f, 0.f);
+  MeshShape* shape = lovrMeshShapeCreate(modelData);
+  lovrColliderAddShape(collider, shape);
+  lovrColliderSetKinematic(collider, true);
+  luax_pushtype(L, Collider, collider);
+  lovrRelease(Collider, collider);
+  lovrRelease(Shape, shape);
+  return 1;
+}
+
 static int l_lovrWorldNewSphereCollider(lua_State* L) {
   World* world = luax_checktype(L, 1, World);
   float x = luax_optfloat(L, 2, 0.f);
@@ -128,6 +229,177 @@ static int l_lovrWorldUpdate(lua_State* L) {
   return 0;
 }
 
+static int l_lovrWorldGetStepSize(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  float stepSize;
+  uint32_t maxSteps;
+  lovrWorldGetStepSize(world, &stepSize, &maxSteps);
+  lua_pushnumber(L, stepSize);
+  lua_pushinteger(L, maxSteps);
+  return 2;
+}
+
+static int l_lovrWorldSetStepSize(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  float stepSize = luax_optfloat(L, 2, 0.f);
+  uint32_t maxSteps = luaL_optinteger(L, 3, 4);
+  lovrWorldSetStepSize(world, stepSize, maxSteps);
+  return 0;
+}
+
+static int l_lovrWorldGetInterpolation(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  lua_pushnumber(L, lovrWorldGetInterpolation(world));
+  return 1;
+}
+
+static int l_lovrWorldGetColliders(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  size_t count;
+  Collider** colliders = lovrWorldGetColliders(world, &count);
+
+  if (lua_istable(L, 2)) {
+    lua_settop(L, 2);
+  } else {
+    lua_settop(L, 1);
+    lua_createtable(L, (int) count, 0);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    luax_pushtype(L, Collider, colliders[i]);
+    lua_rawseti(L, -2, (int) i + 1);
+  }
+
+  return 1;
+}
+
+// Writes poses to a Blob or a table of numbers, in the same order as World:getColliders.  An
+// optional table gets a boolean per Collider telling whether it changed in the last step.
+static int l_lovrWorldGetPoses(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  bool matrices = lua_toboolean(L, 3);
+  uint32_t stride = matrices ? 16 : 7;
+  uint32_t count = lovrWorldGetPoses(world, NULL, 0, matrices, NULL);
+  bool* changed = NULL;
+
+  if (lua_istable(L, 4)) {
+    changed = malloc(count * sizeof(bool));
+    lovrAssert(!count || changed, "Out of memory");
+  }
+
+  Blob* blob = luax_totype(L, 2, Blob);
+  if (blob) {
+    uint32_t capacity = (uint32_t) (blob->size / (stride * sizeof(float)));
+    count = MIN(count, capacity);
+    lovrWorldGetPoses(world, blob->data, capacity, matrices, changed);
+  } else {
+    luaL_checktype(L, 2, LUA_TTABLE);
+    float* data = malloc(count * stride * sizeof(float));
+    lovrAssert(!count || data, "Out of memory");
+    lovrWorldGetPoses(world, data, count, matrices, changed);
+    for (uint32_t i = 0; i < count * stride; i++) {
+      lua_pushnumber(L, data[i]);
+      lua_rawseti(L, 2, i + 1);
+    }
+    free(data);
+  }
+
+  if (changed) {
+    for (uint32_t i = 0; i < count; i++) {
+      lua_pushboolean(L, changed[i]);
+      lua_rawseti(L, 4, i + 1);
+    }
+    free(changed);
+  }
+
+  lua_pushinteger(L, (lua_Integer) count);
+  return 1;
+}
+
+// Fills an existing table if one is passed in, so it can be called every frame without garbage
+static int l_lovrWorldGetStats(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  WorldStats stats;
+  lovrWorldGetStats(world, &stats);
+
+  if (lua_istable(L, 2)) {
+    lua_settop(L, 2);
+  } else {
+    lua_createtable(L, 0, 11);
+  }
+
+  lua_pushinteger(L, stats.steps);
+  lua_setfield(L, -2, "steps");
+  lua_pushinteger(L, stats.pairs);
+  lua_setfield(L, -2, "pairs");
+  lua_pushinteger(L, stats.tests);
+  lua_setfield(L, -2, "tests");
+  lua_pushinteger(L, stats.contacts);
+  lua_setfield(L, -2, "contacts");
+  lua_pushinteger(L, stats.awake);
+  lua_setfield(L, -2, "awake");
+  lua_pushinteger(L, stats.islands);
+  lua_setfield(L, -2, "islands");
+  lua_pushinteger(L, stats.iterations);
+  lua_setfield(L, -2, "iterations");
+  lua_pushnumber(L, stats.broadphaseTime);
+  lua_setfield(L, -2, "broadphaseTime");
+  lua_pushnumber(L, stats.narrowphaseTime);
+  lua_setfield(L, -2, "narrowphaseTime");
+  lua_pushnumber(L, stats.contactTime);
+  lua_setfield(L, -2, "contactTime");
+  lua_pushnumber(L, stats.solverTime);
+  lua_setfield(L, -2, "solverTime");
+  return 1;
+}
+
+static int l_lovrWorldSnapshot(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  size_t size;
+  void* data = lovrWorldSnapshot(world, &size);
+  Blob* blob = lovrBlobCreate(data, size, "World snapshot");
+  luax_pushtype(L, Blob, blob);
+  lovrRelease(Blob, blob);
+  return 1;
+}
+
+// Snapshots can also be strings, so they can come straight off of the network
+static int l_lovrWorldRestore(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  Blob* blob = luax_totype(L, 2, Blob);
+  if (blob) {
+    lovrWorldRestore(world, blob->data, blob->size);
+  } else {
+    size_t size;
+    const char* data = luaL_checklstring(L, 2, &size);
+    lovrWorldRestore(world, data, size);
+  }
+  return 0;
+}
+
+static void luax_pushchecksum(lua_State* L, uint64_t checksum) {
+  char string[17];
+  snprintf(string, sizeof(string), "%08x%08x", (uint32_t) (checksum >> 32), (uint32_t) checksum);
+  lua_pushstring(L, string);
+}
+
+static int l_lovrWorldGetChecksum(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  luax_pushchecksum(L, lovrWorldGetChecksum(world));
+  return 1;
+}
+
+static int l_lovrWorldCheckDeterminism(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  float dt = luax_checkfloat(L, 2);
+  uint32_t steps = luaL_optinteger(L, 3, 1);
+  uint64_t checksum;
+  bool deterministic = lovrWorldCheckDeterminism(world, dt, steps, &checksum);
+  lua_pushboolean(L, deterministic);
+  luax_pushchecksum(L, checksum);
+  return 2;
+}
+
 static int l_lovrWorldComputeOverlaps(lua_State* L) {
   World* world = luax_checktype(L, 1, World);
   lovrWorldComputeOverlaps(world);
@@ -217,6 +489,95 @@ static int l_lovrWorldSetSleepingAllowed(lua_State* L) {
   return 0;
 }
 
+// Events are written to a table (a new one or the one passed in), 11 values per event: the event
+// type, both Colliders, the contact position and normal, the penetration depth, and the impulse
+static int l_lovrWorldGetContacts(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  size_t count;
+  ContactEvent* events = lovrWorldGetContactEvents(world, &count);
+
+  if (lua_istable(L, 2)) {
+    lua_settop(L, 2);
+  } else {
+    lua_settop(L, 1);
+    lua_createtable(L, (int) count * 11, 0);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    ContactEvent* event = &events[i];
+    int base = (int) i * 11;
+    lua_pushstring(L, ContactEventTypes[event->type]);
+    lua_rawseti(L, -2, base + 1);
+    if (event->a) {
+      luax_pushtype(L, Collider, event->a);
+    } else {
+      lua_pushboolean(L, false);
+    }
+    lua_rawseti(L, -2, base + 2);
+    if (event->b) {
+      luax_pushtype(L, Collider, event->b);
+    } else {
+      lua_pushboolean(L, false);
+    }
+    lua_rawseti(L, -2, base + 3);
+    for (int j = 0; j < 3; j++) {
+      lua_pushnumber(L, event->position[j]);
+      lua_rawseti(L, -2, base + 4 + j);
+      lua_pushnumber(L, event->normal[j]);
+      lua_rawseti(L, -2, base + 7 + j);
+    }
+    lua_pushnumber(L, event->depth);
+    lua_rawseti(L, -2, base + 10);
+    lua_pushnumber(L, event->impulse);
+    lua_rawseti(L, -2, base + 11);
+  }
+
+  lua_pushinteger(L, (lua_Integer) count);
+  return 2;
+}
+
+static int l_lovrWorldGetContactProperties(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  const char* tag1 = luaL_checkstring(L, 2);
+  const char* tag2 = luaL_checkstring(L, 3);
+  float friction, restitution;
+  lovrAssert(lovrWorldGetContactProperties(world, tag1, tag2, &friction, &restitution), "Unknown tag");
+  if (friction >= 0.f) {
+    lua_pushnumber(L, friction);
+  } else {
+    lua_pushnil(L);
+  }
+  if (restitution >= 0.f) {
+    lua_pushnumber(L, restitution);
+  } else {
+    lua_pushnil(L);
+  }
+  return 2;
+}
+
+static int l_lovrWorldSetContactProperties(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  const char* tag1 = luaL_checkstring(L, 2);
+  const char* tag2 = luaL_checkstring(L, 3);
+  float friction = luax_optfloat(L, 4, -1.f);
+  float restitution = luax_optfloat(L, 5, -1.f);
+  lovrAssert(lovrWorldSetContactProperties(world, tag1, tag2, friction, restitution), "Unknown tag");
+  return 0;
+}
+
+static int l_lovrWorldGetThreadCount(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  lua_pushinteger(L, lovrWorldGetThreadCount(world));
+  return 1;
+}
+
+static int l_lovrWorldSetThreadCount(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  uint32_t count = luaL_checkinteger(L, 2);
+  lovrWorldSetThreadCount(world, count);
+  return 0;
+}
+
 static int l_lovrWorldRaycast(lua_State* L) {
   World* world = luax_checktype(L, 1, World);
   float x1 = luax_checkfloat(L, 2);
@@ -231,6 +592,27 @@ static int l_lovrWorldRaycast(lua_State* L) {
   return 0;
 }
 
+static int l_lovrWorldRaycastBatch(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  return luax_cast(L, 2, world, CAST_RAY, NULL, NULL);
+}
+
+static int l_lovrWorldSphereCastBatch(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  float radius = luax_checkfloat(L, 2);
+  lovrAssert(radius > 0.f, "Radius must be positive");
+  return luax_cast(L, 3, world, CAST_SPHERE, (float[3]) { radius }, NULL);
+}
+
+static int l_lovrWorldBoxCastBatch(lua_State* L) {
+  World* world = luax_checktype(L, 1, World);
+  float size[3], orientation[4];
+  int index = luax_readscale(L, 2, size, 3, NULL);
+  index = luax_readquat(L, index, orientation, NULL);
+  lovrAssert(size[0] > 0.f && size[1] > 0.f && size[2] > 0.f, "Box dimensions must be positive");
+  return luax_cast(L, index, world, CAST_BOX, size, orientation);
+}
+
 static int l_lovrWorldDisableCollisionBetween(lua_State* L) {
   World* world = luax_checktype(L, 1, World);
   const char* tag1 = luaL_checkstring(L, 2);
@@ -260,9 +642,20 @@ const luaL_Reg lovrWorld[] = {
   { "newBoxCollider", l_lovrWorldNewBoxCollider },
   { "newCapsuleCollider", l_lovrWorldNewCapsuleCollider },
   { "newCylinderCollider", l_lovrWorldNewCylinderCollider },
+  { "newMeshCollider", l_lovrWorldNewMeshCollider },
   { "newSphereCollider", l_lovrWorldNewSphereCollider },
   { "destroy", l_lovrWorldDestroy },
   { "update", l_lovrWorldUpdate },
+  { "getColliders", l_lovrWorldGetColliders },
+  { "getPoses", l_lovrWorldGetPoses },
+  { "getStepSize", l_lovrWorldGetStepSize },
+  { "setStepSize", l_lovrWorldSetStepSize },
+  { "getInterpolation", l_lovrWorldGetInterpolation },
+  { "getStats", l_lovrWorldGetStats },
+  { "snapshot", l_lovrWorldSnapshot },
+  { "restore", l_lovrWorldRestore },
+  { "getChecksum", l_lovrWorldGetChecksum },
+  { "checkDeterminism", l_lovrWorldCheckDeterminism },
   { "computeOverlaps", l_lovrWorldComputeOverlaps },
   { "overlaps", l_lovrWorldOverlaps },
   { "collide", l_lovrWorldCollide },
@@ -274,7 +667,15 @@ const luaL_Reg lovrWorld[] = {
   { "setAngularDamping", l_lovrWorldSetAngularDamping },
   { "isSleepingAllowed", l_lovrWorldIsSleepingAllowed },
   { "setSleepingAllowed", l_lovrWorldSetSleepingAllowed },
+  { "getContacts", l_lovrWorldGetContacts },
+  { "getContactProperties", l_lovrWorldGetContactProperties },
+  { "setContactProperties", l_lovrWorldSetContactProperties },
+  { "getThreadCount", l_lovrWorldGetThreadCount },
+  { "setThreadCount", l_lovrWorldSetThreadCount },
   { "raycast", l_lovrWorldRaycast },
+  { "raycastBatch", l_lovrWorldRaycastBatch },
+  { "sphereCastBatch", l_lovrWorldSphereCastBatch },
+  { "boxCastBatch", l_lovrWorldBoxCastBatch },
   { "disableCollisionBetween", l_lovrWorldDisableCollisionBetween },
   { "enableCollisionBetween", l_lovrWorldEnableCollisionBetween },
   { "isCollisionEnabledBetween", l_lovrWorldIsCollisionEnabledBetween },
@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __has_builtin
+#define __has_builtin(x) 0
+#endif
+
+// Acquire loads and release stores for lock-free structures shared between threads.  Compiler
+// detection works the same way as ref.h.  Compare-and-swap and add are full barriers, and a failed
+// compare-and-swap writes the current value to expected.
+
+#ifndef LOVR_ENABLE_THREAD
+
+// Thread module is off, don't use atomics
+
+static inline uint32_t atomic_load32(volatile uint32_t* p) { return *p; }
+static inline void atomic_store32(volatile uint32_t* p, uint32_t x) { *p = x; }
+static inline uint32_t atomic_add32(volatile uint32_t* p, uint32_t x) { return *p += x; }
+static inline uint64_t atomic_load64(volatile uint64_t* p) { return *p; }
+static inline void atomic_store64(volatile uint64_t* p, uint64_t x) { *p = x; }
+static inline bool atomic_cas32(volatile uint32_t* p, uint32_t* expected, uint32_t x) { if (*p == *expected) { *p = x; return true; } *expected = *p; return false; }
+static inline bool atomic_cas64(volatile uint64_t* p, uint64_t* expected, uint64_t x) { if (*p == *expected) { *p = x; return true; } *expected = *p; return false; }
+static inline void atomic_fence(void) {}
+
+#elif defined(_MSC_VER)
+
+// MSVC atomics
+
+#include <intrin.h>
+static inline uint32_t atomic_load32(volatile uint32_t* p) { uint32_t x = *p; _ReadWriteBarrier(); return x; }
+static inline void atomic_store32(volatile uint32_t* p, uint32_t x) { _ReadWriteBarrier(); *p = x; }
+static inline uint32_t atomic_add32(volatile uint32_t* p, uint32_t x) { return (uint32_t) _InterlockedExchangeAdd((volatile long*) p, (long) x) + x; }
+static inline uint64_t atomic_load64(volatile uint64_t* p) { return (uint64_t) _InterlockedCompareExchange64((volatile __int64*) p, 0, 0); }
+static inline void atomic_store64(volatile uint64_t* p, uint64_t x) { _InterlockedExchange64((volatile __int64*) p, (__int64) x); }
+static inline bool atomic_cas32(volatile uint32_t* p, uint32_t* expected, uint32_t x) {
+  uint32_t old = (uint32_t) _InterlockedCompareExchange((volatile long*) p, (long) x, (long) *expected);
+  if (old == *expected) return true;
+  *expected = old;
+  return false;
+}
+static inline bool atomic_cas64(volatile uint64_t* p, uint64_t* expected, uint64_t x) {
+  uint64_t old = (uint64_t) _InterlockedCompareExchange64((volatile __int64*) p, (__int64) x, (__int64) *expected);
+  if (old == *expected) return true;
+  *expected = old;
+  return false;
+}
+static inline void atomic_fence(void) { volatile long x = 0; _InterlockedExchange(&x, 1); }
+
+#elif (defined(__GNUC_MINOR__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))) \
+   || (__has_builtin(__atomic_load_n) && __has_builtin(__atomic_store_n))
+
+// GCC/Clang atomics
+
+static inline uint32_t atomic_load32(volatile uint32_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void atomic_store32(volatile uint32_t* p, uint32_t x) { __atomic_store_n(p, x, __ATOMIC_RELEASE); }
+static inline uint32_t atomic_add32(volatile uint32_t* p, uint32_t x) { return __atomic_add_fetch(p, x, __ATOMIC_SEQ_CST); }
+static inline uint64_t atomic_load64(volatile uint64_t* p) { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+static inline void atomic_store64(volatile uint64_t* p, uint64_t x) { __atomic_store_n(p, x, __ATOMIC_RELEASE); }
+static inline bool atomic_cas32(volatile uint32_t* p, uint32_t* expected, uint32_t x) { return __atomic_compare_exchange_n(p, expected, x, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE); }
+static inline bool atomic_cas64(volatile uint64_t* p, uint64_t* expected, uint64_t x) { return __atomic_compare_exchange_n(p, expected, x, false, __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE); }
+static inline void atomic_fence(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+#else
+
+// No known compiler-specific atomics-- fall back to C11 atomics
+
+#include <stdatomic.h>
+static inline uint32_t atomic_load32(volatile uint32_t* p) { return atomic_load_explicit((volatile _Atomic(uint32_t)*) p, memory_order_acquire); }
+static inline void atomic_store32(volatile uint32_t* p, uint32_t x) { atomic_store_explicit((volatile _Atomic(uint32_t)*) p, x, memory_order_release); }
+static inline uint32_t atomic_add32(volatile uint32_t* p, uint32_t x) { return atomic_fetch_add((volatile _Atomic(uint32_t)*) p, x) + x; }
+static inline uint64_t atomic_load64(volatile uint64_t* p) { return atomic_load_explicit((volatile _Atomic(uint64_t)*) p, memory_order_acquire); }
+static inline void atomic_store64(volatile uint64_t* p, uint64_t x) { atomic_store_explicit((volatile _Atomic(uint64_t)*) p, x, memory_order_release); }
+static inline bool atomic_cas32(volatile uint32_t* p, uint32_t* expected, uint32_t x) { return atomic_compare_exchange_strong((volatile _Atomic(uint32_t)*) p, expected, x); }
+static inline bool atomic_cas64(volatile uint64_t* p, uint64_t* expected, uint64_t x) { return atomic_compare_exchange_strong((volatile _Atomic(uint64_t)*) p, expected, x); }
+static inline void atomic_fence(void) { atomic_thread_fence(memory_order_seq_cst); }
+
+#endif
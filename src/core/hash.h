@@ -1,12 +1,107 @@
 #include "util.h"
 #include <stdint.h>
+#include <string.h>
+
+#pragma once
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+// wyhash (final version 4), it reads 8 bytes at a time and is much faster than FNV1a on anything
+// longer than a few bytes.  Hashes are only used within a single run so they don't need to be
+// stable across platforms or versions.
+
+static LOVR_INLINE void hash_mum(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = (__uint128_t) *a * *b;
+  *a = (uint64_t) r;
+  *b = (uint64_t) (r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  *a = _umul128(*a, *b, b);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static LOVR_INLINE uint64_t hash_mix(uint64_t a, uint64_t b) {
+  hash_mum(&a, &b);
+  return a ^ b;
+}
+
+static LOVR_INLINE uint64_t hash_read64(const uint8_t* p) {
+  uint64_t x;
+  memcpy(&x, p, sizeof(x));
+  return x;
+}
+
+static LOVR_INLINE uint64_t hash_read32(const uint8_t* p) {
+  uint32_t x;
+  memcpy(&x, p, sizeof(x));
+  return x;
+}
 
-// FNV1a
 static LOVR_INLINE uint64_t hash64(const void* data, size_t length) {
-  const uint8_t* bytes = data;
-  uint64_t hash = 0xcbf29ce484222325;
-  for (size_t i = 0; i < length; i++) {
-    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  static const uint64_t s[4] = { 0xa0761d6478bd642f, 0xe7037ed1a0b428db, 0x8ebc6af09c88c6e3, 0x589965cc75374cc3 };
+  const uint8_t* p = data;
+  uint64_t seed = hash_mix(s[0], s[1]);
+  uint64_t a, b;
+
+  if (length <= 16) {
+    if (length >= 4) {
+      a = (hash_read32(p) << 32) | hash_read32(p + ((length >> 3) << 2));
+      b = (hash_read32(p + length - 4) << 32) | hash_read32(p + length - 4 - ((length >> 3) << 2));
+    } else if (length > 0) {
+      a = ((uint64_t) p[0] << 16) | ((uint64_t) p[length >> 1] << 8) | p[length - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = length;
+    if (i > 48) {
+      uint64_t seed1 = seed, seed2 = seed;
+      do {
+        seed = hash_mix(hash_read64(p + 0) ^ s[1], hash_read64(p + 8) ^ seed);
+        seed1 = hash_mix(hash_read64(p + 16) ^ s[2], hash_read64(p + 24) ^ seed1);
+        seed2 = hash_mix(hash_read64(p + 32) ^ s[3], hash_read64(p + 40) ^ seed2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= seed1 ^ seed2;
+    }
+    while (i > 16) {
+      seed = hash_mix(hash_read64(p) ^ s[1], hash_read64(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    a = hash_read64(p + i - 16);
+    b = hash_read64(p + i - 8);
+  }
+
+  a ^= s[1];
+  b ^= seed;
+  hash_mum(&a, &b);
+  return hash_mix(a ^ s[0] ^ length, b ^ s[1]);
+}
+
+// Interned strings carry their hash, so names that get looked up over and over (like builtin shader
+// uniforms) are only hashed once.  The hash is computed on first use.  The string isn't copied, so
+// it has to outlive the istr_t, string literals are the usual case.
+typedef struct {
+  const char* string;
+  uint64_t hash;
+} istr_t;
+
+static LOVR_INLINE uint64_t istr_hash(istr_t* s) {
+  if (!s->hash) {
+    s->hash = hash64(s->string, strlen(s->string));
   }
-  return hash;
+  return s->hash;
 }
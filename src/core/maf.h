@@ -10,6 +10,9 @@
 #define MAF static LOVR_INLINE
 #endif
 
+// The SIMD paths (picked in util.h) do the same operations in the same order as the scalar ones,
+// so results are identical.  Pointers don't have to be aligned.
+
 typedef float* vec3;
 typedef float* quat;
 typedef float* mat4;
@@ -158,12 +161,34 @@ MAF quat quat_fromMat4(quat q, mat4 m) {
 }
 
 MAF quat quat_mul(quat q, quat r) {
+#ifdef LOVR_SSE
+  __m128 vq = _mm_loadu_ps(q);
+  __m128 vr = _mm_loadu_ps(r);
+  __m128 sign = _mm_set_ps(-0.f, 0.f, 0.f, 0.f);
+  __m128 a = _mm_mul_ps(vq, _mm_shuffle_ps(vr, vr, _MM_SHUFFLE(3, 3, 3, 3)));
+  __m128 b = _mm_mul_ps(_mm_shuffle_ps(vq, vq, _MM_SHUFFLE(0, 3, 3, 3)), _mm_shuffle_ps(vr, vr, _MM_SHUFFLE(0, 2, 1, 0)));
+  __m128 c = _mm_mul_ps(_mm_shuffle_ps(vq, vq, _MM_SHUFFLE(1, 0, 2, 1)), _mm_shuffle_ps(vr, vr, _MM_SHUFFLE(1, 1, 0, 2)));
+  __m128 d = _mm_mul_ps(_mm_shuffle_ps(vq, vq, _MM_SHUFFLE(2, 1, 0, 2)), _mm_shuffle_ps(vr, vr, _MM_SHUFFLE(2, 0, 2, 1)));
+  _mm_storeu_ps(q, _mm_sub_ps(_mm_add_ps(_mm_add_ps(a, _mm_xor_ps(b, sign)), _mm_xor_ps(c, sign)), d));
+  return q;
+#elif defined(LOVR_NEON)
+  float bq[4] = { q[3], q[3], q[3], -q[0] }, br[4] = { r[0], r[1], r[2], r[0] };
+  float cq[4] = { q[1], q[2], q[0], -q[1] }, cr[4] = { r[2], r[0], r[1], r[1] };
+  float dq[4] = { q[2], q[0], q[1], q[2] }, dr[4] = { r[1], r[2], r[0], r[2] };
+  float32x4_t a = vmulq_n_f32(vld1q_f32(q), r[3]);
+  float32x4_t b = vmulq_f32(vld1q_f32(bq), vld1q_f32(br));
+  float32x4_t c = vmulq_f32(vld1q_f32(cq), vld1q_f32(cr));
+  float32x4_t d = vmulq_f32(vld1q_f32(dq), vld1q_f32(dr));
+  vst1q_f32(q, vsubq_f32(vaddq_f32(vaddq_f32(a, b), c), d));
+  return q;
+#else
   return quat_set(q,
     q[0] * r[3] + q[3] * r[0] + q[1] * r[2] - q[2] * r[1],
     q[1] * r[3] + q[3] * r[1] + q[2] * r[0] - q[0] * r[2],
     q[2] * r[3] + q[3] * r[2] + q[0] * r[1] - q[1] * r[0],
     q[3] * r[3] - q[0] * r[0] - q[1] * r[1] - q[2] * r[2]
   );
+#endif
 }
 
 MAF float quat_length(quat q) {
@@ -372,6 +397,122 @@ MAF mat4 mat4_transpose(mat4 m) {
   return m;
 }
 
+#ifdef LOVR_SSE
+// 2x2 minors of two rows: [01, 02, 03, 12] and [13, 23, 13, 23]
+static LOVR_INLINE void mat4_minors(__m128 a, __m128 b, __m128* lo, __m128* hi) {
+  *lo = _mm_sub_ps(
+    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 0, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 2, 1))),
+    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 0, 0))));
+  *hi = _mm_sub_ps(
+    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 1, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 3, 3))),
+    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 1, 2, 1))));
+}
+
+// Same cofactor expansion as the scalar version, one output column at a time
+MAF mat4 mat4_invert(mat4 m) {
+  __m128 r0 = _mm_loadu_ps(m + 0);
+  __m128 r1 = _mm_loadu_ps(m + 4);
+  __m128 r2 = _mm_loadu_ps(m + 8);
+  __m128 r3 = _mm_loadu_ps(m + 12);
+
+  __m128 lo0, lo1, hi0, hi1;
+  mat4_minors(r0, r1, &lo0, &lo1);
+  mat4_minors(r2, r3, &hi0, &hi1);
+
+  float LOVR_ALIGN(16) b[16];
+  _mm_store_ps(b + 0, lo0);
+  _mm_store_ps(b + 4, lo1);
+  _mm_store_ps(b + 8, hi0);
+  _mm_store_ps(b + 12, hi1);
+  float d = (b[0] * b[13] - b[1] * b[12] + b[2] * b[11] + b[3] * b[10] - b[4] * b[9] + b[5] * b[8]);
+
+  if (!d) { return m; }
+  __m128 invDet = _mm_set1_ps(1 / d);
+
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  __m128 signA = _mm_set_ps(-0.f, 0.f, -0.f, 0.f);
+  __m128 signB = _mm_set_ps(0.f, -0.f, 0.f, -0.f);
+  __m128 s0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 s1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 s2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 s3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 3, 0, 1));
+
+  // Pairs of minors, one from the top rows and one from the bottom rows
+  __m128 y0 = _mm_shuffle_ps(hi0, lo0, _MM_SHUFFLE(0, 0, 0, 0));
+  __m128 y1 = _mm_shuffle_ps(hi0, lo0, _MM_SHUFFLE(1, 1, 1, 1));
+  __m128 y2 = _mm_shuffle_ps(hi0, lo0, _MM_SHUFFLE(2, 2, 2, 2));
+  __m128 y3 = _mm_shuffle_ps(hi0, lo0, _MM_SHUFFLE(3, 3, 3, 3));
+  __m128 y4 = _mm_shuffle_ps(hi1, lo1, _MM_SHUFFLE(0, 0, 0, 0));
+  __m128 y5 = _mm_shuffle_ps(hi1, lo1, _MM_SHUFFLE(1, 1, 1, 1));
+
+#define MAF_COFACTORS(sign, x, y, z, a, b, c) _mm_mul_ps(_mm_add_ps(_mm_sub_ps(\
+  _mm_mul_ps(_mm_xor_ps(x, sign), a), _mm_mul_ps(_mm_xor_ps(y, sign), b)), _mm_mul_ps(_mm_xor_ps(z, sign), c)), invDet)
+  _mm_storeu_ps(m + 0, MAF_COFACTORS(signA, s1, s2, s3, y5, y4, y3));
+  _mm_storeu_ps(m + 4, MAF_COFACTORS(signB, s0, s2, s3, y5, y2, y1));
+  _mm_storeu_ps(m + 8, MAF_COFACTORS(signA, s0, s1, s3, y4, y2, y0));
+  _mm_storeu_ps(m + 12, MAF_COFACTORS(signB, s0, s1, s2, y3, y1, y0));
+#undef MAF_COFACTORS
+
+  return m;
+}
+#elif defined(LOVR_NEON)
+// Same layout as the SSE version, lanes are moved with ext and set since there's no 4 way shuffle
+static LOVR_INLINE void mat4_minors(float32x4_t a, float32x4_t b, float32x4_t* lo, float32x4_t* hi) {
+  float32x4_t a1 = vextq_f32(a, a, 1);
+  float32x4_t b1 = vextq_f32(b, b, 1);
+  *lo = vsubq_f32(
+    vmulq_f32(vsetq_lane_f32(vgetq_lane_f32(a, 1), vdupq_n_f32(vgetq_lane_f32(a, 0)), 3), vsetq_lane_f32(vgetq_lane_f32(b, 2), b1, 3)),
+    vmulq_f32(vsetq_lane_f32(vgetq_lane_f32(a, 2), a1, 3), vsetq_lane_f32(vgetq_lane_f32(b, 1), vdupq_n_f32(vgetq_lane_f32(b, 0)), 3)));
+  *hi = vsubq_f32(
+    vmulq_n_f32(vcombine_f32(vget_low_f32(a1), vget_low_f32(a1)), vgetq_lane_f32(b, 3)),
+    vmulq_n_f32(vcombine_f32(vget_low_f32(b1), vget_low_f32(b1)), vgetq_lane_f32(a, 3)));
+}
+
+MAF mat4 mat4_invert(mat4 m) {
+  float32x4x4_t r = vld4q_f32(m);
+
+  float32x4_t lo0, lo1, hi0, hi1;
+  mat4_minors(vld1q_f32(m + 0), vld1q_f32(m + 4), &lo0, &lo1);
+  mat4_minors(vld1q_f32(m + 8), vld1q_f32(m + 12), &hi0, &hi1);
+
+  float b[16];
+  vst1q_f32(b + 0, lo0);
+  vst1q_f32(b + 4, lo1);
+  vst1q_f32(b + 8, hi0);
+  vst1q_f32(b + 12, hi1);
+  float d = (b[0] * b[13] - b[1] * b[12] + b[2] * b[11] + b[3] * b[10] - b[4] * b[9] + b[5] * b[8]);
+
+  if (!d) { return m; }
+  float invDet = 1 / d;
+
+  // Negating is exact, so flipping signs with a multiply gives the same result as the xor in SSE
+  float signs[2][4] = { { 1.f, -1.f, 1.f, -1.f }, { -1.f, 1.f, -1.f, 1.f } };
+  float32x4_t signA = vld1q_f32(signs[0]);
+  float32x4_t signB = vld1q_f32(signs[1]);
+  float32x4_t s0 = vrev64q_f32(r.val[0]);
+  float32x4_t s1 = vrev64q_f32(r.val[1]);
+  float32x4_t s2 = vrev64q_f32(r.val[2]);
+  float32x4_t s3 = vrev64q_f32(r.val[3]);
+
+  // Pairs of minors, one from the top rows and one from the bottom rows
+  float32x4_t y0 = vcombine_f32(vdup_n_f32(b[8]), vdup_n_f32(b[0]));
+  float32x4_t y1 = vcombine_f32(vdup_n_f32(b[9]), vdup_n_f32(b[1]));
+  float32x4_t y2 = vcombine_f32(vdup_n_f32(b[10]), vdup_n_f32(b[2]));
+  float32x4_t y3 = vcombine_f32(vdup_n_f32(b[11]), vdup_n_f32(b[3]));
+  float32x4_t y4 = vcombine_f32(vdup_n_f32(b[12]), vdup_n_f32(b[4]));
+  float32x4_t y5 = vcombine_f32(vdup_n_f32(b[13]), vdup_n_f32(b[5]));
+
+#define MAF_COFACTORS(sign, x, y, z, a, b, c) vmulq_n_f32(vaddq_f32(vsubq_f32(\
+  vmulq_f32(vmulq_f32(x, sign), a), vmulq_f32(vmulq_f32(y, sign), b)), vmulq_f32(vmulq_f32(z, sign), c)), invDet)
+  vst1q_f32(m + 0, MAF_COFACTORS(signA, s1, s2, s3, y5, y4, y3));
+  vst1q_f32(m + 4, MAF_COFACTORS(signB, s0, s2, s3, y5, y2, y1));
+  vst1q_f32(m + 8, MAF_COFACTORS(signA, s0, s1, s3, y4, y2, y0));
+  vst1q_f32(m + 12, MAF_COFACTORS(signB, s0, s1, s2, y3, y1, y0));
+#undef MAF_COFACTORS
+
+  return m;
+}
+#else
 MAF mat4 mat4_invert(mat4 m) {
   float a00 = m[0], a01 = m[1], a02 = m[2], a03 = m[3],
         a10 = m[4], a11 = m[5], a12 = m[6], a13 = m[7],
@@ -416,8 +557,45 @@ MAF mat4 mat4_invert(mat4 m) {
 
   return m;
 }
+#endif
 
 MAF mat4 mat4_multiply(mat4 m, mat4 n) {
+#if defined(LOVR_SSE)
+  __m128 c0 = _mm_loadu_ps(m + 0);
+  __m128 c1 = _mm_loadu_ps(m + 4);
+  __m128 c2 = _mm_loadu_ps(m + 8);
+  __m128 c3 = _mm_loadu_ps(m + 12);
+  __m128 columns[4];
+  for (int i = 0; i < 4; i++) {
+    __m128 v = _mm_loadu_ps(n + 4 * i);
+    __m128 x = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)), c0);
+    __m128 y = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), c1);
+    __m128 z = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), c2);
+    __m128 w = _mm_mul_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), c3);
+    columns[i] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x, y), z), w);
+  }
+  for (int i = 0; i < 4; i++) {
+    _mm_storeu_ps(m + 4 * i, columns[i]);
+  }
+  return m;
+#elif defined(LOVR_NEON)
+  float32x4_t c0 = vld1q_f32(m + 0);
+  float32x4_t c1 = vld1q_f32(m + 4);
+  float32x4_t c2 = vld1q_f32(m + 8);
+  float32x4_t c3 = vld1q_f32(m + 12);
+  float32x4_t columns[4];
+  for (int i = 0; i < 4; i++) {
+    float32x4_t x = vmulq_n_f32(c0, n[4 * i + 0]);
+    float32x4_t y = vmulq_n_f32(c1, n[4 * i + 1]);
+    float32x4_t z = vmulq_n_f32(c2, n[4 * i + 2]);
+    float32x4_t w = vmulq_n_f32(c3, n[4 * i + 3]);
+    columns[i] = vaddq_f32(vaddq_f32(vaddq_f32(x, y), z), w);
+  }
+  for (int i = 0; i < 4; i++) {
+    vst1q_f32(m + 4 * i, columns[i]);
+  }
+  return m;
+#else
   float m00 = m[0], m01 = m[1], m02 = m[2], m03 = m[3],
         m10 = m[4], m11 = m[5], m12 = m[6], m13 = m[7],
         m20 = m[8], m21 = m[9], m22 = m[10], m23 = m[11],
@@ -445,9 +623,34 @@ MAF mat4 mat4_multiply(mat4 m, mat4 n) {
   m[14] = n30 * m02 + n31 * m12 + n32 * m22 + n33 * m32;
   m[15] = n30 * m03 + n31 * m13 + n32 * m23 + n33 * m33;
   return m;
+#endif
+}
+
+// Sums the first 3 columns scaled by a vector, the callers add the last column
+#if defined(LOVR_SSE)
+static LOVR_INLINE __m128 mat4_apply(mat4 m, float* v) {
+  __m128 x = _mm_mul_ps(_mm_set1_ps(v[0]), _mm_loadu_ps(m + 0));
+  __m128 y = _mm_mul_ps(_mm_set1_ps(v[1]), _mm_loadu_ps(m + 4));
+  __m128 z = _mm_mul_ps(_mm_set1_ps(v[2]), _mm_loadu_ps(m + 8));
+  return _mm_add_ps(_mm_add_ps(x, y), z);
+}
+#elif defined(LOVR_NEON)
+static LOVR_INLINE float32x4_t mat4_apply(mat4 m, float* v) {
+  float32x4_t x = vmulq_n_f32(vld1q_f32(m + 0), v[0]);
+  float32x4_t y = vmulq_n_f32(vld1q_f32(m + 4), v[1]);
+  float32x4_t z = vmulq_n_f32(vld1q_f32(m + 8), v[2]);
+  return vaddq_f32(vaddq_f32(x, y), z);
 }
+#endif
 
 MAF float* mat4_multiplyVec4(mat4 m, float* v) {
+#if defined(LOVR_SSE)
+  _mm_storeu_ps(v, _mm_add_ps(mat4_apply(m, v), _mm_mul_ps(_mm_set1_ps(v[3]), _mm_loadu_ps(m + 12))));
+  return v;
+#elif defined(LOVR_NEON)
+  vst1q_f32(v, vaddq_f32(mat4_apply(m, v), vmulq_n_f32(vld1q_f32(m + 12), v[3])));
+  return v;
+#else
   float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + v[3] * m[12];
   float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + v[3] * m[13];
   float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + v[3] * m[14];
@@ -457,6 +660,7 @@ MAF float* mat4_multiplyVec4(mat4 m, float* v) {
   v[2] = z;
   v[3] = w;
   return v;
+#endif
 }
 
 MAF mat4 mat4_translate(mat4 m, float x, float y, float z) {
@@ -603,6 +807,13 @@ MAF mat4 mat4_lookAt(mat4 m, vec3 from, vec3 to, vec3 up) {
 }
 
 MAF void mat4_transform(mat4 m, vec3 v) {
+#if defined(LOVR_SSE)
+  __m128 p = _mm_add_ps(mat4_apply(m, v), _mm_loadu_ps(m + 12));
+  _mm_storeu_ps(v, _mm_div_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3))));
+#elif defined(LOVR_NEON) && defined(__aarch64__)
+  float32x4_t p = vaddq_f32(mat4_apply(m, v), vld1q_f32(m + 12));
+  vst1q_f32(v, vdivq_f32(p, vdupq_laneq_f32(p, 3)));
+#else
   float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8] + m[12];
   float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9] + m[13];
   float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10] + m[14];
@@ -611,6 +822,7 @@ MAF void mat4_transform(mat4 m, vec3 v) {
   v[1] = y / w;
   v[2] = z / w;
   v[3] = w / w;
+#endif
 }
 
 MAF void mat4_transform_project(mat4 m, vec3 v) {
@@ -625,6 +837,11 @@ MAF void mat4_transform_project(mat4 m, vec3 v) {
 }
 
 MAF void mat4_transformDirection(mat4 m, vec3 v) {
+#if defined(LOVR_SSE)
+  _mm_storeu_ps(v, mat4_apply(m, v));
+#elif defined(LOVR_NEON)
+  vst1q_f32(v, mat4_apply(m, v));
+#else
   float x = v[0] * m[0] + v[1] * m[4] + v[2] * m[8];
   float y = v[0] * m[1] + v[1] * m[5] + v[2] * m[9];
   float z = v[0] * m[2] + v[1] * m[6] + v[2] * m[10];
@@ -633,4 +850,5 @@ MAF void mat4_transformDirection(mat4 m, vec3 v) {
   v[1] = y;
   v[2] = z;
   v[3] = w;
+#endif
 }
@@ -80,6 +80,7 @@ bool lovrPlatformIsMouseDown(MouseButton button);
 bool lovrPlatformIsKeyDown(KeyCode key);
 void lovrPlatformSleep(double seconds);
 int lovrPlatformGetExecutablePath(char* dest, uint32_t size);
+uint32_t lovrPlatformGetCoreCount(void);
 #ifdef _WIN32
 #include <windows.h>
 HANDLE lovrPlatformGetWindow(void);
@@ -94,3 +94,8 @@ int lovrPlatformGetExecutablePath(char* dest, uint32_t size) {
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 getProcAddressProc lovrGetProcAddress = eglGetProcAddress;
+
+uint32_t lovrPlatformGetCoreCount() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint32_t) count : 1;
+}
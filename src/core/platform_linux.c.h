@@ -23,3 +23,8 @@ int lovrPlatformGetExecutablePath(char* dest, uint32_t size) {
   }
   return 1;
 }
+
+uint32_t lovrPlatformGetCoreCount() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint32_t) count : 1;
+}
@@ -19,3 +19,8 @@ void lovrPlatformOpenConsole() {
 int lovrPlatformGetExecutablePath(char* dest, uint32_t size) {
   return _NSGetExecutablePath(dest, &size);
 }
+
+uint32_t lovrPlatformGetCoreCount() {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (uint32_t) count : 1;
+}
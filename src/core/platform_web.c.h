@@ -18,3 +18,7 @@ int lovrPlatformGetExecutablePath(char* dest, uint32_t size) {
 void lovrPlatformOpenConsole() {
   //
 }
+
+uint32_t lovrPlatformGetCoreCount() {
+  return 1;
+}
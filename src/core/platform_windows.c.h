@@ -23,3 +23,9 @@ void lovrPlatformOpenConsole() {
 int lovrPlatformGetExecutablePath(char* dest, uint32_t size) {
   return !GetModuleFileName(NULL, dest, size);
 }
+
+uint32_t lovrPlatformGetCoreCount() {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+}
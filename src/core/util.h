@@ -22,6 +22,16 @@
 #define LOVR_INLINE inline
 #endif
 
+// SIMD paths are picked at compile time.  SSE2 is always there on x64, NEON is optional on 32 bit
+// ARM but always there on 64 bit ARM.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LOVR_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LOVR_NEON
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979
 #endif
@@ -3,22 +3,51 @@
 #include "data/audioStream.h"
 #include "core/arr.h"
 #include "core/maf.h"
+#include "core/platform.h"
 #include "core/ref.h"
 #include "util.h"
+#include <math.h>
 #include <stdlib.h>
 #include <AL/al.h>
 #include <AL/alc.h>
 #include <AL/alext.h>
+#ifdef LOVR_ENABLE_THREAD
+#include "lib/tinycthread/tinycthread.h"
+#endif
 
 static struct {
   bool initialized;
   bool spatialized;
+  MixerType mixer;
+  AudioSink* sink;
+  uint32_t sampleRate;
+  uint32_t bufferCount;
+  uint32_t bufferSize;
+  uint32_t underruns;
+  uint32_t voiceCount;
+  uint32_t stolen;
+  float cullThreshold;
+  double time;
+  ALuint voices[MAX_VOICES];
+  struct Source* owners[MAX_VOICES];
   ALCdevice* device;
   ALCcontext* context;
+  float volume;
+  float dopplerFactor;
+  float speedOfSound;
   float LOVR_ALIGN(16) orientation[4];
   float LOVR_ALIGN(16) position[4];
   float LOVR_ALIGN(16) velocity[4];
   arr_t(Source*) sources;
+  arr_t(Source*) streams;
+#ifdef LOVR_ENABLE_THREAD
+  thrd_t decoder;
+  mtx_t lock;
+  cnd_t wake;
+  cnd_t decoded;
+  Source* decoding;
+  bool running;
+#endif
 } state;
 
 ALenum lovrAudioConvertFormat(uint32_t bitDepth, uint32_t channelCount) {
@@ -35,9 +64,81 @@ ALenum lovrAudioConvertFormat(uint32_t bitDepth, uint32_t channelCount) {
   return 0;
 }
 
-bool lovrAudioInit() {
+#ifdef LOVR_ENABLE_THREAD
+// Decodes streams ahead of playback, waking up when a stream consumes audio or every few milliseconds.
+// The lock only guards the list of streams, each stream is decoded with it released so the main
+// thread isn't blocked, and removing a stream waits until the decoder is done with it.
+static int lovrAudioDecodeThread(void* userdata) {
+  mtx_lock(&state.lock);
+  while (state.running) {
+    for (size_t i = 0; i < state.streams.length; i++) {
+      Source* source = state.decoding = state.streams.data[i];
+      mtx_unlock(&state.lock);
+      lovrSourceDecode(source);
+      mtx_lock(&state.lock);
+      state.decoding = NULL;
+      cnd_broadcast(&state.decoded);
+    }
+
+    struct timespec until;
+    timespec_get(&until, TIME_UTC);
+    until.tv_nsec += 5000000;
+    if (until.tv_nsec >= 1000000000) {
+      until.tv_nsec -= 1000000000;
+      until.tv_sec++;
+    }
+
+    cnd_timedwait(&state.wake, &state.lock, &until);
+  }
+  mtx_unlock(&state.lock);
+  return 0;
+}
+#endif
+
+// Started once everything else is set up, so a failed init doesn't leave a decoder running
+static void startDecoder() {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_init(&state.lock, mtx_plain);
+  cnd_init(&state.wake);
+  cnd_init(&state.decoded);
+  state.running = true;
+  lovrAssert(thrd_create(&state.decoder, lovrAudioDecodeThread, NULL) == thrd_success, "Could not create audio thread");
+#endif
+}
+
+bool lovrAudioInit(MixerType mixer, SinkType sink, uint32_t sampleRate, uint32_t bufferCount, uint32_t bufferSize, uint32_t voiceCount, const char* filename) {
   if (state.initialized) return false;
 
+  lovrAssert(bufferCount > 0 && bufferCount <= MAX_SOURCE_BUFFERS, "Audio buffer count must be between 1 and %d", MAX_SOURCE_BUFFERS);
+  lovrAssert(bufferSize > 0, "Audio buffer size must be positive");
+  lovrAssert(voiceCount > 0 && voiceCount <= MAX_VOICES, "Audio voice count must be between 1 and %d", MAX_VOICES);
+  state.mixer = mixer;
+  state.sampleRate = sampleRate;
+  state.bufferCount = bufferCount;
+  state.bufferSize = bufferSize;
+  state.voiceCount = voiceCount;
+  state.cullThreshold = .001f;
+  state.time = lovrPlatformGetTime();
+  state.volume = 1.f;
+  state.dopplerFactor = 1.f;
+  state.speedOfSound = 343.3f;
+  quat_set(state.orientation, 0.f, 0.f, 0.f, 1.f);
+  arr_init(&state.sources);
+  arr_init(&state.streams);
+
+  if (mixer == MIXER_SOFTWARE) {
+    switch (sink) {
+      case SINK_OPENAL: state.sink = &lovrAudioOpenALSink; break;
+      case SINK_NULL: state.sink = &lovrAudioNullSink; break;
+      case SINK_FILE: state.sink = &lovrAudioFileSink; break;
+      default: lovrThrow("Unreachable");
+    }
+
+    state.sink->init(sampleRate, filename);
+    startDecoder();
+    return state.initialized = true;
+  }
+
   ALCdevice* device = alcOpenDevice(NULL);
   lovrAssert(device, "Unable to open default audio device");
 
@@ -56,50 +157,273 @@ bool lovrAudioInit() {
   }
 #endif
 
+  // Voices are allocated up front, the device might support fewer than requested
+  for (uint32_t i = 0; i < voiceCount; i++) {
+    alGenSources(1, &state.voices[i]);
+    if (alGetError() != AL_NO_ERROR) {
+      lovrAssert(i > 0, "Unable to create any OpenAL sources");
+      state.voiceCount = i;
+      break;
+    }
+  }
+
   state.device = device;
   state.context = context;
-  arr_init(&state.sources);
+  startDecoder();
   return state.initialized = true;
 }
 
 void lovrAudioDestroy() {
   if (!state.initialized) return;
-  alcMakeContextCurrent(NULL);
-  alcDestroyContext(state.context);
-  alcCloseDevice(state.device);
+#ifdef LOVR_ENABLE_THREAD
+  mtx_lock(&state.lock);
+  state.running = false;
+  cnd_signal(&state.wake);
+  mtx_unlock(&state.lock);
+  thrd_join(state.decoder, NULL);
+#endif
+  for (uint32_t i = 0; i < state.voiceCount; i++) {
+    if (state.owners[i]) {
+      lovrAudioReleaseVoice(state.owners[i]);
+    }
+  }
+  if (state.sink) {
+    state.sink->destroy();
+  } else {
+    alDeleteSources(state.voiceCount, state.voices);
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(state.context);
+    alcCloseDevice(state.device);
+  }
   for (size_t i = 0; i < state.sources.length; i++) {
     lovrRelease(Source, state.sources.data[i]);
   }
   arr_free(&state.sources);
+  arr_free(&state.streams);
+#ifdef LOVR_ENABLE_THREAD
+  mtx_destroy(&state.lock);
+  cnd_destroy(&state.wake);
+  cnd_destroy(&state.decoded);
+#endif
   memset(&state, 0, sizeof(state));
 }
 
-void lovrAudioUpdate() {
-  for (size_t i = state.sources.length; i-- > 0;) {
+// Computes the gain of a Source using the inverse distance clamped falloff model (the OpenAL
+// default), and where it is from left (-1) to right (1) relative to the listener
+static float lovrAudioGetGain(Source* source, float* pan) {
+  float volume = lovrSourceGetVolume(source);
+
+  if (lovrSourceGetChannelCount(source) != 1) {
+    *pan = 0.f;
+    return volume * state.volume;
+  }
+
+  float position[4], inverse[4];
+  lovrSourceGetPosition(source, position);
+  if (!lovrSourceIsRelative(source)) {
+    vec3_sub(position, state.position);
+    quat_conjugate(quat_init(inverse, state.orientation));
+    quat_rotate(inverse, position);
+  }
+
+  float reference, maxDistance, rolloff, minVolume, maxVolume;
+  lovrSourceGetFalloff(source, &reference, &maxDistance, &rolloff);
+  lovrSourceGetVolumeLimits(source, &minVolume, &maxVolume);
+
+  float distance = vec3_length(position);
+  float clamped = CLAMP(distance, reference, maxDistance);
+  float denominator = reference + rolloff * (clamped - reference);
+  float attenuation = denominator > 0.f ? reference / denominator : 1.f;
+  *pan = distance > 0.f ? position[0] / distance : 0.f;
+  return CLAMP(volume * attenuation, minVolume, maxVolume) * state.volume;
+}
+
+// Equal power panning for mono sources, stereo sources use the gain for both channels
+static void lovrAudioGetGains(Source* source, float* left, float* right) {
+  float pan;
+  float gain = lovrAudioGetGain(source, &pan);
+
+  if (lovrSourceGetChannelCount(source) != 1) {
+    *left = *right = gain;
+    return;
+  }
+
+  float angle = (pan + 1.f) * (float) M_PI / 4.f;
+  *left = gain * cosf(angle);
+  *right = gain * sinf(angle);
+}
+
+// Voices
+
+// Paused sources are the first to lose their voice
+static float lovrAudioGetAudibility(Source* source) {
+  float pan;
+  return lovrSourceIsPlaying(source) ? lovrAudioGetGain(source, &pan) : 0.f;
+}
+
+// How much quieter a Source with the same priority has to be before its voice gets stolen, so two
+// Sources at about the same volume don't keep taking the voice from each other
+#define VOICE_STEAL_MARGIN 1.5f
+
+// Gives the Source a free voice, or steals one from a Source with a lower priority (or the same
+// priority but quieter).  Sources too quiet to hear don't get a voice and play virtually instead.
+bool lovrAudioClaimVoice(Source* source) {
+  float audibility = lovrAudioGetAudibility(source);
+
+  if (audibility < state.cullThreshold) {
+    return false;
+  }
+
+  uint32_t voice = 0;
+  for (uint32_t i = 0; i < state.voiceCount; i++) {
+    if (!state.owners[i]) {
+      voice = i + 1;
+      break;
+    }
+  }
+
+  if (!voice) {
+    int priority = lovrSourceGetPriority(source);
+    float weakest = audibility / VOICE_STEAL_MARGIN;
+
+    for (uint32_t i = 0; i < state.voiceCount; i++) {
+      Source* owner = state.owners[i];
+      int ownerPriority = lovrSourceGetPriority(owner);
+      float ownerAudibility = lovrAudioGetAudibility(owner);
+      if (ownerPriority < priority || (ownerPriority == priority && ownerAudibility < weakest)) {
+        priority = ownerPriority;
+        weakest = ownerAudibility;
+        voice = i + 1;
+      }
+    }
+
+    if (!voice) {
+      return false;
+    }
+
+    lovrAudioReleaseVoice(state.owners[voice - 1]);
+    state.stolen++;
+  }
+
+  state.owners[voice - 1] = source;
+  lovrSourceAttach(source, voice, state.mixer == MIXER_OPENAL ? state.voices[voice - 1] : 0);
+  return true;
+}
+
+void lovrAudioReleaseVoice(Source* source) {
+  uint32_t voice = lovrSourceGetVoice(source);
+  if (!state.initialized || !voice) return;
+  lovrSourceDetach(source);
+  state.owners[voice - 1] = NULL;
+}
+
+// Culls voices that became inaudible and gives voices to virtual sources that can be heard again
+static void lovrAudioUpdateVoices() {
+  for (size_t i = 0; i < state.sources.length; i++) {
     Source* source = state.sources.data[i];
 
-    if (lovrSourceGetType(source) == SOURCE_STATIC) {
+    if (!lovrSourceIsPlaying(source)) {
       continue;
     }
 
-    uint32_t id = lovrSourceGetId(source);
-    bool isStopped = lovrSourceIsStopped(source);
-    ALint processed;
-    alGetSourcei(id, AL_BUFFERS_PROCESSED, &processed);
+    if (lovrSourceGetVoice(source)) {
+      if (lovrAudioGetAudibility(source) < state.cullThreshold) {
+        lovrAudioReleaseVoice(source);
+      }
+    } else {
+      lovrAudioClaimVoice(source);
+    }
+  }
+}
+
+void lovrAudioGetVoiceStats(uint32_t* voices, uint32_t* active, uint32_t* virtual, uint32_t* stolen) {
+  *voices = state.voiceCount;
+  *active = 0;
+  *virtual = 0;
+  *stolen = state.stolen;
+  for (size_t i = 0; i < state.sources.length; i++) {
+    Source* source = state.sources.data[i];
+    if (lovrSourceIsPlaying(source)) {
+      if (lovrSourceGetVoice(source)) {
+        ++*active;
+      } else {
+        ++*virtual;
+      }
+    }
+  }
+}
+
+float lovrAudioGetCullThreshold() {
+  return state.cullThreshold;
+}
+
+void lovrAudioSetCullThreshold(float threshold) {
+  state.cullThreshold = threshold;
+}
+
+// Mixes all playing sources and writes the result to the sink, only used by the software mixer
+void lovrAudioRender(uint32_t frames) {
+  lovrAssert(state.mixer == MIXER_SOFTWARE, "Audio can only be rendered when using the software mixer");
+  float LOVR_ALIGN(16) mix[2 * MIXER_FRAMES];
+  int16_t LOVR_ALIGN(16) output[2 * MIXER_FRAMES];
+
+  lovrAudioUpdateVoices();
+
+  while (frames > 0) {
+    uint32_t count = MIN(frames, MIXER_FRAMES);
+    memset(mix, 0, 2 * count * sizeof(float));
 
-    if (processed) {
-      ALuint buffers[SOURCE_BUFFERS];
-      alSourceUnqueueBuffers(id, processed, buffers);
-      lovrSourceStream(source, buffers, processed);
-      if (isStopped) {
-        alSourcePlay(id);
+    for (size_t i = state.sources.length; i-- > 0;) {
+      Source* source = state.sources.data[i];
+      bool playing;
+
+      if (lovrSourceGetVoice(source)) {
+        float left, right;
+        lovrAudioGetGains(source, &left, &right);
+        playing = lovrSourceMix(source, mix, count, state.sampleRate, left, right);
+      } else {
+        playing = lovrSourceAdvance(source, count / (double) state.sampleRate);
+      }
+
+      if (!playing) {
+        arr_splice(&state.sources, i, 1);
+        lovrRelease(Source, source);
       }
-    } else if (isStopped) {
-      lovrAudioStreamRewind(lovrSourceGetStream(source));
+    }
+
+    lovrMixerConvert(output, mix, 2 * count);
+    state.sink->write(output, count);
+    frames -= count;
+  }
+#ifdef LOVR_ENABLE_THREAD
+  cnd_signal(&state.wake);
+#endif
+}
+
+void lovrAudioUpdate() {
+  if (state.mixer == MIXER_SOFTWARE) {
+    lovrAudioRender(state.sink->getFrames());
+    return;
+  }
+
+  double time = lovrPlatformGetTime();
+  double dt = time - state.time;
+  state.time = time;
+
+  lovrAudioUpdateVoices();
+
+  for (size_t i = state.sources.length; i-- > 0;) {
+    Source* source = state.sources.data[i];
+
+    if (!lovrSourceUpdate(source, dt)) {
       arr_splice(&state.sources, i, 1);
       lovrRelease(Source, source);
     }
   }
+
+#ifdef LOVR_ENABLE_THREAD
+  cnd_signal(&state.wake);
+#endif
 }
 
 void lovrAudioAdd(Source* source) {
@@ -109,9 +433,69 @@ void lovrAudioAdd(Source* source) {
   }
 }
 
+static bool lovrAudioHasStream(Source* source) {
+  for (size_t i = 0; i < state.streams.length; i++) {
+    if (state.streams.data[i] == source) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Streams are decoded by the audio thread while they have a voice.  Adding a stream that's already
+// there just wakes up the decoder.
+void lovrAudioAddStream(Source* source) {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_lock(&state.lock);
+#endif
+  if (!lovrAudioHasStream(source)) {
+    arr_push(&state.streams, source);
+  }
+#ifdef LOVR_ENABLE_THREAD
+  cnd_signal(&state.wake);
+  mtx_unlock(&state.lock);
+#endif
+}
+
+// Once this returns the decoder is done with the stream
+void lovrAudioRemoveStream(Source* source) {
+  if (!state.initialized) return;
+#ifdef LOVR_ENABLE_THREAD
+  mtx_lock(&state.lock);
+#endif
+  for (size_t i = 0; i < state.streams.length; i++) {
+    if (state.streams.data[i] == source) {
+      arr_splice(&state.streams, i, 1);
+      break;
+    }
+  }
+#ifdef LOVR_ENABLE_THREAD
+  while (state.decoding == source) {
+    cnd_wait(&state.decoded, &state.lock);
+  }
+  mtx_unlock(&state.lock);
+#endif
+}
+
+void lovrAudioCountUnderrun() {
+  state.underruns++;
+}
+
+uint32_t lovrAudioGetBufferCount() {
+  return state.bufferCount;
+}
+
+uint32_t lovrAudioGetBufferSize() {
+  return state.bufferSize;
+}
+
+uint32_t lovrAudioGetUnderruns() {
+  return state.underruns;
+}
+
 void lovrAudioGetDopplerEffect(float* factor, float* speedOfSound) {
-  alGetFloatv(AL_DOPPLER_FACTOR, factor);
-  alGetFloatv(AL_SPEED_OF_SOUND, speedOfSound);
+  *factor = state.dopplerFactor;
+  *speedOfSound = state.speedOfSound;
 }
 
 void lovrAudioGetMicrophoneNames(const char* names[MAX_MICROPHONES], uint32_t* count) {
@@ -136,9 +520,11 @@ void lovrAudioGetVelocity(vec3 velocity) {
 }
 
 float lovrAudioGetVolume() {
-  float volume;
-  alGetListenerf(AL_GAIN, &volume);
-  return volume;
+  return state.volume;
+}
+
+MixerType lovrAudioGetMixer() {
+  return state.mixer;
 }
 
 bool lovrAudioHas(Source* source) {
@@ -174,16 +560,23 @@ void lovrAudioRewind() {
 }
 
 void lovrAudioSetDopplerEffect(float factor, float speedOfSound) {
-  alDopplerFactor(factor);
-  alSpeedOfSound(speedOfSound);
+  state.dopplerFactor = factor;
+  state.speedOfSound = speedOfSound;
+  if (state.mixer == MIXER_OPENAL) {
+    alDopplerFactor(factor);
+    alSpeedOfSound(speedOfSound);
+  }
 }
 
 void lovrAudioSetOrientation(quat orientation) {
+  quat_init(state.orientation, orientation);
+  if (state.mixer != MIXER_OPENAL) {
+    return;
+  }
 
   // Rotate the unit forward/up vectors by the quaternion derived from the specified angle/axis
   float f[4] = { 0.f, 0.f, -1.f };
   float u[4] = { 0.f, 1.f,  0.f };
-  quat_init(state.orientation, orientation);
   quat_rotate(state.orientation, f);
   quat_rotate(state.orientation, u);
 
@@ -194,16 +587,23 @@ void lovrAudioSetOrientation(quat orientation) {
 
 void lovrAudioSetPosition(vec3 position) {
   vec3_init(state.position, position);
-  alListenerfv(AL_POSITION, position);
+  if (state.mixer == MIXER_OPENAL) {
+    alListenerfv(AL_POSITION, position);
+  }
 }
 
 void lovrAudioSetVelocity(vec3 velocity) {
   vec3_init(state.velocity, velocity);
-  alListenerfv(AL_VELOCITY, velocity);
+  if (state.mixer == MIXER_OPENAL) {
+    alListenerfv(AL_VELOCITY, velocity);
+  }
 }
 
 void lovrAudioSetVolume(float volume) {
-  alListenerf(AL_GAIN, volume);
+  state.volume = volume;
+  if (state.mixer == MIXER_OPENAL) {
+    alListenerf(AL_GAIN, volume);
+  }
 }
 
 void lovrAudioStop() {
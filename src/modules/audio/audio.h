@@ -1,24 +1,44 @@
+#include "audio/mixer.h"
 #include <stdbool.h>
 #include <stdint.h>
 
 #pragma once
 
 #define MAX_MICROPHONES 8
+#define MAX_VOICES 256
 
 struct Source;
 
+typedef enum {
+  MIXER_OPENAL,
+  MIXER_SOFTWARE
+} MixerType;
+
 int lovrAudioConvertFormat(uint32_t bitDepth, uint32_t channelCount);
 
-bool lovrAudioInit(void);
+bool lovrAudioInit(MixerType mixer, SinkType sink, uint32_t sampleRate, uint32_t bufferCount, uint32_t bufferSize, uint32_t voiceCount, const char* filename);
 void lovrAudioDestroy(void);
 void lovrAudioUpdate(void);
+void lovrAudioRender(uint32_t frames);
 void lovrAudioAdd(struct Source* source);
+void lovrAudioAddStream(struct Source* source);
+void lovrAudioRemoveStream(struct Source* source);
+void lovrAudioCountUnderrun(void);
+bool lovrAudioClaimVoice(struct Source* source);
+void lovrAudioReleaseVoice(struct Source* source);
+void lovrAudioGetVoiceStats(uint32_t* voices, uint32_t* active, uint32_t* virtual, uint32_t* stolen);
+float lovrAudioGetCullThreshold(void);
+void lovrAudioSetCullThreshold(float threshold);
+uint32_t lovrAudioGetBufferCount(void);
+uint32_t lovrAudioGetBufferSize(void);
+uint32_t lovrAudioGetUnderruns(void);
 void lovrAudioGetDopplerEffect(float* factor, float* speedOfSound);
 void lovrAudioGetMicrophoneNames(const char* names[MAX_MICROPHONES], uint32_t* count);
 void lovrAudioGetOrientation(float* orientation);
 void lovrAudioGetPosition(float* position);
 void lovrAudioGetVelocity(float* velocity);
 float lovrAudioGetVolume(void);
+MixerType lovrAudioGetMixer(void);
 bool lovrAudioHas(struct Source* source);
 bool lovrAudioIsSpatialized(void);
 void lovrAudioPause(void);
@@ -0,0 +1,110 @@
+#include "audio/mixer.h"
+#include "core/util.h"
+#include <string.h>
+
+// Linear resampler, position is relative to the first input frame and input needs one extra frame
+// past the last one that gets read, for interpolation.  Positions are computed in double precision
+// from the start of the block so the SIMD and scalar paths produce identical results.
+void lovrMixerResample(float* output, const float* input, uint32_t frames, double position, double step) {
+  uint32_t i = 0;
+
+  if (step == 1. && position == (double) (uint32_t) position) {
+    memcpy(output, input + (uint32_t) position, frames * sizeof(float));
+    return;
+  }
+
+#if defined(LOVR_SSE) || defined(LOVR_NEON)
+  for (; i + 4 <= frames; i += 4) {
+    float LOVR_ALIGN(16) a[4], b[4], t[4];
+    for (uint32_t j = 0; j < 4; j++) {
+      double p = position + (i + j) * step;
+      uint32_t k = (uint32_t) p;
+      a[j] = input[k];
+      b[j] = input[k + 1];
+      t[j] = (float) (p - k);
+    }
+#ifdef LOVR_SSE
+    __m128 va = _mm_load_ps(a);
+    __m128 vb = _mm_load_ps(b);
+    __m128 vt = _mm_load_ps(t);
+    _mm_storeu_ps(output + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vt)));
+#else
+    float32x4_t va = vld1q_f32(a);
+    float32x4_t vb = vld1q_f32(b);
+    float32x4_t vt = vld1q_f32(t);
+    vst1q_f32(output + i, vmlaq_f32(va, vsubq_f32(vb, va), vt));
+#endif
+  }
+#endif
+
+  for (; i < frames; i++) {
+    double p = position + i * step;
+    uint32_t k = (uint32_t) p;
+    float t = (float) (p - k);
+    output[i] = input[k] + (input[k + 1] - input[k]) * t;
+  }
+}
+
+// Adds a mono signal to an interleaved stereo buffer, with a gain for each output channel
+void lovrMixerAccumulate(float* output, const float* input, uint32_t frames, float left, float right) {
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE)
+  __m128 l = _mm_set1_ps(left);
+  __m128 r = _mm_set1_ps(right);
+  for (; i + 4 <= frames; i += 4) {
+    __m128 x = _mm_loadu_ps(input + i);
+    __m128 xl = _mm_mul_ps(x, l);
+    __m128 xr = _mm_mul_ps(x, r);
+    float* out = output + 2 * i;
+    _mm_storeu_ps(out + 0, _mm_add_ps(_mm_loadu_ps(out + 0), _mm_unpacklo_ps(xl, xr)));
+    _mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(xl, xr)));
+  }
+#elif defined(LOVR_NEON)
+  for (; i + 4 <= frames; i += 4) {
+    float32x4_t x = vld1q_f32(input + i);
+    float32x4x2_t lr = vld2q_f32(output + 2 * i);
+    lr.val[0] = vmlaq_n_f32(lr.val[0], x, left);
+    lr.val[1] = vmlaq_n_f32(lr.val[1], x, right);
+    vst2q_f32(output + 2 * i, lr);
+  }
+#endif
+
+  for (; i < frames; i++) {
+    output[2 * i + 0] += input[i] * left;
+    output[2 * i + 1] += input[i] * right;
+  }
+}
+
+// Converts floating point samples to 16 bit, clamping anything outside of [-1, 1]
+void lovrMixerConvert(int16_t* output, const float* input, uint32_t count) {
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE)
+  __m128 lo = _mm_set1_ps(-1.f);
+  __m128 hi = _mm_set1_ps(1.f);
+  __m128 scale = _mm_set1_ps(32767.f);
+  for (; i + 8 <= count; i += 8) {
+    __m128 x = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 0), lo), hi);
+    __m128 y = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), lo), hi);
+    __m128i a = _mm_cvttps_epi32(_mm_mul_ps(x, scale));
+    __m128i b = _mm_cvttps_epi32(_mm_mul_ps(y, scale));
+    _mm_storeu_si128((__m128i*) (output + i), _mm_packs_epi32(a, b));
+  }
+#elif defined(LOVR_NEON)
+  float32x4_t lo = vdupq_n_f32(-1.f);
+  float32x4_t hi = vdupq_n_f32(1.f);
+  for (; i + 8 <= count; i += 8) {
+    float32x4_t x = vminq_f32(vmaxq_f32(vld1q_f32(input + i + 0), lo), hi);
+    float32x4_t y = vminq_f32(vmaxq_f32(vld1q_f32(input + i + 4), lo), hi);
+    int32x4_t a = vcvtq_s32_f32(vmulq_n_f32(x, 32767.f));
+    int32x4_t b = vcvtq_s32_f32(vmulq_n_f32(y, 32767.f));
+    vst1q_s16(output + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    float x = CLAMP(input[i], -1.f, 1.f);
+    output[i] = (int16_t) (x * 32767.f);
+  }
+}
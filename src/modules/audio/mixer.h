@@ -0,0 +1,33 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#pragma once
+
+// Number of output frames mixed at a time
+#define MIXER_FRAMES 256
+
+// Maximum number of input frames a Source can read for one block, limits the pitch of a block to 4
+#define MIXER_INPUT_FRAMES (4 * MIXER_FRAMES + 2)
+
+typedef enum {
+  SINK_OPENAL,
+  SINK_NULL,
+  SINK_FILE
+} SinkType;
+
+// Sinks consume interleaved stereo 16 bit frames produced by the software mixer
+typedef struct AudioSink {
+  SinkType type;
+  bool (*init)(uint32_t sampleRate, const char* filename);
+  void (*destroy)(void);
+  uint32_t (*getFrames)(void);
+  void (*write)(const int16_t* frames, uint32_t count);
+} AudioSink;
+
+extern AudioSink lovrAudioOpenALSink;
+extern AudioSink lovrAudioNullSink;
+extern AudioSink lovrAudioFileSink;
+
+void lovrMixerResample(float* output, const float* input, uint32_t frames, double position, double step);
+void lovrMixerAccumulate(float* output, const float* input, uint32_t frames, float left, float right);
+void lovrMixerConvert(int16_t* output, const float* input, uint32_t count);
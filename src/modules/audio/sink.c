@@ -0,0 +1,189 @@
+#include "audio/mixer.h"
+#include "core/platform.h"
+#include "core/util.h"
+#include <stdio.h>
+#include <string.h>
+#include <AL/al.h>
+#include <AL/alc.h>
+
+#define SINK_BUFFERS 4
+#define SINK_BUFFER_FRAMES 1024
+
+// OpenAL sink, streams the mix through a single OpenAL source
+
+static struct {
+  ALCdevice* device;
+  ALCcontext* context;
+  ALuint source;
+  ALuint buffers[SINK_BUFFERS];
+  ALuint available[SINK_BUFFERS];
+  uint32_t availableCount;
+  uint32_t sampleRate;
+  uint32_t staged;
+  int16_t staging[2 * SINK_BUFFER_FRAMES];
+} openal;
+
+static bool openal_init(uint32_t sampleRate, const char* filename) {
+  openal.device = alcOpenDevice(NULL);
+  lovrAssert(openal.device, "Unable to open default audio device");
+
+  openal.context = alcCreateContext(openal.device, (ALCint[]) { ALC_FREQUENCY, sampleRate, 0 });
+  if (!openal.context || !alcMakeContextCurrent(openal.context) || alcGetError(openal.device) != ALC_NO_ERROR) {
+    lovrThrow("Unable to create OpenAL context");
+  }
+
+  alGenSources(1, &openal.source);
+  alGenBuffers(SINK_BUFFERS, openal.buffers);
+  memcpy(openal.available, openal.buffers, sizeof(openal.buffers));
+  openal.availableCount = SINK_BUFFERS;
+  openal.sampleRate = sampleRate;
+  openal.staged = 0;
+  return true;
+}
+
+static void openal_destroy() {
+  alDeleteSources(1, &openal.source);
+  alDeleteBuffers(SINK_BUFFERS, openal.buffers);
+  alcMakeContextCurrent(NULL);
+  alcDestroyContext(openal.context);
+  alcCloseDevice(openal.device);
+  memset(&openal, 0, sizeof(openal));
+}
+
+static uint32_t openal_getFrames() {
+  ALint processed;
+  alGetSourcei(openal.source, AL_BUFFERS_PROCESSED, &processed);
+  if (processed > 0) {
+    alSourceUnqueueBuffers(openal.source, processed, openal.available + openal.availableCount);
+    openal.availableCount += processed;
+  }
+
+  return openal.availableCount * SINK_BUFFER_FRAMES - openal.staged;
+}
+
+static void openal_write(const int16_t* frames, uint32_t count) {
+  while (count > 0 && openal.availableCount > 0) {
+    uint32_t n = MIN(count, SINK_BUFFER_FRAMES - openal.staged);
+    memcpy(openal.staging + 2 * openal.staged, frames, 2 * n * sizeof(int16_t));
+    openal.staged += n;
+    frames += 2 * n;
+    count -= n;
+
+    if (openal.staged == SINK_BUFFER_FRAMES) {
+      ALuint buffer = openal.available[--openal.availableCount];
+      alBufferData(buffer, AL_FORMAT_STEREO16, openal.staging, sizeof(openal.staging), openal.sampleRate);
+      alSourceQueueBuffers(openal.source, 1, &buffer);
+      openal.staged = 0;
+
+      // Restarts the source if it ran dry
+      ALint state;
+      alGetSourcei(openal.source, AL_SOURCE_STATE, &state);
+      if (state != AL_PLAYING) {
+        alSourcePlay(openal.source);
+      }
+    }
+  }
+}
+
+AudioSink lovrAudioOpenALSink = {
+  .type = SINK_OPENAL,
+  .init = openal_init,
+  .destroy = openal_destroy,
+  .getFrames = openal_getFrames,
+  .write = openal_write
+};
+
+// Offline sinks (null and file) consume frames in real time using the platform clock
+
+static struct {
+  FILE* file;
+  uint32_t sampleRate;
+  uint32_t bytes;
+  double time;
+} offline;
+
+static void offline_writeHeader() {
+  uint32_t channels = 2, bitDepth = 16;
+  uint32_t byteRate = offline.sampleRate * channels * bitDepth / 8;
+  uint16_t blockAlign = channels * bitDepth / 8;
+  uint32_t chunkSize = 36 + offline.bytes;
+  uint32_t formatSize = 16;
+  uint16_t format = 1, channelCount = channels, bits = bitDepth;
+  fseek(offline.file, 0, SEEK_SET);
+  fwrite("RIFF", 1, 4, offline.file);
+  fwrite(&chunkSize, 4, 1, offline.file);
+  fwrite("WAVEfmt ", 1, 8, offline.file);
+  fwrite(&formatSize, 4, 1, offline.file);
+  fwrite(&format, 2, 1, offline.file);
+  fwrite(&channelCount, 2, 1, offline.file);
+  fwrite(&offline.sampleRate, 4, 1, offline.file);
+  fwrite(&byteRate, 4, 1, offline.file);
+  fwrite(&blockAlign, 2, 1, offline.file);
+  fwrite(&bits, 2, 1, offline.file);
+  fwrite("data", 1, 4, offline.file);
+  fwrite(&offline.bytes, 4, 1, offline.file);
+}
+
+static bool null_init(uint32_t sampleRate, const char* filename) {
+  offline.sampleRate = sampleRate;
+  offline.time = lovrPlatformGetTime();
+  return true;
+}
+
+static bool file_init(uint32_t sampleRate, const char* filename) {
+  lovrAssert(filename, "The file audio sink requires a filename");
+  offline.file = fopen(filename, "wb");
+  lovrAssert(offline.file, "Could not open '%s' for writing audio", filename);
+  null_init(sampleRate, filename);
+  offline_writeHeader();
+  return true;
+}
+
+static void offline_destroy() {
+  if (offline.file) {
+    offline_writeHeader();
+    fclose(offline.file);
+  }
+  memset(&offline, 0, sizeof(offline));
+}
+
+static uint32_t offline_getFrames() {
+  double now = lovrPlatformGetTime();
+  uint32_t frames = (uint32_t) ((now - offline.time) * offline.sampleRate);
+
+  // Skip ahead instead of mixing a huge backlog after a stall
+  if (frames > offline.sampleRate / 4) {
+    offline.time = now;
+    return offline.sampleRate / 4;
+  }
+
+  offline.time += frames / (double) offline.sampleRate;
+  return frames;
+}
+
+// The null sink paces the mixer like a device would, but there's nowhere for the audio to go
+static void null_write(const int16_t* frames, uint32_t count) {
+  (void) frames;
+  (void) count;
+}
+
+static void file_write(const int16_t* frames, uint32_t count) {
+  fwrite(frames, 2 * sizeof(int16_t), count, offline.file);
+  offline.bytes += 2 * sizeof(int16_t) * count;
+}
+
+AudioSink lovrAudioNullSink = {
+  .type = SINK_NULL,
+  .init = null_init,
+  .destroy = offline_destroy,
+  .getFrames = offline_getFrames,
+  .write = null_write
+};
+
+AudioSink lovrAudioFileSink = {
+  .type = SINK_FILE,
+  .init = file_init,
+  .destroy = offline_destroy,
+  .getFrames = offline_getFrames,
+  .write = file_write
+};
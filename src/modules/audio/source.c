@@ -1,41 +1,199 @@
 #include "audio/source.h"
 #include "audio/audio.h"
+#include "audio/mixer.h"
 #include "data/audioStream.h"
 #include "data/soundData.h"
+#include "core/atomic.h"
 #include "core/maf.h"
 #include "core/ref.h"
 #include "core/util.h"
+#include <float.h>
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 #include <AL/al.h>
 #include <AL/alc.h>
+#ifdef LOVR_ENABLE_THREAD
+#include "lib/tinycthread/tinycthread.h"
+#endif
 
-#define SOURCE_BUFFERS 4
+// Number of decoded frames a stream keeps around for the software mixer
+#define SOURCE_WINDOW_FRAMES (2 * MIXER_INPUT_FRAMES)
+
+typedef enum {
+  STATE_STOPPED,
+  STATE_PLAYING,
+  STATE_PAUSED
+} PlaybackState;
 
 struct Source {
   SourceType type;
   struct SoundData* soundData;
   struct AudioStream* stream;
+  struct Source* parent;
+  uint32_t voice;
+  int priority;
   ALuint id;
-  ALuint buffers[SOURCE_BUFFERS];
+  ALuint buffers[MAX_SOURCE_BUFFERS];
+  ALuint available[MAX_SOURCE_BUFFERS];
+  uint32_t bufferFrames[MAX_SOURCE_BUFFERS];
+  uint32_t bufferCount;
+  uint32_t availableCount;
+  size_t played;
+  bool starved;
   bool isLooping;
+  bool isRelative;
+  float volume;
+  float pitch;
+  float minVolume;
+  float maxVolume;
+  float cone[3];
+  float falloff[3];
+  float LOVR_ALIGN(16) position[4];
+  float LOVR_ALIGN(16) velocity[4];
+  float LOVR_ALIGN(16) orientation[4];
+
+  // Software mixer playback state, the offset and window are measured in frames
+  PlaybackState state;
+  double offset;
+  int16_t* window;
+  int64_t windowStart;
+  uint32_t windowCount;
+  bool streamDone;
+
+  // Decoded PCM for streams, written by the audio thread and read by the main thread.  The head and
+  // tail are sample indices and a frame is kept empty so a full ring can be told apart from empty.
+  // The lock guards the decoder, moving it or resetting the ring has to hold it.
+#ifdef LOVR_ENABLE_THREAD
+  mtx_t lock;
+#endif
+  int16_t* ring;
+  uint32_t ringSize;
+  volatile uint32_t ringHead;
+  volatile uint32_t ringTail;
+  volatile uint32_t decodeDone;
+  size_t streamFrame;
 };
 
-static ALenum lovrSourceGetState(Source* source) {
-  ALenum state;
-  alGetSourcei(source->id, AL_SOURCE_STATE, &state);
-  return state;
+static void lovrSourceInitParameters(Source* source) {
+  source->volume = 1.f;
+  source->pitch = 1.f;
+  source->minVolume = 0.f;
+  source->maxVolume = 1.f;
+  source->cone[0] = source->cone[1] = 2.f * (float) M_PI;
+  source->cone[2] = 0.f;
+  source->falloff[0] = 1.f;
+  source->falloff[1] = FLT_MAX;
+  source->falloff[2] = 1.f;
+  quat_set(source->orientation, 0.f, 0.f, 0.f, 1.f);
+}
+
+// The state is tracked on the Source since it might not have a voice, but static sources playing on
+// an OpenAL voice also stop by themselves when they reach the end
+static void lovrSourceLockStream(Source* source) {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_lock(&source->lock);
+#endif
+}
+
+static void lovrSourceUnlockStream(Source* source) {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_unlock(&source->lock);
+#endif
+}
+
+static PlaybackState lovrSourceGetState(Source* source) {
+  if (source->id && source->type == SOURCE_STATIC && source->state == STATE_PLAYING) {
+    ALenum state;
+    alGetSourcei(source->id, AL_SOURCE_STATE, &state);
+    if (state == AL_STOPPED) {
+      return STATE_STOPPED;
+    }
+  }
+
+  return source->state;
+}
+
+// Moves the decoder and discards everything that was decoded ahead.  The audio thread refills the
+// ring, until it catches up the Source counts as starved without it being an underrun.
+static void lovrSourceResetStream(Source* source, size_t sample) {
+  lovrSourceLockStream(source);
+  if (sample == 0) {
+    lovrAudioStreamRewind(source->stream);
+  } else {
+    lovrAudioStreamSeek(source->stream, sample);
+  }
+
+  source->ringHead = 0;
+  source->ringTail = 0;
+  source->decodeDone = 0;
+  source->windowStart = sample;
+  source->windowCount = 0;
+  source->streamDone = false;
+  source->played = sample;
+  source->streamFrame = sample;
+  source->starved = true;
+  lovrSourceUnlockStream(source);
+}
+
+// Reads decoded samples from the ring, returns fewer than requested if the decoder is behind or done
+static size_t lovrSourceRead(Source* source, int16_t* destination, size_t samples) {
+#ifndef LOVR_ENABLE_THREAD
+  lovrSourceDecode(source);
+#endif
+
+  uint32_t head = atomic_load32(&source->ringHead);
+  uint32_t tail = source->ringTail;
+  size_t count = 0;
+
+  while (count < samples && tail != head) {
+    uint32_t contiguous = (head > tail ? head : source->ringSize) - tail;
+    uint32_t n = (uint32_t) MIN(contiguous, samples - count);
+    memcpy(destination + count, source->ring + tail, n * sizeof(int16_t));
+    tail = (tail + n) % source->ringSize;
+    count += n;
+  }
+
+  atomic_store32(&source->ringTail, tail);
+  source->streamFrame += count / source->stream->channelCount;
+  return count;
+}
+
+static bool lovrSourceIsDrained(Source* source) {
+  return atomic_load32(&source->decodeDone) && atomic_load32(&source->ringHead) == source->ringTail;
 }
 
 Source* lovrSourceCreateStatic(SoundData* soundData) {
   Source* source = lovrAlloc(Source);
-  ALenum format = lovrAudioConvertFormat(soundData->bitDepth, soundData->channelCount);
   source->type = SOURCE_STATIC;
   source->soundData = soundData;
-  alGenSources(1, &source->id);
-  alGenBuffers(1, source->buffers);
-  alBufferData(source->buffers[0], format, soundData->blob.data, (ALsizei) soundData->blob.size, soundData->sampleRate);
-  alSourcei(source->id, AL_BUFFER, source->buffers[0]);
+  lovrSourceInitParameters(source);
+  if (lovrAudioGetMixer() == MIXER_OPENAL) {
+    ALenum format = lovrAudioConvertFormat(soundData->bitDepth, soundData->channelCount);
+    alGenBuffers(1, source->buffers);
+
+    // OpenAL needs all of the PCM up front, so compressed SoundData only stays compressed when using
+    // the software mixer
+    if (lovrSoundDataIsCompressed(soundData)) {
+      size_t frameSize = soundData->channelCount * sizeof(int16_t);
+      int16_t* samples = malloc(soundData->samples * frameSize);
+      lovrAssert(samples, "Out of memory");
+      for (size_t frame = 0, count; frame < soundData->samples; frame += count) {
+        const int16_t* block = lovrSoundDataGetBlock(soundData, frame, &count);
+        if (count == 0) {
+          memset(samples + frame * soundData->channelCount, 0, (soundData->samples - frame) * frameSize);
+          break;
+        }
+        count = MIN(count, soundData->samples - frame);
+        memcpy(samples + frame * soundData->channelCount, block, count * frameSize);
+      }
+      alBufferData(source->buffers[0], format, samples, (ALsizei) (soundData->samples * frameSize), soundData->sampleRate);
+      free(samples);
+    } else {
+      alBufferData(source->buffers[0], format, soundData->blob.data, (ALsizei) soundData->blob.size, soundData->sampleRate);
+    }
+  }
   lovrRetain(soundData);
   return source;
 }
@@ -44,18 +202,76 @@ Source* lovrSourceCreateStream(AudioStream* stream) {
   Source* source = lovrAlloc(Source);
   source->type = SOURCE_STREAM;
   source->stream = stream;
-  alGenSources(1, &source->id);
-  alGenBuffers(SOURCE_BUFFERS, source->buffers);
+  lovrSourceInitParameters(source);
+  if (lovrAudioGetMixer() == MIXER_OPENAL) {
+    source->bufferCount = lovrAudioGetBufferCount();
+    alGenBuffers(source->bufferCount, source->buffers);
+    memcpy(source->available, source->buffers, source->bufferCount * sizeof(ALuint));
+    source->availableCount = source->bufferCount;
+  } else {
+    source->window = malloc(SOURCE_WINDOW_FRAMES * stream->channelCount * sizeof(int16_t));
+    lovrAssert(source->window, "Out of memory");
+  }
+
+  // The ring holds as much audio as all of the OpenAL buffers together
+  size_t frames = stream->bufferSize / stream->channelCount / sizeof(int16_t);
+  source->ringSize = (uint32_t) ((lovrAudioGetBufferCount() * frames + 1) * stream->channelCount);
+  source->ring = malloc(source->ringSize * sizeof(int16_t));
+  lovrAssert(source->ring, "Out of memory");
+#ifdef LOVR_ENABLE_THREAD
+  mtx_init(&source->lock, mtx_plain);
+#endif
+
+  // Nothing is decoded until the stream gets a voice
+  source->starved = true;
   lovrRetain(stream);
   return source;
 }
 
+// Clones share the audio buffer of the original, only the playback state and parameters are copied
+Source* lovrSourceClone(Source* source) {
+  lovrAssert(source->type == SOURCE_STATIC, "Only static Sources can be cloned");
+  Source* clone = lovrAlloc(Source);
+  clone->type = SOURCE_STATIC;
+  clone->soundData = source->soundData;
+  clone->parent = source->parent ? source->parent : source;
+  clone->buffers[0] = source->buffers[0];
+  clone->priority = source->priority;
+  clone->isLooping = source->isLooping;
+  clone->isRelative = source->isRelative;
+  clone->volume = source->volume;
+  clone->pitch = source->pitch;
+  clone->minVolume = source->minVolume;
+  clone->maxVolume = source->maxVolume;
+  memcpy(clone->cone, source->cone, sizeof(source->cone));
+  memcpy(clone->falloff, source->falloff, sizeof(source->falloff));
+  quat_init(clone->orientation, source->orientation);
+  vec3_init(clone->position, source->position);
+  vec3_init(clone->velocity, source->velocity);
+  lovrRetain(clone->soundData);
+  lovrRetain(clone->parent);
+  return clone;
+}
+
 void lovrSourceDestroy(void* ref) {
   Source* source = ref;
-  alDeleteSources(1, &source->id);
-  alDeleteBuffers(source->type == SOURCE_STATIC ? 1 : SOURCE_BUFFERS, source->buffers);
+  lovrAudioReleaseVoice(source);
+  if (source->type == SOURCE_STREAM) {
+    lovrAudioRemoveStream(source);
+  }
+  if (!source->parent && lovrAudioGetMixer() == MIXER_OPENAL) {
+    alDeleteBuffers(source->type == SOURCE_STATIC ? 1 : source->bufferCount, source->buffers);
+  }
+  lovrRelease(Source, source->parent);
   lovrRelease(SoundData, source->soundData);
   lovrRelease(AudioStream, source->stream);
+  free(source->window);
+  free(source->ring);
+#ifdef LOVR_ENABLE_THREAD
+  if (source->type == SOURCE_STREAM) {
+    mtx_destroy(&source->lock);
+  }
+#endif
 }
 
 SourceType lovrSourceGetType(Source* source) {
@@ -66,6 +282,14 @@ uint32_t lovrSourceGetId(Source* source) {
   return source->id;
 }
 
+uint32_t lovrSourceGetVoice(Source* source) {
+  return source->voice;
+}
+
+int lovrSourceGetPriority(Source* source) {
+  return source->priority;
+}
+
 AudioStream* lovrSourceGetStream(Source* source) {
   return source->stream;
 }
@@ -75,11 +299,9 @@ uint32_t lovrSourceGetBitDepth(Source* source) {
 }
 
 void lovrSourceGetCone(Source* source, float* innerAngle, float* outerAngle, float* outerGain) {
-  alGetSourcef(source->id, AL_CONE_INNER_ANGLE, innerAngle);
-  alGetSourcef(source->id, AL_CONE_OUTER_ANGLE, outerAngle);
-  alGetSourcef(source->id, AL_CONE_OUTER_GAIN, outerGain);
-  *innerAngle *= (float) M_PI / 180.f;
-  *outerAngle *= (float) M_PI / 180.f;
+  *innerAngle = source->cone[0];
+  *outerAngle = source->cone[1];
+  *outerGain = source->cone[2];
 }
 
 uint32_t lovrSourceGetChannelCount(Source* source) {
@@ -87,9 +309,7 @@ uint32_t lovrSourceGetChannelCount(Source* source) {
 }
 
 void lovrSourceGetOrientation(Source* source, quat orientation) {
-  float v[4], forward[4] = { 0.f, 0.f, -1.f };
-  alGetSourcefv(source->id, AL_DIRECTION, v);
-  quat_between(orientation, forward, v);
+  quat_init(orientation, source->orientation);
 }
 
 size_t lovrSourceGetDuration(Source* source) {
@@ -97,19 +317,17 @@ size_t lovrSourceGetDuration(Source* source) {
 }
 
 void lovrSourceGetFalloff(Source* source, float* reference, float* max, float* rolloff) {
-  alGetSourcef(source->id, AL_REFERENCE_DISTANCE, reference);
-  alGetSourcef(source->id, AL_MAX_DISTANCE, max);
-  alGetSourcef(source->id, AL_ROLLOFF_FACTOR, rolloff);
+  *reference = source->falloff[0];
+  *max = source->falloff[1];
+  *rolloff = source->falloff[2];
 }
 
 float lovrSourceGetPitch(Source* source) {
-  float pitch;
-  alGetSourcef(source->id, AL_PITCH, &pitch);
-  return pitch;
+  return source->pitch;
 }
 
 void lovrSourceGetPosition(Source* source, vec3 position) {
-  alGetSourcefv(source->id, AL_POSITION, position);
+  vec3_init(position, source->position);
 }
 
 uint32_t lovrSourceGetSampleRate(Source* source) {
@@ -117,18 +335,16 @@ uint32_t lovrSourceGetSampleRate(Source* source) {
 }
 
 void lovrSourceGetVelocity(Source* source, vec3 velocity) {
-  alGetSourcefv(source->id, AL_VELOCITY, velocity);
+  vec3_init(velocity, source->velocity);
 }
 
 float lovrSourceGetVolume(Source* source) {
-  float volume;
-  alGetSourcef(source->id, AL_GAIN, &volume);
-  return volume;
+  return source->volume;
 }
 
 void lovrSourceGetVolumeLimits(Source* source, float* min, float* max) {
-  alGetSourcef(source->id, AL_MIN_GAIN, min);
-  alGetSourcef(source->id, AL_MAX_GAIN, max);
+  *min = source->minVolume;
+  *max = source->maxVolume;
 }
 
 bool lovrSourceIsLooping(Source* source) {
@@ -136,25 +352,29 @@ bool lovrSourceIsLooping(Source* source) {
 }
 
 bool lovrSourceIsPaused(Source* source) {
-  return lovrSourceGetState(source) == AL_PAUSED;
+  return lovrSourceGetState(source) == STATE_PAUSED;
 }
 
 bool lovrSourceIsPlaying(Source* source) {
-  return lovrSourceGetState(source) == AL_PLAYING;
+  return lovrSourceGetState(source) == STATE_PLAYING;
 }
 
 bool lovrSourceIsRelative(Source* source) {
-  int isRelative;
-  alGetSourcei(source->id, AL_SOURCE_RELATIVE, &isRelative);
-  return isRelative == AL_TRUE;
+  return source->isRelative;
 }
 
 bool lovrSourceIsStopped(Source* source) {
-  return lovrSourceGetState(source) == AL_STOPPED;
+  return lovrSourceGetState(source) == STATE_STOPPED;
 }
 
 void lovrSourcePause(Source* source) {
-  alSourcePause(source->id);
+  if (source->id) {
+    alSourcePause(source->id);
+  }
+
+  if (source->state == STATE_PLAYING) {
+    source->state = STATE_PAUSED;
+  }
 }
 
 void lovrSourcePlay(Source* source) {
@@ -165,8 +385,13 @@ void lovrSourcePlay(Source* source) {
     return;
   }
 
-  lovrSourceStream(source, source->buffers, SOURCE_BUFFERS);
-  alSourcePlay(source->id);
+  // A static source that finished on its voice still holds it
+  lovrAudioReleaseVoice(source);
+  source->offset = 0.;
+  source->state = STATE_PLAYING;
+
+  // If no voice is available the Source plays virtually until it gets one
+  lovrAudioClaimVoice(source);
 }
 
 void lovrSourceResume(Source* source) {
@@ -174,7 +399,13 @@ void lovrSourceResume(Source* source) {
     return;
   }
 
-  alSourcePlay(source->id);
+  source->state = STATE_PLAYING;
+
+  if (source->id) {
+    alSourcePlay(source->id);
+  } else if (!source->voice) {
+    lovrAudioClaimVoice(source);
+  }
 }
 
 void lovrSourceRewind(Source* source) {
@@ -182,141 +413,385 @@ void lovrSourceRewind(Source* source) {
     return;
   }
 
-  bool wasPaused = lovrSourceIsPaused(source);
-  alSourceRewind(source->id);
-  lovrSourceStop(source);
-  lovrSourcePlay(source);
-  if (wasPaused) {
-    lovrSourcePause(source);
-  }
+  lovrSourceSeek(source, 0);
 }
 
 void lovrSourceSeek(Source* source, size_t sample) {
+  source->offset = sample;
+
+  if (!source->id) {
+    if (source->type == SOURCE_STREAM) {
+      lovrSourceResetStream(source, sample);
+      if (source->voice) {
+        lovrAudioAddStream(source);
+      }
+    }
+    return;
+  }
+
   switch (source->type) {
     case SOURCE_STATIC:
       alSourcef(source->id, AL_SAMPLE_OFFSET, sample);
       break;
 
     case SOURCE_STREAM: {
-      bool wasPaused = lovrSourceIsPaused(source);
-      lovrSourceStop(source);
-      lovrAudioStreamSeek(source->stream, sample);
-      lovrSourcePlay(source);
-      if (wasPaused) {
-        lovrSourcePause(source);
+      ALint count = 0;
+      ALuint buffers[MAX_SOURCE_BUFFERS];
+      alSourceStop(source->id);
+      alGetSourcei(source->id, AL_BUFFERS_QUEUED, &count);
+      alSourceUnqueueBuffers(source->id, count, buffers);
+      memcpy(source->available + source->availableCount, buffers, count * sizeof(ALuint));
+      source->availableCount += count;
+      memset(source->bufferFrames, 0, sizeof(source->bufferFrames));
+
+      lovrSourceResetStream(source, sample);
+      lovrAudioAddStream(source);
+
+      lovrSourceStream(source);
+      if (source->state == STATE_PLAYING) {
+        alSourcePlay(source->id);
       }
       break;
     }
   }
 }
 
+void lovrSourceSetPriority(Source* source, int priority) {
+  source->priority = priority;
+}
+
 void lovrSourceSetCone(Source* source, float innerAngle, float outerAngle, float outerGain) {
-  alSourcef(source->id, AL_CONE_INNER_ANGLE, innerAngle * 180.f / (float) M_PI);
-  alSourcef(source->id, AL_CONE_OUTER_ANGLE, outerAngle * 180.f / (float) M_PI);
-  alSourcef(source->id, AL_CONE_OUTER_GAIN, outerGain);
+  source->cone[0] = innerAngle;
+  source->cone[1] = outerAngle;
+  source->cone[2] = outerGain;
+  if (source->id) {
+    alSourcef(source->id, AL_CONE_INNER_ANGLE, innerAngle * 180.f / (float) M_PI);
+    alSourcef(source->id, AL_CONE_OUTER_ANGLE, outerAngle * 180.f / (float) M_PI);
+    alSourcef(source->id, AL_CONE_OUTER_GAIN, outerGain);
+  }
 }
 
 void lovrSourceSetOrientation(Source* source, quat orientation) {
-  float v[4] = { 0.f, 0.f, -1.f };
-  quat_rotate(orientation, v);
-  alSource3f(source->id, AL_DIRECTION, v[0], v[1], v[2]);
+  quat_init(source->orientation, orientation);
+  if (source->id) {
+    float v[4] = { 0.f, 0.f, -1.f };
+    quat_rotate(orientation, v);
+    alSource3f(source->id, AL_DIRECTION, v[0], v[1], v[2]);
+  }
 }
 
 void lovrSourceSetFalloff(Source* source, float reference, float max, float rolloff) {
   lovrAssert(lovrSourceGetChannelCount(source) == 1, "Positional audio is only supported for mono sources");
-  alSourcef(source->id, AL_REFERENCE_DISTANCE, reference);
-  alSourcef(source->id, AL_MAX_DISTANCE, max);
-  alSourcef(source->id, AL_ROLLOFF_FACTOR, rolloff);
+  source->falloff[0] = reference;
+  source->falloff[1] = max;
+  source->falloff[2] = rolloff;
+  if (source->id) {
+    alSourcef(source->id, AL_REFERENCE_DISTANCE, reference);
+    alSourcef(source->id, AL_MAX_DISTANCE, max);
+    alSourcef(source->id, AL_ROLLOFF_FACTOR, rolloff);
+  }
 }
 
 void lovrSourceSetLooping(Source* source, bool isLooping) {
-  source->isLooping = isLooping;
-  if (source->type == SOURCE_STATIC) {
-    alSourcei(source->id, AL_LOOPING, isLooping ? AL_TRUE : AL_FALSE);
+  if (source->type == SOURCE_STREAM) {
+    lovrSourceLockStream(source);
+    source->isLooping = isLooping;
+    lovrSourceUnlockStream(source);
+  } else {
+    source->isLooping = isLooping;
+    if (source->id) {
+      alSourcei(source->id, AL_LOOPING, isLooping ? AL_TRUE : AL_FALSE);
+    }
   }
 }
 
 void lovrSourceSetPitch(Source* source, float pitch) {
-  alSourcef(source->id, AL_PITCH, pitch);
+  source->pitch = pitch;
+  if (source->id) {
+    alSourcef(source->id, AL_PITCH, pitch);
+  }
 }
 
 void lovrSourceSetPosition(Source* source, vec3 position) {
   lovrAssert(lovrSourceGetChannelCount(source) == 1, "Positional audio is only supported for mono sources");
-  alSource3f(source->id, AL_POSITION, position[0], position[1], position[2]);
+  vec3_init(source->position, position);
+  if (source->id) {
+    alSource3f(source->id, AL_POSITION, position[0], position[1], position[2]);
+  }
 }
 
 void lovrSourceSetRelative(Source* source, bool isRelative) {
-  alSourcei(source->id, AL_SOURCE_RELATIVE, isRelative ? AL_TRUE : AL_FALSE);
+  source->isRelative = isRelative;
+  if (source->id) {
+    alSourcei(source->id, AL_SOURCE_RELATIVE, isRelative ? AL_TRUE : AL_FALSE);
+  }
 }
 
 void lovrSourceSetVelocity(Source* source, vec3 velocity) {
-  alSource3f(source->id, AL_VELOCITY, velocity[0], velocity[1], velocity[2]);
+  vec3_init(source->velocity, velocity);
+  if (source->id) {
+    alSource3f(source->id, AL_VELOCITY, velocity[0], velocity[1], velocity[2]);
+  }
 }
 
 void lovrSourceSetVolume(Source* source, float volume) {
-  alSourcef(source->id, AL_GAIN, volume);
+  source->volume = volume;
+  if (source->id) {
+    alSourcef(source->id, AL_GAIN, volume);
+  }
 }
 
 void lovrSourceSetVolumeLimits(Source* source, float min, float max) {
-  alSourcef(source->id, AL_MIN_GAIN, min);
-  alSourcef(source->id, AL_MAX_GAIN, max);
+  source->minVolume = min;
+  source->maxVolume = max;
+  if (source->id) {
+    alSourcef(source->id, AL_MIN_GAIN, min);
+    alSourcef(source->id, AL_MAX_GAIN, max);
+  }
 }
 
 void lovrSourceStop(Source* source) {
-  if (lovrSourceIsStopped(source)) {
+  if (lovrSourceIsStopped(source) && !source->voice) {
     return;
   }
 
-  switch (source->type) {
-    case SOURCE_STATIC:
-      alSourceStop(source->id);
-      break;
+  lovrAudioReleaseVoice(source);
+  source->state = STATE_STOPPED;
+  source->offset = 0.;
 
-    case SOURCE_STREAM: {
+  // Rewind the decoder
+  if (source->type == SOURCE_STREAM) {
+    lovrSourceResetStream(source, 0);
+  }
+}
+
+// Sets up a voice to play the Source, picking up from the offset it was at.  In software mode the
+// voice only represents a slot in the mix, in OpenAL mode the id is the OpenAL source to use.
+void lovrSourceAttach(Source* source, uint32_t voice, uint32_t id) {
+  source->voice = voice;
+  source->id = id;
+
+  if (source->type == SOURCE_STREAM) {
+    size_t duration = source->stream->samples;
+    size_t offset = (size_t) source->offset;
+    size_t position = duration > 0 ? source->streamFrame % duration : source->streamFrame;
+    bool inWindow = !id && source->offset >= source->windowStart && source->offset <= source->windowStart + source->windowCount;
+    if (!inWindow && position != offset) {
+      lovrSourceResetStream(source, offset);
+    }
+    lovrAudioAddStream(source);
+  }
 
-      // Empty the buffers
-      int count = 0;
+  if (!id) {
+    return;
+  }
+
+  float direction[4] = { 0.f, 0.f, -1.f };
+  quat_rotate(source->orientation, direction);
+  alSourcef(id, AL_GAIN, source->volume);
+  alSourcef(id, AL_PITCH, source->pitch);
+  alSourcef(id, AL_MIN_GAIN, source->minVolume);
+  alSourcef(id, AL_MAX_GAIN, source->maxVolume);
+  alSourcefv(id, AL_POSITION, source->position);
+  alSourcefv(id, AL_VELOCITY, source->velocity);
+  alSourcefv(id, AL_DIRECTION, direction);
+  alSourcef(id, AL_CONE_INNER_ANGLE, source->cone[0] * 180.f / (float) M_PI);
+  alSourcef(id, AL_CONE_OUTER_ANGLE, source->cone[1] * 180.f / (float) M_PI);
+  alSourcef(id, AL_CONE_OUTER_GAIN, source->cone[2]);
+  alSourcef(id, AL_REFERENCE_DISTANCE, source->falloff[0]);
+  alSourcef(id, AL_MAX_DISTANCE, source->falloff[1]);
+  alSourcef(id, AL_ROLLOFF_FACTOR, source->falloff[2]);
+  alSourcei(id, AL_SOURCE_RELATIVE, source->isRelative ? AL_TRUE : AL_FALSE);
+
+  if (source->type == SOURCE_STATIC) {
+    alSourcei(id, AL_LOOPING, source->isLooping ? AL_TRUE : AL_FALSE);
+    alSourcei(id, AL_BUFFER, source->buffers[0]);
+    alSourcef(id, AL_SAMPLE_OFFSET, (float) source->offset);
+  } else {
+    alSourcei(id, AL_LOOPING, AL_FALSE);
+    source->played = source->streamFrame;
+    lovrSourceStream(source);
+  }
+
+  if (source->state == STATE_PLAYING) {
+    alSourcePlay(id);
+  }
+}
+
+// Takes the Source off of its voice, remembering where it was so it can continue later
+void lovrSourceDetach(Source* source) {
+  if (!source->voice) {
+    return;
+  }
+
+  if (source->type == SOURCE_STREAM) {
+    lovrAudioRemoveStream(source);
+  }
+
+  if (source->id) {
+    source->offset = lovrSourceTell(source);
+    alSourceStop(source->id);
+
+    if (source->type == SOURCE_STREAM) {
+      ALint count = 0;
       alGetSourcei(source->id, AL_BUFFERS_QUEUED, &count);
       alSourceUnqueueBuffers(source->id, count, NULL);
+      memcpy(source->available, source->buffers, source->bufferCount * sizeof(ALuint));
+      memset(source->bufferFrames, 0, sizeof(source->bufferFrames));
+      source->availableCount = source->bufferCount;
+    }
 
-      // Stop the source
-      alSourceStop(source->id);
-      alSourcei(source->id, AL_BUFFER, AL_NONE);
+    alSourcei(source->id, AL_BUFFER, AL_NONE);
+  }
 
-      // Rewind the decoder
-      lovrAudioStreamRewind(source->stream);
-      break;
+  source->voice = 0;
+  source->id = 0;
+}
+
+// Keeps time for a Source that's playing without a voice.  Returns false once it reaches the end.
+bool lovrSourceAdvance(Source* source, double seconds) {
+  if (source->state != STATE_PLAYING) {
+    return source->state == STATE_PAUSED;
+  }
+
+  double duration = (double) lovrSourceGetDuration(source);
+  source->offset += seconds * lovrSourceGetSampleRate(source) * source->pitch;
+
+  if (source->offset >= duration) {
+    if (source->isLooping && duration > 0.) {
+      source->offset = fmod(source->offset, duration);
+    } else {
+      lovrSourceStop(source);
+      return false;
     }
   }
+
+  return true;
 }
 
-// Fills buffers with data and queues them, called once initially and over time to stream more data
-void lovrSourceStream(Source* source, ALuint* buffers, size_t count) {
-  if (source->type == SOURCE_STATIC) {
-    return;
+// Decodes audio into the free space of the ring, usually on the audio thread
+void lovrSourceDecode(Source* source) {
+  lovrSourceLockStream(source);
+  AudioStream* stream = source->stream;
+  uint32_t channelCount = stream->channelCount;
+  uint32_t head = source->ringHead;
+  bool rewound = false;
+
+  while (!source->decodeDone) {
+    uint32_t tail = atomic_load32(&source->ringTail);
+    uint32_t space = (tail + source->ringSize - head - channelCount) % source->ringSize;
+    uint32_t contiguous = MIN(space, source->ringSize - head);
+
+    if (contiguous == 0) {
+      break;
+    }
+
+    size_t samples = lovrAudioStreamDecode(stream, source->ring + head, contiguous);
+
+    if (samples > 0) {
+      head = (head + (uint32_t) samples) % source->ringSize;
+      atomic_store32(&source->ringHead, head);
+      rewound = false;
+    } else if (source->isLooping && !rewound) {
+      lovrAudioStreamRewind(stream);
+      rewound = true;
+    } else {
+      atomic_store32(&source->decodeDone, 1);
+    }
   }
+  lovrSourceUnlockStream(source);
+}
 
+// Fills the buffers that aren't queued with decoded audio and queues them
+void lovrSourceStream(Source* source) {
   AudioStream* stream = source->stream;
   ALenum format = lovrAudioConvertFormat(stream->bitDepth, stream->channelCount);
-  uint32_t frequency = stream->sampleRate;
-  size_t samples = 0;
-  size_t n = 0;
+  size_t capacity = stream->bufferSize / sizeof(int16_t);
 
-  // Keep decoding until there is nothing left to decode or all the buffers are filled
-  while (n < count && (samples = lovrAudioStreamDecode(stream, NULL, 0)) != 0) {
-    alBufferData(buffers[n++], format, stream->buffer, (ALsizei) (samples * sizeof(ALshort)), frequency);
+  while (source->availableCount > 0) {
+    size_t samples = lovrSourceRead(source, stream->buffer, capacity);
+
+    if (samples == 0) {
+      break;
+    }
+
+    ALuint buffer = source->available[--source->availableCount];
+    for (uint32_t i = 0; i < source->bufferCount; i++) {
+      if (source->buffers[i] == buffer) {
+        source->bufferFrames[i] = (uint32_t) (samples / stream->channelCount);
+        break;
+      }
+    }
+
+    alBufferData(buffer, format, stream->buffer, (ALsizei) (samples * sizeof(ALshort)), stream->sampleRate);
+    alSourceQueueBuffers(source->id, 1, &buffer);
   }
+}
 
-  alSourceQueueBuffers(source->id, (ALsizei) n, buffers);
+// Called every frame in OpenAL mode.  Virtual sources keep time, static sources check if they've
+// finished, and streams recycle buffers that finished playing and keep the OpenAL source fed.
+// Returns false once the Source is stopped, either because it was stopped or because it ended.
+bool lovrSourceUpdate(Source* source, double dt) {
+  if (source->state == STATE_STOPPED) {
+    return false;
+  } else if (!source->id) {
+    return lovrSourceAdvance(source, dt);
+  } else if (source->type == SOURCE_STATIC) {
+    if (lovrSourceIsStopped(source)) {
+      lovrSourceStop(source);
+      return false;
+    }
+    return true;
+  }
 
-  if (samples == 0 && source->isLooping && n < count) {
-    lovrAudioStreamRewind(stream);
-    lovrSourceStream(source, buffers + n, count - n);
-    return;
+  ALint processed;
+  alGetSourcei(source->id, AL_BUFFERS_PROCESSED, &processed);
+
+  if (processed > 0) {
+    ALuint buffers[MAX_SOURCE_BUFFERS];
+    alSourceUnqueueBuffers(source->id, processed, buffers);
+    for (ALint i = 0; i < processed; i++) {
+      for (uint32_t j = 0; j < source->bufferCount; j++) {
+        if (source->buffers[j] == buffers[i]) {
+          source->played += source->bufferFrames[j];
+          source->bufferFrames[j] = 0;
+          break;
+        }
+      }
+      source->available[source->availableCount++] = buffers[i];
+    }
+  }
+
+  if (source->state == STATE_PAUSED) {
+    return true;
+  }
+
+  lovrSourceStream(source);
+
+  ALint state, queued;
+  alGetSourcei(source->id, AL_SOURCE_STATE, &state);
+  if (state != AL_PLAYING) {
+    alGetSourcei(source->id, AL_BUFFERS_QUEUED, &queued);
+    if (queued > 0) {
+      alSourcePlay(source->id);
+      source->starved = false;
+    } else if (lovrSourceIsDrained(source)) {
+      lovrSourceStop(source);
+      return false;
+    } else if (!source->starved) {
+      lovrAudioCountUnderrun();
+      source->starved = true;
+    }
   }
+
+  return true;
 }
 
 size_t lovrSourceTell(Source* source) {
+  if (!source->id) {
+    return (size_t) source->offset;
+  }
+
   switch (source->type) {
     case SOURCE_STATIC: {
       float offset;
@@ -325,22 +800,180 @@ size_t lovrSourceTell(Source* source) {
     }
 
     case SOURCE_STREAM: {
-      size_t decoderOffset = lovrAudioStreamTell(source->stream);
-      size_t samplesPerBuffer = source->stream->bufferSize / source->stream->channelCount / sizeof(ALshort);
-      ALsizei queuedBuffers, sampleOffset;
-      alGetSourcei(source->id, AL_BUFFERS_QUEUED, &queuedBuffers);
+      ALint sampleOffset;
       alGetSourcei(source->id, AL_SAMPLE_OFFSET, &sampleOffset);
+      size_t offset = source->played + sampleOffset;
+      size_t duration = source->stream->samples;
+      return duration > 0 ? offset % duration : offset;
+    }
 
-      size_t offset = decoderOffset + sampleOffset;
+    default: lovrThrow("Unreachable"); break;
+  }
+}
 
-      if (queuedBuffers * samplesPerBuffer > offset) {
-        return offset + source->stream->samples;
-      } else {
-        return offset;
+// Software mixing
+
+// Reads frames from a static source, wrapping around when looping and reading silence past the end
+static void lovrSourceReadStatic(Source* source, float* channels[2], int64_t start, uint32_t count) {
+  SoundData* soundData = source->soundData;
+  uint32_t channelCount = soundData->channelCount;
+  int64_t duration = soundData->samples;
+
+  uint32_t i = 0;
+
+  while (i < count) {
+    int64_t frame = start + i;
+
+    if (frame >= duration && source->isLooping && duration > 0) {
+      frame %= duration;
+    }
+
+    if (frame >= duration) {
+      break;
+    }
+
+    // Copy contiguous runs of frames, compressed SoundData hands out one cached block at a time
+    uint32_t n = (uint32_t) MIN(count - i, duration - frame);
+
+    if (lovrSoundDataIsCompressed(soundData)) {
+      size_t available;
+      const int16_t* pcm = lovrSoundDataGetBlock(soundData, frame, &available);
+      n = (uint32_t) MIN(n, available);
+      if (n == 0) break;
+      for (uint32_t j = 0; j < n; j++) {
+        for (uint32_t c = 0; c < channelCount; c++) {
+          channels[c][i + j] = pcm[j * channelCount + c] / (float) SHRT_MAX;
+        }
+      }
+    } else if (soundData->bitDepth == 16) {
+      const int16_t* pcm = (int16_t*) soundData->blob.data + frame * channelCount;
+      for (uint32_t j = 0; j < n; j++) {
+        for (uint32_t c = 0; c < channelCount; c++) {
+          channels[c][i + j] = pcm[j * channelCount + c] / (float) SHRT_MAX;
+        }
       }
+    } else {
+      const int8_t* pcm = (int8_t*) soundData->blob.data + frame * channelCount;
+      for (uint32_t j = 0; j < n; j++) {
+        for (uint32_t c = 0; c < channelCount; c++) {
+          channels[c][i + j] = pcm[j * channelCount + c] / (float) CHAR_MAX;
+        }
+      }
+    }
+
+    i += n;
+  }
+
+  // Silence past the end
+  for (; i < count; i++) {
+    for (uint32_t c = 0; c < channelCount; c++) {
+      channels[c][i] = 0.f;
+    }
+  }
+}
+
+// Streams read sequentially from the ring into a window of frames.  When looping, the decoder wraps
+// around and the window keeps going, so frames past the end of the stream continue from its start.
+static void lovrSourceReadStream(Source* source, float* channels[2], int64_t start, uint32_t count) {
+  AudioStream* stream = source->stream;
+  uint32_t channelCount = stream->channelCount;
+
+  for (;;) {
+
+    // Discard frames that have already been played
+    if (start > source->windowStart) {
+      uint32_t discard = (uint32_t) MIN(start - source->windowStart, (int64_t) source->windowCount);
+      memmove(source->window, source->window + discard * channelCount, (source->windowCount - discard) * channelCount * sizeof(int16_t));
+      source->windowCount -= discard;
+      source->windowStart += discard;
+    }
+
+    if (source->windowStart + source->windowCount >= start + count || source->streamDone) {
       break;
     }
 
-    default: lovrThrow("Unreachable"); break;
+    int16_t* end = source->window + source->windowCount * channelCount;
+    size_t capacity = (SOURCE_WINDOW_FRAMES - source->windowCount) * channelCount;
+    size_t samples = lovrSourceRead(source, end, capacity);
+    source->windowCount += (uint32_t) (samples / channelCount);
+
+    if (samples > 0) {
+      source->starved = false;
+    } else if (lovrSourceIsDrained(source)) {
+      source->streamDone = true;
+      break;
+    } else {
+      if (!source->starved) {
+        lovrAudioCountUnderrun();
+        source->starved = true;
+      }
+      break;
+    }
   }
+
+  for (uint32_t i = 0; i < count; i++) {
+    int64_t frame = start + i - source->windowStart;
+    for (uint32_t c = 0; c < channelCount; c++) {
+      if (frame >= 0 && frame < source->windowCount) {
+        channels[c][i] = source->window[frame * channelCount + c] / (float) SHRT_MAX;
+      } else {
+        channels[c][i] = 0.f;
+      }
+    }
+  }
+}
+
+// Resamples the next block of the Source and adds it to an interleaved stereo buffer.  Mono sources
+// use the left/right gains for panning, stereo sources send each channel to its own side.  Returns
+// false once the Source has stopped and no longer needs to be mixed.
+bool lovrSourceMix(Source* source, float* output, uint32_t frames, uint32_t sampleRate, float left, float right) {
+  lovrAssert(frames <= MIXER_FRAMES, "Too many frames requested from Source");
+
+  if (source->state != STATE_PLAYING) {
+    return source->state == STATE_PAUSED;
+  }
+
+  uint32_t channelCount = lovrSourceGetChannelCount(source);
+  int64_t duration = lovrSourceGetDuration(source);
+
+  // Limit the step so the input for the block fits in the scratch buffers
+  double step = source->pitch * lovrSourceGetSampleRate(source) / (double) sampleRate;
+  step = CLAMP(step, 0., (MIXER_INPUT_FRAMES - 2) / (double) frames);
+
+  int64_t start = (int64_t) source->offset;
+  double position = source->offset - start;
+  uint32_t count = (uint32_t) (position + (frames - 1) * step) + 2;
+
+  float input[2][MIXER_INPUT_FRAMES];
+  float resampled[MIXER_FRAMES];
+  float* channels[2] = { input[0], input[1] };
+
+  if (source->type == SOURCE_STATIC) {
+    lovrSourceReadStatic(source, channels, start, count);
+  } else {
+    lovrSourceReadStream(source, channels, start, count);
+  }
+
+  for (uint32_t c = 0; c < channelCount && c < 2; c++) {
+    float l = channelCount == 1 || c == 0 ? left : 0.f;
+    float r = channelCount == 1 || c == 1 ? right : 0.f;
+    lovrMixerResample(resampled, channels[c], frames, position, step);
+    lovrMixerAccumulate(output, resampled, frames, l, r);
+  }
+
+  source->offset += frames * step;
+
+  if (source->offset >= duration) {
+    if (source->isLooping && duration > 0) {
+      while (source->offset >= duration) {
+        source->offset -= duration;
+        source->windowStart -= duration;
+      }
+    } else {
+      lovrSourceStop(source);
+      return false;
+    }
+  }
+
+  return true;
 }
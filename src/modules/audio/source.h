@@ -4,7 +4,7 @@
 
 #pragma once
 
-#define SOURCE_BUFFERS 4
+#define MAX_SOURCE_BUFFERS 16
 
 struct AudioStream;
 struct SoundData;
@@ -22,9 +22,12 @@ typedef enum {
 typedef struct Source Source;
 Source* lovrSourceCreateStatic(struct SoundData* soundData);
 Source* lovrSourceCreateStream(struct AudioStream* stream);
+Source* lovrSourceClone(Source* source);
 void lovrSourceDestroy(void* ref);
 SourceType lovrSourceGetType(Source* source);
 uint32_t lovrSourceGetId(Source* source);
+uint32_t lovrSourceGetVoice(Source* source);
+int lovrSourceGetPriority(Source* source);
 struct AudioStream* lovrSourceGetStream(Source* source);
 uint32_t lovrSourceGetBitDepth(Source* source);
 uint32_t lovrSourceGetChannelCount(Source* source);
@@ -48,6 +51,7 @@ void lovrSourcePlay(Source* source);
 void lovrSourceResume(Source* source);
 void lovrSourceRewind(Source* source);
 void lovrSourceSeek(Source* source, size_t sample);
+void lovrSourceSetPriority(Source* source, int priority);
 void lovrSourceSetCone(Source* source, float inner, float outer, float outerGain);
 void lovrSourceSetOrientation(Source* source, float* orientation);
 void lovrSourceSetFalloff(Source* source, float reference, float max, float rolloff);
@@ -59,5 +63,11 @@ void lovrSourceSetVelocity(Source* source, float* velocity);
 void lovrSourceSetVolume(Source* source, float volume);
 void lovrSourceSetVolumeLimits(Source* source, float min, float max);
 void lovrSourceStop(Source* source);
-void lovrSourceStream(Source* source, uint32_t* buffers, size_t count);
+void lovrSourceDecode(Source* source);
+void lovrSourceStream(Source* source);
+void lovrSourceAttach(Source* source, uint32_t voice, uint32_t id);
+void lovrSourceDetach(Source* source);
+bool lovrSourceAdvance(Source* source, double seconds);
+bool lovrSourceUpdate(Source* source, double dt);
 size_t lovrSourceTell(Source* source);
+bool lovrSourceMix(Source* source, float* output, uint32_t frames, uint32_t sampleRate, float left, float right);
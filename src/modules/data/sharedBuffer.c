@@ -0,0 +1,54 @@
+#include "data/sharedBuffer.h"
+#include "core/atomic.h"
+#include "util.h"
+#include <stdlib.h>
+
+static const size_t viewSizes[] = {
+  [VIEW_U8] = sizeof(uint8_t),
+  [VIEW_I32] = sizeof(int32_t),
+  [VIEW_F32] = sizeof(float)
+};
+
+// malloc alignment is enough for every view and for atomics
+SharedBuffer* lovrSharedBufferInit(SharedBuffer* buffer, size_t size) {
+  lovrAssert(size > 0, "SharedBuffer size must be positive");
+  void* data = calloc(1, size);
+  lovrAssert(data, "Out of memory");
+  lovrBlobInit(&buffer->blob, data, size, "SharedBuffer");
+  return buffer;
+}
+
+void lovrSharedBufferDestroy(void* ref) {
+  lovrBlobDestroy(ref);
+}
+
+size_t lovrSharedBufferGetCount(SharedBuffer* buffer, ViewType type) {
+  return buffer->blob.size / viewSizes[type];
+}
+
+void* lovrSharedBufferGetElement(SharedBuffer* buffer, ViewType type, size_t index) {
+  lovrAssert(index < lovrSharedBufferGetCount(buffer, type), "SharedBuffer index %zu is out of range", index + 1);
+  return (uint8_t*) buffer->blob.data + index * viewSizes[type];
+}
+
+int32_t lovrSharedBufferAtomicLoad(SharedBuffer* buffer, size_t index) {
+  return (int32_t) atomic_load32(lovrSharedBufferGetElement(buffer, VIEW_I32, index));
+}
+
+void lovrSharedBufferAtomicStore(SharedBuffer* buffer, size_t index, int32_t value) {
+  atomic_store32(lovrSharedBufferGetElement(buffer, VIEW_I32, index), (uint32_t) value);
+}
+
+// Returns the new value
+int32_t lovrSharedBufferAtomicAdd(SharedBuffer* buffer, size_t index, int32_t value) {
+  return (int32_t) atomic_add32(lovrSharedBufferGetElement(buffer, VIEW_I32, index), (uint32_t) value);
+}
+
+// On failure, expected is set to the current value
+bool lovrSharedBufferAtomicCompareExchange(SharedBuffer* buffer, size_t index, int32_t* expected, int32_t desired) {
+  return atomic_cas32(lovrSharedBufferGetElement(buffer, VIEW_I32, index), (uint32_t*) expected, (uint32_t) desired);
+}
+
+void lovrSharedBufferFence() {
+  atomic_fence();
+}
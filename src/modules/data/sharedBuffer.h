@@ -0,0 +1,30 @@
+#include "data/blob.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+typedef enum {
+  VIEW_U8,
+  VIEW_I32,
+  VIEW_F32
+} ViewType;
+
+// A zeroed Blob meant to be written by one thread and read by another without copying.  It can be
+// passed anywhere a Blob is accepted.  Atomics work on i32 elements, and plain reads and writes are
+// only ordered by atomics and fences.
+typedef struct SharedBuffer {
+  Blob blob;
+} SharedBuffer;
+
+SharedBuffer* lovrSharedBufferInit(SharedBuffer* buffer, size_t size);
+#define lovrSharedBufferCreate(...) lovrSharedBufferInit(lovrAlloc(SharedBuffer), __VA_ARGS__)
+void lovrSharedBufferDestroy(void* ref);
+size_t lovrSharedBufferGetCount(SharedBuffer* buffer, ViewType type);
+void* lovrSharedBufferGetElement(SharedBuffer* buffer, ViewType type, size_t index);
+int32_t lovrSharedBufferAtomicLoad(SharedBuffer* buffer, size_t index);
+void lovrSharedBufferAtomicStore(SharedBuffer* buffer, size_t index, int32_t value);
+int32_t lovrSharedBufferAtomicAdd(SharedBuffer* buffer, size_t index, int32_t value);
+bool lovrSharedBufferAtomicCompareExchange(SharedBuffer* buffer, size_t index, int32_t* expected, int32_t desired);
+void lovrSharedBufferFence(void);
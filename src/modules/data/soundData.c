@@ -1,5 +1,6 @@
 #include "data/soundData.h"
 #include "data/audioStream.h"
+#include "core/ref.h"
 #include "util.h"
 #include "lib/stb/stb_vorbis.h"
 #include <limits.h>
@@ -37,9 +38,24 @@ SoundData* lovrSoundDataInitFromAudioStream(SoundData* soundData, AudioStream* a
   return soundData;
 }
 
-SoundData* lovrSoundDataInitFromBlob(SoundData* soundData, Blob* blob) {
+SoundData* lovrSoundDataInitFromBlob(SoundData* soundData, Blob* blob, bool decode) {
   int sampleRate, channels;
   soundData->bitDepth = 16;
+
+  // Compressed SoundData only keeps the Vorbis data around, the decoder is opened on first read
+  if (!decode) {
+    stb_vorbis* decoder = stb_vorbis_open_memory(blob->data, (int) blob->size, NULL, NULL);
+    lovrAssert(decoder, "Could not decode sound data from '%s'", blob->name);
+    stb_vorbis_info info = stb_vorbis_get_info(decoder);
+    soundData->samples = stb_vorbis_stream_length_in_samples(decoder);
+    soundData->sampleRate = info.sample_rate;
+    soundData->channelCount = info.channels;
+    soundData->compressed = blob;
+    stb_vorbis_close(decoder);
+    lovrRetain(blob);
+    return soundData;
+  }
+
   soundData->samples = stb_vorbis_decode_memory(blob->data, (int) blob->size, &channels, &sampleRate, (int16_t**) &soundData->blob.data);
   soundData->sampleRate = sampleRate;
   soundData->channelCount = channels;
@@ -47,7 +63,80 @@ SoundData* lovrSoundDataInitFromBlob(SoundData* soundData, Blob* blob) {
   return soundData;
 }
 
+// Decodes the block containing a frame, evicting the least recently used block.  Sequential blocks
+// continue from where the decoder left off, anything else seeks, which finds the Ogg page holding the
+// frame and decodes forward from there.
+static SoundBlock* lovrSoundDataDecodeBlock(SoundData* soundData, size_t index) {
+  SoundBlock* block = &soundData->cache[0];
+  for (uint32_t i = 1; i < SOUND_CACHE_BLOCKS; i++) {
+    if (soundData->cache[i].tick < block->tick) {
+      block = &soundData->cache[i];
+    }
+  }
+
+  if (!block->data) {
+    block->data = malloc(SOUND_BLOCK_FRAMES * soundData->channelCount * sizeof(int16_t));
+    lovrAssert(block->data, "Out of memory");
+  }
+
+  if (!soundData->decoder) {
+    Blob* blob = soundData->compressed;
+    soundData->decoder = stb_vorbis_open_memory(blob->data, (int) blob->size, NULL, NULL);
+    lovrAssert(soundData->decoder, "Could not decode sound data from '%s'", blob->name);
+    soundData->decoderOffset = 0;
+  }
+
+  stb_vorbis* decoder = soundData->decoder;
+  size_t start = index * SOUND_BLOCK_FRAMES;
+  if (soundData->decoderOffset != start) {
+    stb_vorbis_seek(decoder, (unsigned int) start);
+  }
+
+  uint32_t channelCount = soundData->channelCount;
+  uint32_t capacity = SOUND_BLOCK_FRAMES * channelCount;
+  uint32_t samples = 0;
+  while (samples < capacity) {
+    int count = stb_vorbis_get_samples_short_interleaved(decoder, channelCount, block->data + samples, capacity - samples);
+    if (count == 0) break;
+    samples += count * channelCount;
+  }
+
+  block->index = index;
+  block->frames = samples / channelCount;
+  soundData->decoderOffset = start + block->frames;
+  return block;
+}
+
+// Returns decoded frames starting at a frame, and how many frames are available in the block
+const int16_t* lovrSoundDataGetBlock(SoundData* soundData, size_t frame, size_t* count) {
+  size_t index = frame / SOUND_BLOCK_FRAMES;
+  SoundBlock* block = NULL;
+
+  for (uint32_t i = 0; i < SOUND_CACHE_BLOCKS; i++) {
+    if (soundData->cache[i].data && soundData->cache[i].index == index) {
+      block = &soundData->cache[i];
+      break;
+    }
+  }
+
+  if (!block) {
+    block = lovrSoundDataDecodeBlock(soundData, index);
+  }
+
+  block->tick = ++soundData->tick;
+  size_t offset = frame - index * SOUND_BLOCK_FRAMES;
+  *count = block->frames > offset ? block->frames - offset : 0;
+  return block->data + offset * soundData->channelCount;
+}
+
 float lovrSoundDataGetSample(SoundData* soundData, size_t index) {
+  if (soundData->compressed) {
+    lovrAssert(index < soundData->samples * soundData->channelCount, "Sample index out of range");
+    size_t count;
+    const int16_t* frame = lovrSoundDataGetBlock(soundData, index / soundData->channelCount, &count);
+    return count > 0 ? frame[index % soundData->channelCount] / (float) SHRT_MAX : 0.f;
+  }
+
   lovrAssert(index < soundData->blob.size / (soundData->bitDepth / 8), "Sample index out of range");
   switch (soundData->bitDepth) {
     case 8: return ((int8_t*) soundData->blob.data)[index] / (float) CHAR_MAX;
@@ -56,7 +145,12 @@ float lovrSoundDataGetSample(SoundData* soundData, size_t index) {
   }
 }
 
+bool lovrSoundDataIsCompressed(SoundData* soundData) {
+  return soundData->compressed;
+}
+
 void lovrSoundDataSetSample(SoundData* soundData, size_t index, float value) {
+  lovrAssert(!soundData->compressed, "Compressed SoundData can not be modified");
   lovrAssert(index < soundData->blob.size / (soundData->bitDepth / 8), "Sample index out of range");
   switch (soundData->bitDepth) {
     case 8: ((int8_t*) soundData->blob.data)[index] = value * CHAR_MAX; break;
@@ -66,5 +160,13 @@ void lovrSoundDataSetSample(SoundData* soundData, size_t index, float value) {
 }
 
 void lovrSoundDataDestroy(void* ref) {
+  SoundData* soundData = ref;
+  if (soundData->decoder) {
+    stb_vorbis_close(soundData->decoder);
+  }
+  for (uint32_t i = 0; i < SOUND_CACHE_BLOCKS; i++) {
+    free(soundData->cache[i].data);
+  }
+  lovrRelease(Blob, soundData->compressed);
   lovrBlobDestroy(ref);
 }
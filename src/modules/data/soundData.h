@@ -1,24 +1,45 @@
 #include "data/blob.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 #pragma once
 
+// Compressed SoundData decodes blocks of frames into a small LRU cache as they're read
+#define SOUND_BLOCK_FRAMES 2048
+#define SOUND_CACHE_BLOCKS 4
+
 struct AudioStream;
 
+typedef struct {
+  int16_t* data;
+  size_t index;
+  uint32_t frames;
+  uint32_t tick;
+} SoundBlock;
+
+// The blob holds the samples, it's empty for compressed SoundData so anything that reads it directly
+// has to check lovrSoundDataIsCompressed first
 typedef struct SoundData {
   Blob blob;
   uint32_t channelCount;
   uint32_t sampleRate;
   size_t samples;
   uint32_t bitDepth;
+  Blob* compressed;
+  void* decoder;
+  size_t decoderOffset;
+  uint32_t tick;
+  SoundBlock cache[SOUND_CACHE_BLOCKS];
 } SoundData;
 
 SoundData* lovrSoundDataInit(SoundData* soundData, size_t samples, uint32_t sampleRate, uint32_t bitDepth, uint32_t channels);
 SoundData* lovrSoundDataInitFromAudioStream(SoundData* soundData, struct AudioStream* audioStream);
-SoundData* lovrSoundDataInitFromBlob(SoundData* soundData, Blob* blob);
+SoundData* lovrSoundDataInitFromBlob(SoundData* soundData, Blob* blob, bool decode);
 #define lovrSoundDataCreate(...) lovrSoundDataInit(lovrAlloc(SoundData), __VA_ARGS__)
 #define lovrSoundDataCreateFromAudioStream(...) lovrSoundDataInitFromAudioStream(lovrAlloc(SoundData), __VA_ARGS__)
 #define lovrSoundDataCreateFromBlob(...) lovrSoundDataInitFromBlob(lovrAlloc(SoundData), __VA_ARGS__)
+const int16_t* lovrSoundDataGetBlock(SoundData* soundData, size_t frame, size_t* count);
 float lovrSoundDataGetSample(SoundData* soundData, size_t index);
+bool lovrSoundDataIsCompressed(SoundData* soundData);
 void lovrSoundDataSetSample(SoundData* soundData, size_t index, float value);
 void lovrSoundDataDestroy(void* ref);
@@ -445,6 +445,22 @@ TextureData* lovrTextureDataInit(TextureData* textureData, uint32_t width, uint3
   return textureData;
 }
 
+// Uses the pixels in place and keeps a reference to them, so another thread can keep writing them
+TextureData* lovrTextureDataInitFromPixels(TextureData* textureData, uint32_t width, uint32_t height, TextureFormat format, Blob* pixels) {
+  lovrAssert(width > 0 && height > 0, "TextureData dimensions must be positive");
+  lovrAssert(format < FORMAT_DXT1, "Compressed TextureData can not be created from raw pixels");
+  size_t size = width * height * getPixelSize(format);
+  lovrAssert(pixels->size >= size, "TextureData needs %zu bytes of pixels, but the Blob only has %zu", size, pixels->size);
+  textureData->width = width;
+  textureData->height = height;
+  textureData->format = format;
+  textureData->blob.size = size;
+  textureData->blob.data = pixels->data;
+  textureData->source = pixels;
+  lovrRetain(pixels);
+  return textureData;
+}
+
 TextureData* lovrTextureDataInitFromBlob(TextureData* textureData, Blob* blob, bool flip) {
   if (parseDDS(blob->data, blob->size, textureData)) {
     textureData->source = blob;
@@ -580,7 +596,9 @@ void lovrTextureDataPaste(TextureData* textureData, TextureData* source, uint32_
 
 void lovrTextureDataDestroy(void* ref) {
   TextureData* textureData = ref;
+  if (!textureData->source || textureData->blob.data != textureData->source->data) {
+    lovrBlobDestroy(ref);
+  }
   lovrRelease(Blob, textureData->source);
   free(textureData->mipmaps);
-  lovrBlobDestroy(ref);
 }
@@ -60,7 +60,9 @@ typedef struct TextureData {
 TextureData* lovrTextureDataInit(TextureData* textureData, uint32_t width, uint32_t height, uint8_t value, TextureFormat format);
 TextureData* lovrTextureDataInitFromBlob(TextureData* textureData, Blob* blob, bool flip);
 #define lovrTextureDataCreate(...) lovrTextureDataInit(lovrAlloc(TextureData), __VA_ARGS__)
+TextureData* lovrTextureDataInitFromPixels(TextureData* textureData, uint32_t width, uint32_t height, TextureFormat format, Blob* pixels);
 #define lovrTextureDataCreateFromBlob(...) lovrTextureDataInitFromBlob(lovrAlloc(TextureData), __VA_ARGS__)
+#define lovrTextureDataCreateFromPixels(...) lovrTextureDataInitFromPixels(lovrAlloc(TextureData), __VA_ARGS__)
 Color lovrTextureDataGetPixel(TextureData* textureData, uint32_t x, uint32_t y);
 void lovrTextureDataSetPixel(TextureData* textureData, uint32_t x, uint32_t y, Color color);
 bool lovrTextureDataEncode(TextureData* textureData, const char* filename);
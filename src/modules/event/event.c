@@ -1,34 +1,97 @@
 #include "event/event.h"
 #include "platform.h"
 #include "core/arr.h"
+#include "core/atomic.h"
 #include "core/ref.h"
 #include "core/util.h"
 #include <stdlib.h>
 #include <string.h>
+#ifdef LOVR_ENABLE_THREAD
+#include "thread/thread.h"
+#include "lib/tinycthread/tinycthread.h"
+#endif
+
+// Must be a power of two
+#define EVENT_QUEUE_SIZE 256
+
+// Events can be pushed from any thread but only the main thread polls them.  Producers claim slots
+// in a preallocated ring with compare-and-swap, and a slot's sequence is its position + 1 once the
+// event is written.  When the ring is full, events go to a locked overflow list, which also gets
+// every later event until the main thread empties it, so a producer's events stay in order.
+typedef struct {
+  volatile uint64_t sequence;
+  Event event;
+} Slot;
 
 static struct {
   bool initialized;
-  arr_t(Event) events;
-  size_t head;
+  Slot slots[EVENT_QUEUE_SIZE];
+  uint8_t padding0[64];
+  volatile uint64_t tail;
+  uint8_t padding1[64];
+  uint64_t head;
+  volatile uint32_t overflowCount;
+  arr_t(Event) overflow;
+  size_t overflowHead;
+#ifdef LOVR_ENABLE_THREAD
+  mtx_t lock;
+#endif
 } state;
 
+static void lock() {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_lock(&state.lock);
+#endif
+}
+
+static void unlock() {
+#ifdef LOVR_ENABLE_THREAD
+  mtx_unlock(&state.lock);
+#endif
+}
+
+void lovrEventDiscard(Event* event) {
+  switch (event->type) {
+#ifdef LOVR_ENABLE_THREAD
+    case EVENT_THREAD_ERROR: lovrRelease(Thread, event->data.thread.thread); break;
+#endif
+    case EVENT_CUSTOM:
+      for (uint32_t i = 0; i < event->data.custom.count; i++) {
+        lovrVariantDestroy(&event->data.custom.data[i]);
+      }
+      break;
+    default: break;
+  }
+}
+
 void lovrVariantDestroy(Variant* variant) {
   switch (variant->type) {
-    case TYPE_STRING: free(variant->value.string); return;
+    case TYPE_STRING: free(variant->value.string.pointer); return;
     case TYPE_OBJECT: _lovrRelease(variant->value.object.pointer, variant->value.object.destructor); return;
+    case TYPE_PACKED: free(variant->value.packed.data); return;
     default: return;
   }
 }
 
 bool lovrEventInit() {
   if (state.initialized) return false;
-  arr_init(&state.events);
+  for (uint32_t i = 0; i < EVENT_QUEUE_SIZE; i++) {
+    state.slots[i].sequence = i;
+  }
+  arr_init(&state.overflow);
+#ifdef LOVR_ENABLE_THREAD
+  mtx_init(&state.lock, mtx_plain);
+#endif
   return state.initialized = true;
 }
 
 void lovrEventDestroy() {
   if (!state.initialized) return;
-  arr_free(&state.events);
+  lovrEventClear();
+  arr_free(&state.overflow);
+#ifdef LOVR_ENABLE_THREAD
+  mtx_destroy(&state.lock);
+#endif
   memset(&state, 0, sizeof(state));
 }
 
@@ -36,27 +99,86 @@ void lovrEventPump() {
   lovrPlatformPollEvents();
 }
 
+// Safe to call from any thread
 void lovrEventPush(Event event) {
+  if (!state.initialized) {
+    return;
+  }
+
 #ifdef LOVR_ENABLE_THREAD
   if (event.type == EVENT_THREAD_ERROR) {
     lovrRetain(event.data.thread.thread);
   }
 #endif
 
-  arr_push(&state.events, event);
+  if (atomic_load32(&state.overflowCount) == 0) {
+    uint64_t position = atomic_load64(&state.tail);
+    for (;;) {
+      Slot* slot = &state.slots[position & (EVENT_QUEUE_SIZE - 1)];
+      uint64_t sequence = atomic_load64(&slot->sequence);
+      if (sequence == position) {
+        if (atomic_cas64(&state.tail, &position, position + 1)) {
+          slot->event = event;
+          atomic_store64(&slot->sequence, position + 1);
+          return;
+        }
+      } else if (sequence < position) {
+        break;
+      } else {
+        position = atomic_load64(&state.tail);
+      }
+    }
+  }
+
+  lock();
+  arr_push(&state.overflow, event);
+  atomic_add32(&state.overflowCount, 1);
+  unlock();
 }
 
-bool lovrEventPoll(Event* event) {
-  if (state.head == state.events.length) {
-    state.head = state.events.length = 0;
-    return false;
+// Pops up to count events in one pass, only the main thread should call this.  A slot that has been
+// claimed but not written yet ends the drain, the event shows up on the next one.
+uint32_t lovrEventDrain(Event* events, uint32_t count) {
+  uint32_t n = 0;
+
+  while (n < count) {
+    Slot* slot = &state.slots[state.head & (EVENT_QUEUE_SIZE - 1)];
+    if (atomic_load64(&slot->sequence) != state.head + 1) {
+      break;
+    }
+    events[n++] = slot->event;
+    atomic_store64(&slot->sequence, state.head + EVENT_QUEUE_SIZE);
+    state.head++;
+  }
+
+  // Overflow events come after everything in the ring
+  if (n < count && atomic_load32(&state.overflowCount) > 0 && atomic_load64(&state.tail) == state.head) {
+    lock();
+    while (n < count && state.overflowHead < state.overflow.length) {
+      events[n++] = state.overflow.data[state.overflowHead++];
+    }
+    if (state.overflowHead == state.overflow.length) {
+      arr_clear(&state.overflow);
+      state.overflowHead = 0;
+      atomic_store32(&state.overflowCount, 0);
+    }
+    unlock();
   }
 
-  *event = state.events.data[state.head++];
-  return true;
+  return n;
 }
 
+bool lovrEventPoll(Event* event) {
+  return lovrEventDrain(event, 1) == 1;
+}
+
+// Discards pending events, releasing anything they hold on to
 void lovrEventClear() {
-  arr_clear(&state.events);
-  state.head = 0;
+  Event events[16];
+  uint32_t count;
+  while ((count = lovrEventDrain(events, 16)) > 0) {
+    for (uint32_t i = 0; i < count; i++) {
+      lovrEventDiscard(&events[i]);
+    }
+  }
 }
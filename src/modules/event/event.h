@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #pragma once
@@ -21,18 +22,27 @@ typedef enum {
   TYPE_BOOLEAN,
   TYPE_NUMBER,
   TYPE_STRING,
-  TYPE_OBJECT
+  TYPE_OBJECT,
+  TYPE_PACKED
 } VariantType;
 
+// Packed values are tables and vectors serialized into a single allocation (see l_event.c)
 typedef union {
   bool boolean;
   double number;
-  char* string;
+  struct {
+    char* pointer;
+    size_t length;
+  } string;
   struct {
     void* pointer;
     const char* type;
     void (*destructor)(void*);
   } object;
+  struct {
+    void* data;
+    size_t size;
+  } packed;
 } VariantValue;
 
 typedef struct Variant {
@@ -73,10 +83,12 @@ typedef struct {
 } Event;
 
 void lovrVariantDestroy(Variant* variant);
+void lovrEventDiscard(Event* event);
 
 bool lovrEventInit(void);
 void lovrEventDestroy(void);
 void lovrEventPump(void);
 void lovrEventPush(Event event);
+uint32_t lovrEventDrain(Event* events, uint32_t count);
 bool lovrEventPoll(Event* event);
 void lovrEventClear(void);
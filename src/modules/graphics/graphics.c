@@ -543,6 +543,8 @@ void lovrGraphicsSetProjection(mat4 projection) {
 // Rendering
 
 static void lovrGraphicsBatch(BatchRequest* req) {
+  static istr_t skyboxTexture = { .string = "lovrSkyboxTexture" };
+  static istr_t pose = { .string = "lovrPose" };
 
   // Resolve objects
   Mesh* mesh = req->mesh ? req->mesh : (req->instanced ? state.instancedMesh : state.mesh);
@@ -553,17 +555,17 @@ static void lovrGraphicsBatch(BatchRequest* req) {
 
   if (!req->material) {
     if (req->type == BATCH_SKYBOX && lovrTextureGetType(req->texture) == TEXTURE_CUBE) {
-      lovrShaderSetTextures(shader, "lovrSkyboxTexture", &req->texture, 0, 1);
+      lovrShaderSetTextures(shader, &skyboxTexture, &req->texture, 0, 1);
     } else {
       lovrMaterialSetTexture(material, TEXTURE_DIFFUSE, req->texture);
     }
   }
 
-  if (req->type == BATCH_MESH && lovrShaderHasUniform(shader, "lovrPose")) {
+  if (req->type == BATCH_MESH && lovrShaderHasUniform(shader, &pose)) {
     if (req->params.mesh.pose) {
-      lovrShaderSetMatrices(shader, "lovrPose", req->params.mesh.pose, 0, MAX_BONES * 16);
+      lovrShaderSetMatrices(shader, &pose, req->params.mesh.pose, 0, MAX_BONES * 16);
     } else {
-      lovrShaderSetMatrices(shader, "lovrPose", (float[]) MAT4_IDENTITY, 0, 16);
+      lovrShaderSetMatrices(shader, &pose, (float[]) MAT4_IDENTITY, 0, 16);
     }
   }
 
@@ -706,16 +708,21 @@ void lovrGraphicsFlush() {
     state.tail[i] = state.head[i];
   }
 
+  static istr_t modelBlock = { .string = "lovrModelBlock" };
+  static istr_t colorBlock = { .string = "lovrColorBlock" };
+  static istr_t frameBlock = { .string = "lovrFrameBlock" };
+  static istr_t pointSize = { .string = "lovrPointSize" };
+
   for (int b = 0; b < batchCount; b++) {
     Batch* batch = &state.batches[b];
 
     // Uniforms
     lovrMaterialBind(batch->material, batch->draw.shader);
-    lovrShaderSetBlock(batch->draw.shader, "lovrModelBlock", state.buffers[STREAM_MODEL], batch->drawStart * bufferStride[STREAM_MODEL], MAX_DRAWS * bufferStride[STREAM_MODEL], ACCESS_READ);
-    lovrShaderSetBlock(batch->draw.shader, "lovrColorBlock", state.buffers[STREAM_COLOR], batch->drawStart * bufferStride[STREAM_COLOR], MAX_DRAWS * bufferStride[STREAM_COLOR], ACCESS_READ);
-    lovrShaderSetBlock(batch->draw.shader, "lovrFrameBlock", state.buffers[STREAM_FRAME], (state.head[STREAM_FRAME] - 1) * bufferStride[STREAM_FRAME], bufferStride[STREAM_FRAME], ACCESS_READ);
+    lovrShaderSetBlock(batch->draw.shader, &modelBlock, state.buffers[STREAM_MODEL], batch->drawStart * bufferStride[STREAM_MODEL], MAX_DRAWS * bufferStride[STREAM_MODEL], ACCESS_READ);
+    lovrShaderSetBlock(batch->draw.shader, &colorBlock, state.buffers[STREAM_COLOR], batch->drawStart * bufferStride[STREAM_COLOR], MAX_DRAWS * bufferStride[STREAM_COLOR], ACCESS_READ);
+    lovrShaderSetBlock(batch->draw.shader, &frameBlock, state.buffers[STREAM_FRAME], (state.head[STREAM_FRAME] - 1) * bufferStride[STREAM_FRAME], bufferStride[STREAM_FRAME], ACCESS_READ);
     if (batch->draw.topology == DRAW_POINTS) {
-      lovrShaderSetFloats(batch->draw.shader, "lovrPointSize", &state.pointSize, 0, 1);
+      lovrShaderSetFloats(batch->draw.shader, &pointSize, &state.pointSize, 0, 1);
     }
 
     // Other bindings (TODO try to get rid of all this!)
@@ -17,6 +17,7 @@ struct Shader;
 struct Texture;
 
 typedef void (*StencilCallback)(void* userdata);
+typedef void (*MemoryBudgetCallback)(void* userdata, size_t memory, size_t budget);
 
 typedef enum {
   ARC_MODE_PIE,
@@ -106,6 +107,8 @@ struct Buffer* lovrGraphicsGetIdentityBuffer(void);
 #define lovrGraphicsGetFeatures lovrGpuGetFeatures
 #define lovrGraphicsGetLimits lovrGpuGetLimits
 #define lovrGraphicsGetStats lovrGpuGetStats
+#define lovrGraphicsGetMemoryBudget lovrGpuGetMemoryBudget
+#define lovrGraphicsSetMemoryBudget lovrGpuSetMemoryBudget
 
 // State
 void lovrGraphicsReset(void);
@@ -195,9 +198,19 @@ typedef struct {
   int blockAlign;
 } GpuLimits;
 
+typedef enum {
+  MEMORY_TEXTURE,
+  MEMORY_BUFFER,
+  MEMORY_CANVAS,
+  MAX_MEMORY_TYPES
+} MemoryType;
+
 typedef struct {
   uint32_t shaderSwitches;
   uint32_t drawCalls;
+  size_t memory;
+  size_t typeMemory[MAX_MEMORY_TYPES];
+  uint32_t typeCount[MAX_MEMORY_TYPES];
 } GpuStats;
 
 typedef struct {
@@ -225,3 +238,5 @@ double lovrGpuTock(const char* label);
 const GpuFeatures* lovrGpuGetFeatures(void);
 const GpuLimits* lovrGpuGetLimits(void);
 const GpuStats* lovrGpuGetStats(void);
+size_t lovrGpuGetMemoryBudget(void);
+void lovrGpuSetMemoryBudget(size_t budget, MemoryBudgetCallback callback, void* userdata);
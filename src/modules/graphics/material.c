@@ -34,18 +34,19 @@ void lovrMaterialDestroy(void* ref) {
 
 void lovrMaterialBind(Material* material, Shader* shader) {
   for (int i = 0; i < MAX_MATERIAL_SCALARS; i++) {
-    lovrShaderSetFloats(shader, lovrShaderScalarUniforms[i], &material->scalars[i], 0, 1);
+    lovrShaderSetFloats(shader, &lovrShaderScalarUniforms[i], &material->scalars[i], 0, 1);
   }
 
   for (int i = 0; i < MAX_MATERIAL_COLORS; i++) {
-    lovrShaderSetColor(shader, lovrShaderColorUniforms[i], material->colors[i]);
+    lovrShaderSetColor(shader, &lovrShaderColorUniforms[i], material->colors[i]);
   }
 
   for (int i = 0; i < MAX_MATERIAL_TEXTURES; i++) {
-    lovrShaderSetTextures(shader, lovrShaderTextureUniforms[i], &material->textures[i], 0, 1);
+    lovrShaderSetTextures(shader, &lovrShaderTextureUniforms[i], &material->textures[i], 0, 1);
   }
 
-  lovrShaderSetMatrices(shader, "lovrMaterialTransform", material->transform, 0, 9);
+  static istr_t transform = { .string = "lovrMaterialTransform" };
+  lovrShaderSetMatrices(shader, &transform, material->transform, 0, 9);
 }
 
 float lovrMaterialGetScalar(Material* material, MaterialScalar scalarType) {
@@ -96,6 +96,9 @@ static struct {
   GpuFeatures features;
   GpuLimits limits;
   GpuStats stats;
+  size_t memoryBudget;
+  MemoryBudgetCallback memoryBudgetCallback;
+  void* memoryBudgetUserdata;
 } state;
 
 // Helper functions
@@ -291,6 +294,46 @@ static bool isTextureFormatCompressed(TextureFormat format) {
   }
 }
 
+// Returns the size of a block of pixels, blocks are 1x1 for uncompressed formats
+static size_t getTextureFormatBlockSize(TextureFormat format, uint32_t* blockWidth, uint32_t* blockHeight) {
+  *blockWidth = *blockHeight = 1;
+  switch (format) {
+    case FORMAT_RGB: return 3;
+    case FORMAT_RGBA: return 4;
+    case FORMAT_RGBA4: return 2;
+    case FORMAT_RGBA16F: return 8;
+    case FORMAT_RGBA32F: return 16;
+    case FORMAT_R16F: return 2;
+    case FORMAT_R32F: return 4;
+    case FORMAT_RG16F: return 4;
+    case FORMAT_RG32F: return 8;
+    case FORMAT_RGB5A1: return 2;
+    case FORMAT_RGB10A2: return 4;
+    case FORMAT_RG11B10F: return 4;
+    case FORMAT_D16: return 2;
+    case FORMAT_D32F: return 4;
+    case FORMAT_D24S8: return 4;
+    case FORMAT_DXT1: *blockWidth = 4, *blockHeight = 4; return 8;
+    case FORMAT_DXT3: *blockWidth = 4, *blockHeight = 4; return 16;
+    case FORMAT_DXT5: *blockWidth = 4, *blockHeight = 4; return 16;
+    case FORMAT_ASTC_4x4: *blockWidth = 4, *blockHeight = 4; return 16;
+    case FORMAT_ASTC_5x4: *blockWidth = 5, *blockHeight = 4; return 16;
+    case FORMAT_ASTC_5x5: *blockWidth = 5, *blockHeight = 5; return 16;
+    case FORMAT_ASTC_6x5: *blockWidth = 6, *blockHeight = 5; return 16;
+    case FORMAT_ASTC_6x6: *blockWidth = 6, *blockHeight = 6; return 16;
+    case FORMAT_ASTC_8x5: *blockWidth = 8, *blockHeight = 5; return 16;
+    case FORMAT_ASTC_8x6: *blockWidth = 8, *blockHeight = 6; return 16;
+    case FORMAT_ASTC_8x8: *blockWidth = 8, *blockHeight = 8; return 16;
+    case FORMAT_ASTC_10x5: *blockWidth = 10, *blockHeight = 5; return 16;
+    case FORMAT_ASTC_10x6: *blockWidth = 10, *blockHeight = 6; return 16;
+    case FORMAT_ASTC_10x8: *blockWidth = 10, *blockHeight = 8; return 16;
+    case FORMAT_ASTC_10x10: *blockWidth = 10, *blockHeight = 10; return 16;
+    case FORMAT_ASTC_12x10: *blockWidth = 12, *blockHeight = 10; return 16;
+    case FORMAT_ASTC_12x12: *blockWidth = 12, *blockHeight = 12; return 16;
+    default: lovrThrow("Unreachable");
+  }
+}
+
 static bool isTextureFormatDepth(TextureFormat format) {
   switch (format) {
     case FORMAT_D16: case FORMAT_D32F: case FORMAT_D24S8: return true;
@@ -478,6 +521,25 @@ static void lovrGpuDestroySyncResource(void* resource, uint8_t incoherent) {
   }
 }
 
+static void lovrGpuTrackMemory(MemoryType type, size_t size) {
+  size_t previous = state.stats.memory;
+  state.stats.memory += size;
+  state.stats.typeMemory[type] += size;
+  state.stats.typeCount[type]++;
+
+  // Only notify when crossing the budget, so the callback doesn't fire for every allocation
+  bool crossed = state.memoryBudget > 0 && previous <= state.memoryBudget && state.stats.memory > state.memoryBudget;
+  if (crossed && state.memoryBudgetCallback) {
+    state.memoryBudgetCallback(state.memoryBudgetUserdata, state.stats.memory, state.memoryBudget);
+  }
+}
+
+static void lovrGpuUntrackMemory(MemoryType type, size_t size) {
+  state.stats.memory -= size;
+  state.stats.typeMemory[type] -= size;
+  state.stats.typeCount[type]--;
+}
+
 static void lovrGpuBindFramebuffer(uint32_t framebuffer) {
   if (state.framebuffer != framebuffer) {
     state.framebuffer = framebuffer;
@@ -1195,6 +1257,8 @@ void lovrGpuDiscard(Canvas* canvas, bool color, bool depth, bool stencil) {
 }
 
 void lovrGpuDraw(DrawCommand* draw) {
+  static istr_t viewportCountName = { .string = "lovrViewportCount" };
+  static istr_t viewIdName = { .string = "lovrViewID" };
   lovrAssert(state.singlepass != MULTIVIEW || draw->shader->multiview == draw->canvas->flags.stereo, "Shader and Canvas multiview settings must match!");
   uint32_t viewportCount = (draw->canvas->flags.stereo && state.singlepass != MULTIVIEW) ? 2 : 1;
   uint32_t drawCount = state.singlepass == NONE ? viewportCount : 1;
@@ -1205,7 +1269,7 @@ void lovrGpuDraw(DrawCommand* draw) {
   float w = state.singlepass == MULTIVIEW ? draw->canvas->width : draw->canvas->width / (float) viewportCount;
   float h = draw->canvas->height;
   float viewports[2][4] = { { 0.f, 0.f, w, h }, { w, 0.f, w, h } };
-  lovrShaderSetInts(draw->shader, "lovrViewportCount", &(int) { viewportCount }, 0, 1);
+  lovrShaderSetInts(draw->shader, &viewportCountName, &(int) { viewportCount }, 0, 1);
 
   lovrGpuBindCanvas(draw->canvas, true);
   lovrGpuBindPipeline(&draw->pipeline);
@@ -1213,7 +1277,7 @@ void lovrGpuDraw(DrawCommand* draw) {
 
   for (uint32_t i = 0; i < drawCount; i++) {
     lovrGpuSetViewports(&viewports[i][0], viewportsPerDraw);
-    lovrShaderSetInts(draw->shader, "lovrViewID", &(int) { i }, 0, 1);
+    lovrShaderSetInts(draw->shader, &viewIdName, &(int) { i }, 0, 1);
     lovrGpuBindShader(draw->shader);
 
     Mesh* mesh = draw->mesh;
@@ -1239,7 +1303,8 @@ void lovrGpuDraw(DrawCommand* draw) {
 }
 
 void lovrGpuPresent() {
-  memset(&state.stats, 0, sizeof(state.stats));
+  state.stats.shaderSwitches = 0;
+  state.stats.drawCalls = 0;
 }
 
 void lovrGpuStencil(StencilAction action, int replaceValue, StencilCallback callback, void* userdata) {
@@ -1393,6 +1458,16 @@ const GpuStats* lovrGpuGetStats() {
   return &state.stats;
 }
 
+size_t lovrGpuGetMemoryBudget() {
+  return state.memoryBudget;
+}
+
+void lovrGpuSetMemoryBudget(size_t budget, MemoryBudgetCallback callback, void* userdata) {
+  state.memoryBudget = budget;
+  state.memoryBudgetCallback = callback;
+  state.memoryBudgetUserdata = userdata;
+}
+
 // Texture
 
 Texture* lovrTextureInit(Texture* texture, TextureType type, TextureData** slices, uint32_t sliceCount, bool srgb, bool mipmaps, uint32_t msaa) {
@@ -1440,6 +1515,9 @@ Texture* lovrTextureInitFromHandle(Texture* texture, uint32_t handle, TextureTyp
 
 void lovrTextureDestroy(void* ref) {
   Texture* texture = ref;
+  if (texture->allocated) {
+    lovrGpuUntrackMemory(MEMORY_TEXTURE, texture->memory);
+  }
   glDeleteTextures(1, &texture->id);
   glDeleteRenderbuffers(1, &texture->msaaId);
   lovrGpuDestroySyncResource(texture, texture->incoherent);
@@ -1468,6 +1546,19 @@ void lovrTextureAllocate(Texture* texture, uint32_t width, uint32_t height, uint
     texture->mipmapCount = 1;
   }
 
+  uint32_t blockWidth, blockHeight;
+  size_t blockSize = getTextureFormatBlockSize(format, &blockWidth, &blockHeight);
+  uint32_t w = width, h = height, d = depth;
+  texture->memory = 0;
+  for (uint32_t i = 0; i < texture->mipmapCount; i++) {
+    texture->memory += (size_t) ((w + blockWidth - 1) / blockWidth) * ((h + blockHeight - 1) / blockHeight) * d * blockSize;
+    w = MAX(w >> 1, 1);
+    h = MAX(h >> 1, 1);
+    d = texture->type == TEXTURE_VOLUME ? MAX(d >> 1, 1) : d;
+  }
+  texture->memory += (size_t) width * height * blockSize * texture->msaa;
+  lovrGpuTrackMemory(MEMORY_TEXTURE, texture->memory);
+
   if (isTextureFormatCompressed(format)) {
     return;
   }
@@ -1660,6 +1751,9 @@ Canvas* lovrCanvasInit(Canvas* canvas, uint32_t width, uint32_t height, CanvasFl
       glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, canvas->depth.texture->id, 0);
     } else {
       GLenum format = convertTextureFormatInternal(flags.depth.format, false);
+      uint32_t blockWidth, blockHeight;
+      size_t pixelSize = getTextureFormatBlockSize(flags.depth.format, &blockWidth, &blockHeight);
+      canvas->memory = (size_t) width * height * pixelSize * MAX(flags.msaa, 1);
       glGenRenderbuffers(1, &canvas->depthBuffer);
       glBindRenderbuffer(GL_RENDERBUFFER, canvas->depthBuffer);
       glRenderbufferStorageMultisample(GL_RENDERBUFFER, canvas->flags.msaa, format, width, height);
@@ -1671,6 +1765,7 @@ Canvas* lovrCanvasInit(Canvas* canvas, uint32_t width, uint32_t height, CanvasFl
     glGenFramebuffers(1, &canvas->resolveBuffer);
   }
 
+  lovrGpuTrackMemory(MEMORY_CANVAS, canvas->memory);
   return canvas;
 }
 
@@ -1690,6 +1785,7 @@ void lovrCanvasDestroy(void* ref) {
   Canvas* canvas = ref;
   lovrGraphicsFlushCanvas(canvas);
   if (!canvas->immortal) {
+    lovrGpuUntrackMemory(MEMORY_CANVAS, canvas->memory);
     glDeleteFramebuffers(1, &canvas->framebuffer);
     glDeleteRenderbuffers(1, &canvas->depthBuffer);
     glDeleteFramebuffers(1, &canvas->resolveBuffer);
@@ -1796,11 +1892,13 @@ Buffer* lovrBufferInit(Buffer* buffer, size_t size, void* data, BufferType type,
   }
 #endif
 
+  lovrGpuTrackMemory(MEMORY_BUFFER, size);
   return buffer;
 }
 
 void lovrBufferDestroy(void* ref) {
   Buffer* buffer = ref;
+  lovrGpuUntrackMemory(MEMORY_BUFFER, buffer->size);
   lovrGpuDestroySyncResource(buffer, buffer->incoherent);
   glDeleteBuffers(1, &buffer->id);
 #ifdef LOVR_WEBGL
@@ -2108,7 +2206,8 @@ static void lovrShaderSetupUniforms(Shader* shader) {
       offset += uniform.components * (uniform.type == UNIFORM_MATRIX ? uniform.components : 1);
     }
 
-    map_set(&shader->uniformMap, hash64(uniform.name, length), shader->uniforms.length);
+    uniform.hash = hash64(uniform.name, length);
+    map_set(&shader->uniformMap, uniform.hash, shader->uniforms.length);
     arr_push(&shader->uniforms, uniform);
     textureSlot += uniform.type == UNIFORM_SAMPLER ? uniform.count : 0;
     imageSlot += uniform.type == UNIFORM_IMAGE ? uniform.count : 0;
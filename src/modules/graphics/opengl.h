@@ -7,6 +7,7 @@
 #include "lib/glad/glad.h"
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
 
 #pragma once
@@ -17,6 +18,7 @@
 
 #define GPU_CANVAS_FIELDS \
   bool immortal; \
+  size_t memory; \
   uint32_t framebuffer; \
   uint32_t resolveBuffer; \
   uint32_t depthBuffer;
@@ -30,6 +32,7 @@
 
 #define GPU_TEXTURE_FIELDS \
   uint8_t incoherent; \
+  size_t memory; \
   GLuint id; \
   GLuint msaaId; \
   GLenum target;
@@ -82,8 +82,8 @@ int lovrShaderGetAttributeLocation(Shader* shader, const char* name) {
   return location == MAP_NIL ? -1 : (int) location;
 }
 
-bool lovrShaderHasUniform(Shader* shader, const char* name) {
-  return map_get(&shader->uniformMap, hash64(name, strlen(name))) != MAP_NIL;
+bool lovrShaderHasUniform(Shader* shader, istr_t* name) {
+  return map_get(&shader->uniformMap, istr_hash(name)) != MAP_NIL;
 }
 
 const Uniform* lovrShaderGetUniform(Shader* shader, const char* name) {
@@ -91,15 +91,15 @@ const Uniform* lovrShaderGetUniform(Shader* shader, const char* name) {
   return index == MAP_NIL ? NULL : &shader->uniforms.data[index];
 }
 
-static void lovrShaderSetUniform(Shader* shader, const char* name, UniformType type, void* data, int start, int count, int size, const char* debug) {
-  uint64_t index = map_get(&shader->uniformMap, hash64(name, strlen(name)));
+static void lovrShaderSetUniform(Shader* shader, istr_t* name, UniformType type, void* data, int start, int count, int size, const char* debug) {
+  uint64_t index = map_get(&shader->uniformMap, istr_hash(name));
   if (index == MAP_NIL) {
     return;
   }
 
   Uniform* uniform = &shader->uniforms.data[index];
-  lovrAssert(uniform->type == type, "Unable to send %ss to uniform %s", debug, name);
-  lovrAssert((start + count) * size <= uniform->size, "Too many %ss for uniform %s, maximum is %d", debug, name, uniform->size / size);
+  lovrAssert(uniform->type == type, "Unable to send %ss to uniform %s", debug, name->string);
+  lovrAssert((start + count) * size <= uniform->size, "Too many %ss for uniform %s, maximum is %d", debug, name->string, uniform->size / size);
 
   void* dest = uniform->value.bytes + start * size;
   if (memcmp(dest, data, count * size)) {
@@ -109,35 +109,35 @@ static void lovrShaderSetUniform(Shader* shader, const char* name, UniformType t
   }
 }
 
-void lovrShaderSetFloats(Shader* shader, const char* name, float* data, int start, int count) {
+void lovrShaderSetFloats(Shader* shader, istr_t* name, float* data, int start, int count) {
   lovrShaderSetUniform(shader, name, UNIFORM_FLOAT, data, start, count, sizeof(float), "float");
 }
 
-void lovrShaderSetInts(Shader* shader, const char* name, int* data, int start, int count) {
+void lovrShaderSetInts(Shader* shader, istr_t* name, int* data, int start, int count) {
   lovrShaderSetUniform(shader, name, UNIFORM_INT, data, start, count, sizeof(int), "int");
 }
 
-void lovrShaderSetMatrices(Shader* shader, const char* name, float* data, int start, int count) {
+void lovrShaderSetMatrices(Shader* shader, istr_t* name, float* data, int start, int count) {
   lovrShaderSetUniform(shader, name, UNIFORM_MATRIX, data, start, count, sizeof(float), "float");
 }
 
-void lovrShaderSetTextures(Shader* shader, const char* name, Texture** data, int start, int count) {
+void lovrShaderSetTextures(Shader* shader, istr_t* name, Texture** data, int start, int count) {
   lovrShaderSetUniform(shader, name, UNIFORM_SAMPLER, data, start, count, sizeof(Texture*), "texture");
 }
 
-void lovrShaderSetImages(Shader* shader, const char* name, Image* data, int start, int count) {
+void lovrShaderSetImages(Shader* shader, istr_t* name, Image* data, int start, int count) {
   lovrShaderSetUniform(shader, name, UNIFORM_IMAGE, data, start, count, sizeof(Image), "image");
 }
 
-void lovrShaderSetColor(Shader* shader, const char* name, Color color) {
+void lovrShaderSetColor(Shader* shader, istr_t* name, Color color) {
   color.r = lovrMathGammaToLinear(color.r);
   color.g = lovrMathGammaToLinear(color.g);
   color.b = lovrMathGammaToLinear(color.b);
   lovrShaderSetUniform(shader, name, UNIFORM_FLOAT, (float*) &color, 0, 4, sizeof(float), "float");
 }
 
-void lovrShaderSetBlock(Shader* shader, const char* name, Buffer* buffer, size_t offset, size_t size, UniformAccess access) {
-  uint64_t id = map_get(&shader->blockMap, hash64(name, strlen(name)));
+void lovrShaderSetBlock(Shader* shader, istr_t* name, Buffer* buffer, size_t offset, size_t size, UniformAccess access) {
+  uint64_t id = map_get(&shader->blockMap, istr_hash(name));
   if (id == MAP_NIL) return;
 
   int type = id & 1;
@@ -184,7 +184,8 @@ ShaderBlock* lovrShaderBlockInit(ShaderBlock* block, BlockType type, Buffer* buf
 
   for (size_t i = 0; i < block->uniforms.length; i++) {
     Uniform* uniform = &block->uniforms.data[i];
-    map_set(&block->uniformMap, hash64(uniform->name, strlen(uniform->name)), i);
+    uniform->hash = hash64(uniform->name, strlen(uniform->name));
+    map_set(&block->uniformMap, uniform->hash, i);
   }
 
   block->type = type;
@@ -1,6 +1,7 @@
 #include "graphics/texture.h"
 #include "graphics/opengl.h"
 #include "core/arr.h"
+#include "core/hash.h"
 #include <stdbool.h>
 
 #pragma once
@@ -69,6 +70,7 @@ typedef struct {
 
 typedef struct Uniform {
   char name[LOVR_MAX_UNIFORM_LENGTH];
+  uint64_t hash;
   UniformType type;
   int components;
   int count;
@@ -131,15 +133,15 @@ Shader* lovrShaderInitDefault(Shader* shader, DefaultShader type, ShaderFlag* fl
 void lovrShaderDestroy(void* ref);
 ShaderType lovrShaderGetType(Shader* shader);
 int lovrShaderGetAttributeLocation(Shader* shader, const char* name);
-bool lovrShaderHasUniform(Shader* shader, const char* name);
+bool lovrShaderHasUniform(Shader* shader, istr_t* name);
 const Uniform* lovrShaderGetUniform(Shader* shader, const char* name);
-void lovrShaderSetFloats(Shader* shader, const char* name, float* data, int start, int count);
-void lovrShaderSetInts(Shader* shader, const char* name, int* data, int start, int count);
-void lovrShaderSetMatrices(Shader* shader, const char* name, float* data, int start, int count);
-void lovrShaderSetTextures(Shader* shader, const char* name, struct Texture** data, int start, int count);
-void lovrShaderSetImages(Shader* shader, const char* name, Image* data, int start, int count);
-void lovrShaderSetColor(Shader* shader, const char* name, Color color);
-void lovrShaderSetBlock(Shader* shader, const char* name, struct Buffer* buffer, size_t offset, size_t size, UniformAccess access);
+void lovrShaderSetFloats(Shader* shader, istr_t* name, float* data, int start, int count);
+void lovrShaderSetInts(Shader* shader, istr_t* name, int* data, int start, int count);
+void lovrShaderSetMatrices(Shader* shader, istr_t* name, float* data, int start, int count);
+void lovrShaderSetTextures(Shader* shader, istr_t* name, struct Texture** data, int start, int count);
+void lovrShaderSetImages(Shader* shader, istr_t* name, Image* data, int start, int count);
+void lovrShaderSetColor(Shader* shader, istr_t* name, Color color);
+void lovrShaderSetBlock(Shader* shader, istr_t* name, struct Buffer* buffer, size_t offset, size_t size, UniformAccess access);
 
 // ShaderBlock
 
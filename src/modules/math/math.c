@@ -63,3 +63,250 @@ float lovrMathNoise3(float x, float y, float z) {
 float lovrMathNoise4(float x, float y, float z, float w) {
   return noise4(x, y, z, w) * .5f + .5f;
 }
+
+// Batch kernels work on tightly packed arrays (3 floats per point, 4 per quaternion, 16 per matrix)
+// and can work in place.  The SIMD paths process 4 points at a time in SoA form.
+
+#ifdef LOVR_SSE
+// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 <-> x0 x1 x2 x3 | y0 y1 y2 y3 | z0 z1 z2 z3
+static inline void deinterleave(const float* p, __m128* x, __m128* y, __m128* z) {
+  __m128 a = _mm_loadu_ps(p + 0);
+  __m128 b = _mm_loadu_ps(p + 4);
+  __m128 c = _mm_loadu_ps(p + 8);
+  *x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+  *y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+  *z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+static inline void interleave(float* p, __m128 x, __m128 y, __m128 z) {
+  __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+  __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+  __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+  _mm_storeu_ps(p + 0, a);
+  _mm_storeu_ps(p + 4, b);
+  _mm_storeu_ps(p + 8, c);
+}
+#endif
+
+#ifdef LOVR_NEON
+// 32 bit ARM doesn't have vector division, use 2 refinement steps on the reciprocal estimate
+static inline float32x4_t divide(float32x4_t a, float32x4_t b) {
+#ifdef __aarch64__
+  return vdivq_f32(a, b);
+#else
+  float32x4_t r = vrecpeq_f32(b);
+  r = vmulq_f32(r, vrecpsq_f32(b, r));
+  r = vmulq_f32(r, vrecpsq_f32(b, r));
+  return vmulq_f32(a, r);
+#endif
+}
+#endif
+
+// Same as mat4_transform, including the divide by w
+void lovrMathTransformPoints(mat4 m, const float* input, float* output, uint32_t count) {
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE)
+  __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]), m3 = _mm_set1_ps(m[3]);
+  __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]), m7 = _mm_set1_ps(m[7]);
+  __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]), m11 = _mm_set1_ps(m[11]);
+  __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]), m15 = _mm_set1_ps(m[15]);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x, y, z;
+    deinterleave(input + 3 * i, &x, &y, &z);
+    __m128 tx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m0), _mm_mul_ps(y, m4)), _mm_mul_ps(z, m8)), m12);
+    __m128 ty = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m1), _mm_mul_ps(y, m5)), _mm_mul_ps(z, m9)), m13);
+    __m128 tz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m2), _mm_mul_ps(y, m6)), _mm_mul_ps(z, m10)), m14);
+    __m128 tw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m3), _mm_mul_ps(y, m7)), _mm_mul_ps(z, m11)), m15);
+    interleave(output + 3 * i, _mm_div_ps(tx, tw), _mm_div_ps(ty, tw), _mm_div_ps(tz, tw));
+  }
+#elif defined(LOVR_NEON)
+  for (; i + 4 <= count; i += 4) {
+    float32x4x3_t p = vld3q_f32(input + 3 * i);
+    float32x4_t x = p.val[0], y = p.val[1], z = p.val[2];
+    float32x4_t tx = vaddq_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(x, m[0]), y, m[4]), z, m[8]), vdupq_n_f32(m[12]));
+    float32x4_t ty = vaddq_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(x, m[1]), y, m[5]), z, m[9]), vdupq_n_f32(m[13]));
+    float32x4_t tz = vaddq_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(x, m[2]), y, m[6]), z, m[10]), vdupq_n_f32(m[14]));
+    float32x4_t tw = vaddq_f32(vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(x, m[3]), y, m[7]), z, m[11]), vdupq_n_f32(m[15]));
+    p.val[0] = divide(tx, tw);
+    p.val[1] = divide(ty, tw);
+    p.val[2] = divide(tz, tw);
+    vst3q_f32(output + 3 * i, p);
+  }
+#endif
+
+  for (; i < count; i++) {
+    float v[4] = { input[3 * i + 0], input[3 * i + 1], input[3 * i + 2] };
+    mat4_transform(m, v);
+    output[3 * i + 0] = v[0];
+    output[3 * i + 1] = v[1];
+    output[3 * i + 2] = v[2];
+  }
+}
+
+// Zero length vectors are left alone, like vec3_normalize
+void lovrMathNormalizeVectors(const float* input, float* output, uint32_t count) {
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE)
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.f);
+  for (; i + 4 <= count; i += 4) {
+    __m128 x, y, z;
+    deinterleave(input + 3 * i, &x, &y, &z);
+    __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    __m128 empty = _mm_cmpeq_ps(length, zero);
+    __m128 scale = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(empty, one), _mm_andnot_ps(empty, length)));
+    interleave(output + 3 * i, _mm_mul_ps(x, scale), _mm_mul_ps(y, scale), _mm_mul_ps(z, scale));
+  }
+#elif defined(LOVR_NEON)
+  float32x4_t zero = vdupq_n_f32(0.f);
+  float32x4_t one = vdupq_n_f32(1.f);
+  for (; i + 4 <= count; i += 4) {
+    float32x4x3_t p = vld3q_f32(input + 3 * i);
+    float32x4_t x = p.val[0], y = p.val[1], z = p.val[2];
+    float32x4_t length2 = vmlaq_f32(vmlaq_f32(vmulq_f32(x, x), y, y), z, z);
+    uint32x4_t empty = vceqq_f32(length2, zero);
+    float32x4_t r = vrsqrteq_f32(length2);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(length2, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(length2, r), r));
+    float32x4_t scale = vbslq_f32(empty, one, r);
+    p.val[0] = vmulq_f32(x, scale);
+    p.val[1] = vmulq_f32(y, scale);
+    p.val[2] = vmulq_f32(z, scale);
+    vst3q_f32(output + 3 * i, p);
+  }
+#endif
+
+  for (; i < count; i++) {
+    float v[4] = { input[3 * i + 0], input[3 * i + 1], input[3 * i + 2] };
+    vec3_normalize(v);
+    output[3 * i + 0] = v[0];
+    output[3 * i + 1] = v[1];
+    output[3 * i + 2] = v[2];
+  }
+}
+
+// Slerp needs acos and sin for each pair, so there isn't a SIMD path
+void lovrMathSlerpQuaternions(const float* a, const float* b, float t, float* output, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    float q[4], r[4];
+    memcpy(q, a + 4 * i, sizeof(q));
+    memcpy(r, b + 4 * i, sizeof(r));
+    quat_slerp(q, r, t);
+    memcpy(output + 4 * i, q, sizeof(q));
+  }
+}
+
+// Sets each output matrix to m * input, like mat4_multiply
+void lovrMathMultiplyMatrices(mat4 m, const float* input, float* output, uint32_t count) {
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE)
+  __m128 c0 = _mm_loadu_ps(m + 0);
+  __m128 c1 = _mm_loadu_ps(m + 4);
+  __m128 c2 = _mm_loadu_ps(m + 8);
+  __m128 c3 = _mm_loadu_ps(m + 12);
+  for (; i < count; i++) {
+    const float* n = input + 16 * i;
+    __m128 columns[4];
+    for (int j = 0; j < 4; j++) {
+      __m128 x = _mm_mul_ps(c0, _mm_set1_ps(n[4 * j + 0]));
+      __m128 y = _mm_mul_ps(c1, _mm_set1_ps(n[4 * j + 1]));
+      __m128 z = _mm_mul_ps(c2, _mm_set1_ps(n[4 * j + 2]));
+      __m128 w = _mm_mul_ps(c3, _mm_set1_ps(n[4 * j + 3]));
+      columns[j] = _mm_add_ps(_mm_add_ps(_mm_add_ps(x, y), z), w);
+    }
+    for (int j = 0; j < 4; j++) {
+      _mm_storeu_ps(output + 16 * i + 4 * j, columns[j]);
+    }
+  }
+#elif defined(LOVR_NEON)
+  float32x4_t c0 = vld1q_f32(m + 0);
+  float32x4_t c1 = vld1q_f32(m + 4);
+  float32x4_t c2 = vld1q_f32(m + 8);
+  float32x4_t c3 = vld1q_f32(m + 12);
+  for (; i < count; i++) {
+    const float* n = input + 16 * i;
+    float32x4_t columns[4];
+    for (int j = 0; j < 4; j++) {
+      float32x4_t column = vmulq_n_f32(c0, n[4 * j + 0]);
+      column = vmlaq_n_f32(column, c1, n[4 * j + 1]);
+      column = vmlaq_n_f32(column, c2, n[4 * j + 2]);
+      columns[j] = vmlaq_n_f32(column, c3, n[4 * j + 3]);
+    }
+    for (int j = 0; j < 4; j++) {
+      vst1q_f32(output + 16 * i + 4 * j, columns[j]);
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    float n[16];
+    memcpy(n, m, sizeof(n));
+    mat4_multiply(n, (float*) input + 16 * i);
+    memcpy(output + 16 * i, n, sizeof(n));
+  }
+}
+
+// Writes minx, maxx, miny, maxy, minz, maxz, the same layout as Model:getAABB
+void lovrMathGetBoundingBox(const float* points, uint32_t count, float aabb[6]) {
+  if (count == 0) {
+    memset(aabb, 0, 6 * sizeof(float));
+    return;
+  }
+
+  float min[3] = { points[0], points[1], points[2] };
+  float max[3] = { points[0], points[1], points[2] };
+  uint32_t i = 0;
+
+#if defined(LOVR_SSE) || defined(LOVR_NEON)
+  if (count >= 4) {
+    float LOVR_ALIGN(16) lo[3][4], hi[3][4];
+#ifdef LOVR_SSE
+    __m128 x, y, z;
+    deinterleave(points, &x, &y, &z);
+    __m128 minx = x, miny = y, minz = z, maxx = x, maxy = y, maxz = z;
+    for (i = 4; i + 4 <= count; i += 4) {
+      deinterleave(points + 3 * i, &x, &y, &z);
+      minx = _mm_min_ps(minx, x), maxx = _mm_max_ps(maxx, x);
+      miny = _mm_min_ps(miny, y), maxy = _mm_max_ps(maxy, y);
+      minz = _mm_min_ps(minz, z), maxz = _mm_max_ps(maxz, z);
+    }
+    _mm_store_ps(lo[0], minx), _mm_store_ps(lo[1], miny), _mm_store_ps(lo[2], minz);
+    _mm_store_ps(hi[0], maxx), _mm_store_ps(hi[1], maxy), _mm_store_ps(hi[2], maxz);
+#else
+    float32x4x3_t p = vld3q_f32(points);
+    float32x4x3_t minp = p, maxp = p;
+    for (i = 4; i + 4 <= count; i += 4) {
+      p = vld3q_f32(points + 3 * i);
+      for (int j = 0; j < 3; j++) {
+        minp.val[j] = vminq_f32(minp.val[j], p.val[j]);
+        maxp.val[j] = vmaxq_f32(maxp.val[j], p.val[j]);
+      }
+    }
+    for (int j = 0; j < 3; j++) {
+      vst1q_f32(lo[j], minp.val[j]);
+      vst1q_f32(hi[j], maxp.val[j]);
+    }
+#endif
+    for (int j = 0; j < 3; j++) {
+      for (int k = 0; k < 4; k++) {
+        min[j] = MIN(min[j], lo[j][k]);
+        max[j] = MAX(max[j], hi[j][k]);
+      }
+    }
+  }
+#endif
+
+  for (; i < count; i++) {
+    for (int j = 0; j < 3; j++) {
+      min[j] = MIN(min[j], points[3 * i + j]);
+      max[j] = MAX(max[j], points[3 * i + j]);
+    }
+  }
+
+  aabb[0] = min[0], aabb[1] = max[0];
+  aabb[2] = min[1], aabb[3] = max[1];
+  aabb[4] = min[2], aabb[5] = max[2];
+}
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 
 #pragma once
 
@@ -13,3 +14,8 @@ float lovrMathNoise1(float x);
 float lovrMathNoise2(float x, float y);
 float lovrMathNoise3(float x, float y, float z);
 float lovrMathNoise4(float x, float y, float z, float w);
+void lovrMathTransformPoints(float* m, const float* input, float* output, uint32_t count);
+void lovrMathNormalizeVectors(const float* input, float* output, uint32_t count);
+void lovrMathSlerpQuaternions(const float* a, const float* b, float t, float* output, uint32_t count);
+void lovrMathMultiplyMatrices(float* m, const float* input, float* output, uint32_t count);
+void lovrMathGetBoundingBox(const float* points, uint32_t count, float aabb[6]);
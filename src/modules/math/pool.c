@@ -2,57 +2,76 @@
 #include "core/util.h"
 #include <stdlib.h>
 
-static const size_t vectorComponents[] = {
-  [V_VEC2] = 2,
-  [V_VEC3] = 4,
-  [V_VEC4] = 4,
-  [V_QUAT] = 4,
-  [V_MAT4] = 16
+#define SLOT_SIZE (4 * sizeof(float))
+
+static const uint32_t vectorSlots[] = {
+  [V_VEC2] = 1,
+  [V_VEC3] = 1,
+  [V_VEC4] = 1,
+  [V_QUAT] = 1,
+  [V_MAT4] = 4
 };
 
+// Segments are allocated on first use, so threads that never make temporary vectors don't pay for them
 Pool* lovrPoolInit(Pool* pool) {
-  lovrPoolGrow(pool, 1 << 12);
   return pool;
 }
 
 void lovrPoolDestroy(void* ref) {
   Pool* pool = ref;
-  free(pool->data);
+  for (uint32_t i = 0; i < pool->segmentCount; i++) {
+    free(pool->segments[i]);
+  }
 }
 
-void lovrPoolGrow(Pool* pool, size_t count) {
-  lovrAssert(count <= (1 << 16), "Temporary vector space exhausted.  Try using lovr.math.drain to drain the vector pool periodically.");
-  pool->count = count;
-  pool->data = realloc(pool->data, pool->count * sizeof(float));
-  lovrAssert(pool->data, "Out of memory");
+static void grow(Pool* pool) {
+  lovrAssert(pool->segmentCount < POOL_MAX_SEGMENTS, "Temporary vector space exhausted.  Try using lovr.math.drain to drain the vector pool periodically.");
+  float* segment = malloc(POOL_SEGMENT_SLOTS * SLOT_SIZE);
+  lovrAssert(segment, "Out of memory");
+  pool->segments[pool->segmentCount++] = segment;
 }
 
 Vector lovrPoolAllocate(Pool* pool, VectorType type, float** data) {
-  size_t count = vectorComponents[type];
+  uint32_t slots = vectorSlots[type];
+  uint32_t offset = pool->cursor & (POOL_SEGMENT_SLOTS - 1);
+
+  // Vectors don't straddle segments, a matrix that doesn't fit skips the rest of the segment
+  if (offset + slots > POOL_SEGMENT_SLOTS) {
+    pool->cursor += POOL_SEGMENT_SLOTS - offset;
+    offset = 0;
+  }
 
-  if (pool->cursor + count > pool->count) {
-    lovrPoolGrow(pool, pool->count * 2);
+  uint32_t segment = pool->cursor >> POOL_SEGMENT_BITS;
+  if (segment >= pool->segmentCount) {
+    grow(pool);
   }
 
-  Vector v = {
-    .handle = {
-      .type = type,
-      .generation = (uint8_t) pool->generation,
-      .index = (uint16_t) pool->cursor
-    }
-  };
+  Vector v = { .pointer = NULL };
+  v.handle.type = type;
+  v.handle.generation = pool->generation;
+  v.handle.index = pool->cursor;
 
-  *data = pool->data + pool->cursor;
-  pool->cursor += count;
+  *data = pool->segments[segment] + offset * 4;
+  pool->cursor += slots;
   return v;
 }
 
 float* lovrPoolResolve(Pool* pool, Vector vector) {
   lovrAssert(vector.handle.generation == pool->generation, "Attempt to use a vector in a different generation than the one it was created in (vectors can not be saved into variables)");
-  return pool->data + vector.handle.index;
+  uint32_t index = vector.handle.index;
+  return pool->segments[index >> POOL_SEGMENT_BITS] + (index & (POOL_SEGMENT_SLOTS - 1)) * 4;
 }
 
+// Segments are kept around for the next frame, most frames use about as much space as the last one
 void lovrPoolDrain(Pool* pool) {
+  pool->peak = MAX(pool->peak, pool->cursor);
   pool->cursor = 0;
-  pool->generation = (pool->generation + 1) & 0xff;
+  pool->generation = (pool->generation + 1) & 0x1f;
+}
+
+void lovrPoolGetStats(Pool* pool, PoolStats* stats) {
+  stats->used = pool->cursor * SLOT_SIZE;
+  stats->peak = MAX(pool->peak, pool->cursor) * SLOT_SIZE;
+  stats->capacity = pool->segmentCount * POOL_SEGMENT_SLOTS * SLOT_SIZE;
+  stats->segments = pool->segmentCount;
 }
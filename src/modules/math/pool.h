@@ -3,6 +3,12 @@
 
 #pragma once
 
+// Temporary vectors live in fixed size segments of 4-float slots.  Segments never move, and a 24
+// bit slot index keeps handles to 32 bits so they fit in a lightuserdata on every platform.
+#define POOL_SEGMENT_BITS 14
+#define POOL_SEGMENT_SLOTS (1 << POOL_SEGMENT_BITS)
+#define POOL_MAX_SEGMENTS (1 << (24 - POOL_SEGMENT_BITS))
+
 typedef enum {
   V_NONE,
   V_VEC2,
@@ -16,24 +22,31 @@ typedef enum {
 typedef union {
   void* pointer;
   struct {
-    uint8_t type;
-    uint8_t generation;
-    uint16_t index;
-    uint32_t padding;
+    uint32_t type : 3;
+    uint32_t generation : 5;
+    uint32_t index : 24;
   } handle;
 } Vector;
 
+typedef struct {
+  size_t used;
+  size_t peak;
+  size_t capacity;
+  uint32_t segments;
+} PoolStats;
+
 typedef struct Pool {
-  float* data;
-  size_t count;
-  size_t cursor;
-  size_t generation;
+  float* segments[POOL_MAX_SEGMENTS];
+  uint32_t segmentCount;
+  uint32_t cursor;
+  uint32_t peak;
+  uint32_t generation;
 } Pool;
 
 Pool* lovrPoolInit(Pool* pool);
 #define lovrPoolCreate(...) lovrPoolInit(lovrAlloc(Pool))
 void lovrPoolDestroy(void* ref);
-void lovrPoolGrow(Pool* pool, size_t count);
 Vector lovrPoolAllocate(Pool* pool, VectorType type, float** data);
 float* lovrPoolResolve(Pool* pool, Vector vector);
 void lovrPoolDrain(Pool* pool);
+void lovrPoolGetStats(Pool* pool, PoolStats* stats);
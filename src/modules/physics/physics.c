@@ -1,18 +1,136 @@
 #include "physics.h"
+#include "data/modelData.h"
+#include "core/hash.h"
 #include "core/maf.h"
+#include "core/platform.h"
 #include "core/ref.h"
 #include "core/util.h"
 #include <stdlib.h>
 #include <stdbool.h>
-
-static void defaultNearCallback(void* data, dGeomID a, dGeomID b) {
-  lovrWorldCollide((World*) data, dGeomGetData(a), dGeomGetData(b), -1, -1);
+#include <string.h>
+#include <math.h>
+#ifdef LOVR_ENABLE_THREAD
+#include "lib/tinycthread/tinycthread.h"
+#endif
+
+// Batched casts are only split across the workers once each thread gets a decent number of queries
+#define CAST_BATCH_SIZE 64
+
+// Contact generation is only split across threads when each thread gets a decent number of pairs
+#define MIN_PAIRS_PER_THREAD 32
+
+// Quadtree spaces need bounds up front, geoms outside of them still work but are slower
+#define QUADTREE_EXTENT 1024.f
+#define QUADTREE_DEPTH 8
+
+// Snapshots start with a header that identifies them, bump the version when the layout changes
+#define SNAPSHOT_MAGIC 0x53525650
+#define SNAPSHOT_VERSION 1
+
+// Sweeps march along the query until the shape overlaps something, then bisect to refine the hit
+#define SWEEP_STEPS 64
+#define SWEEP_ITERATIONS 12
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t colliderCount;
+  uint32_t seed;
+  double accumulator;
+} SnapshotHeader;
+
+typedef struct {
+  dReal position[3];
+  dReal orientation[4];
+  dReal linearVelocity[3];
+  dReal angularVelocity[3];
+  dReal force[3];
+  dReal torque[3];
+  uint32_t awake;
+} BodyState;
+
+struct CastTarget {
+  Shape* shape;
+  dGeomID id;
+  float aabb[6];
+};
+
+struct ContactPair {
+  Shape* a;
+  Shape* b;
+  int count;
+  dContact contacts[MAX_CONTACTS];
+};
+
+// Contact joints created during an update, and the event they contribute impulse to
+struct ContactJoint {
+  dJointID joint;
+  uint32_t event;
+};
+
+// Collider pairs that were touching after the last update, used to find pairs that stopped touching
+struct ActiveContact {
+  uint64_t key;
+  Collider* a;
+  Collider* b;
+};
+
+// Collider transforms before and after the last fixed step, as a position and a quaternion
+struct ColliderPose {
+  Collider* collider;
+  float previous[7];
+  float current[7];
+  bool changed;
+  bool moved;
+};
+
+typedef void WorkerTask(World* world, uint32_t start, uint32_t end);
+
+#ifdef LOVR_ENABLE_THREAD
+typedef struct {
+  WorkerPool* pool;
+  uint32_t index;
+} WorkerInfo;
+
+// Persistent worker threads for a World.  The thread calling lovrWorldUpdate takes the first slice
+// of each task and waits for the workers to finish theirs.
+struct WorkerPool {
+  World* world;
+  thrd_t threads[MAX_PHYSICS_THREADS];
+  WorkerInfo infos[MAX_PHYSICS_THREADS];
+  uint32_t count;
+  mtx_t lock;
+  cnd_t wake;
+  cnd_t idle;
+  WorkerTask* task;
+  uint32_t taskSize;
+  uint32_t generation;
+  uint32_t busy;
+  bool quit;
+};
+#endif
+
+// The parameters of the cast that is running, shared by all of the slices
+struct CastJob {
+  CastType type;
+  float* size;
+  float* orientation;
+  const float* queries;
+};
+
+static void pairNearCallback(void* data, dGeomID a, dGeomID b) {
+  World* world = data;
+  ContactPair pair = { .a = dGeomGetData(a), .b = dGeomGetData(b) };
+  if (pair.a && pair.b) {
+    arr_push(&world->pairs, pair);
+  }
 }
 
 static void customNearCallback(void* data, dGeomID shapeA, dGeomID shapeB) {
   World* world = data;
   arr_push(&world->overlaps, dGeomGetData(shapeA));
   arr_push(&world->overlaps, dGeomGetData(shapeB));
+  world->stats.pairs++;
 }
 
 static void raycastCallback(void* data, dGeomID a, dGeomID b) {
@@ -31,16 +149,523 @@ static void raycastCallback(void* data, dGeomID a, dGeomID b) {
   }
 }
 
-// XXX slow, but probably fine (tag names are not on any critical path), could switch to hashing if needed
-static uint32_t findTag(World* world, const char* name) {
-  for (uint32_t i = 0; i < MAX_TAGS && world->tags[i]; i++) {
-    if (!strcmp(world->tags[i], name)) {
-      return i;
+// Slab test of a query against an AABB grown by the extent of the cast shape.  Since the cast shape
+// fits in its extent, the entry fraction is a lower bound on where the shape could first touch.
+static bool castBounds(const float aabb[6], const float origin[3], const float delta[3], const float extent[3], float limit, float* t) {
+  float tmin = 0.f;
+  float tmax = limit;
+  for (int i = 0; i < 3; i++) {
+    float lo = aabb[2 * i + 0] - extent[i];
+    float hi = aabb[2 * i + 1] + extent[i];
+    if (fabsf(delta[i]) < 1e-8f) {
+      if (origin[i] < lo || origin[i] > hi) {
+        return false;
+      }
+    } else {
+      float t1 = (lo - origin[i]) / delta[i];
+      float t2 = (hi - origin[i]) / delta[i];
+      tmin = MAX(tmin, MIN(t1, t2));
+      tmax = MIN(tmax, MAX(t1, t2));
+      if (tmin > tmax) {
+        return false;
+      }
+    }
+  }
+  *t = tmin;
+  return true;
+}
+
+static bool sweepOverlaps(dGeomID geom, dGeomID target, const float origin[3], const float delta[3], float t, dContactGeom* contact) {
+  dGeomSetPosition(geom, origin[0] + delta[0] * t, origin[1] + delta[1] * t, origin[2] + delta[2] * t);
+  return dCollide(geom, target, 1, contact, sizeof(dContactGeom)) > 0;
+}
+
+static bool sweep(dGeomID geom, dGeomID target, const float origin[3], const float delta[3], float start, float limit, float step, dContactGeom* contact, float* fraction) {
+  if (sweepOverlaps(geom, target, origin, delta, start, contact)) {
+    *fraction = start;
+    return true;
+  }
+
+  float lo = start;
+  step = MAX(step, (limit - start) / SWEEP_STEPS);
+  while (lo < limit) {
+    float hi = MIN(lo + step, limit);
+    if (sweepOverlaps(geom, target, origin, delta, hi, contact)) {
+      for (int i = 0; i < SWEEP_ITERATIONS; i++) {
+        float mid = (lo + hi) / 2.f;
+        if (!sweepOverlaps(geom, target, origin, delta, mid, contact)) {
+          lo = mid;
+        } else {
+          hi = mid;
+        }
+      }
+      sweepOverlaps(geom, target, origin, delta, hi, contact);
+      *fraction = hi;
+      return true;
+    }
+    lo = hi;
+  }
+
+  return false;
+}
+
+static void castQuery(World* world, CastType type, dGeomID geom, const float extent[3], float thickness, const float* query, CastHit* hit) {
+  float origin[3] = { query[0], query[1], query[2] };
+  float delta[3] = { query[3] - query[0], query[4] - query[1], query[5] - query[2] };
+  float length = sqrtf(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+  float step = length > 0.f ? thickness / length : 1.f;
+
+  hit->shape = NULL;
+  hit->fraction = 1.f;
+
+  if (type == CAST_RAY) {
+    if (length == 0.f) {
+      return;
+    }
+
+    dGeomRaySetLength(geom, length);
+    dGeomRaySet(geom, origin[0], origin[1], origin[2], delta[0], delta[1], delta[2]);
+  }
+
+  for (size_t i = 0; i < world->targets.length; i++) {
+    CastTarget* target = &world->targets.data[i];
+    dContactGeom contact;
+    float t, fraction;
+
+    if (!castBounds(target->aabb, origin, delta, extent, hit->fraction, &t)) {
+      continue;
+    }
+
+    if (type == CAST_RAY) {
+      if (!dCollide(geom, target->id, 1, &contact, sizeof(dContactGeom))) {
+        continue;
+      }
+      fraction = contact.depth / length;
+    } else if (!sweep(geom, target->id, origin, delta, t, hit->fraction, step, &contact, &fraction)) {
+      continue;
+    }
+
+    if (fraction <= hit->fraction) {
+      hit->shape = target->shape;
+      hit->position[0] = contact.pos[0];
+      hit->position[1] = contact.pos[1];
+      hit->position[2] = contact.pos[2];
+      hit->normal[0] = contact.normal[0];
+      hit->normal[1] = contact.normal[1];
+      hit->normal[2] = contact.normal[2];
+      hit->fraction = fraction;
+    }
+  }
+}
+
+// Each slice has its own query geom, the shapes in the World are only read
+static void castTask(World* world, uint32_t start, uint32_t end) {
+  CastJob* job = world->cast;
+  float* size = job->size;
+  float extent[3] = { 0.f, 0.f, 0.f };
+  float thickness = 0.f;
+  dGeomID geom;
+
+  if (start == end) {
+    return;
+  }
+
+  switch (job->type) {
+    case CAST_RAY:
+      geom = dCreateRay(0, 1.f);
+      dGeomRaySetClosestHit(geom, 1);
+      break;
+
+    case CAST_SPHERE:
+      geom = dCreateSphere(0, size[0]);
+      extent[0] = extent[1] = extent[2] = thickness = size[0];
+      break;
+
+    case CAST_BOX: {
+      geom = dCreateBox(0, size[0], size[1], size[2]);
+      float* q = job->orientation;
+      dGeomSetQuaternion(geom, (dReal[4]) { q[3], q[0], q[1], q[2] });
+      for (int i = 0; i < 3; i++) {
+        float axis[3] = { 0.f, 0.f, 0.f };
+        axis[i] = size[i] / 2.f;
+        quat_rotate(q, axis);
+        extent[0] += fabsf(axis[0]);
+        extent[1] += fabsf(axis[1]);
+        extent[2] += fabsf(axis[2]);
+      }
+      thickness = MIN(MIN(size[0], size[1]), size[2]) / 2.f;
+      break;
+    }
+
+    default: return;
+  }
+
+  for (uint32_t i = start; i < end; i++) {
+    castQuery(world, job->type, geom, extent, thickness, job->queries + 6 * i, &world->hits.data[i]);
+  }
+
+  dGeomDestroy(geom);
+}
+
+// Generates contacts without touching the World, so pairs can be processed on any thread.  Returns
+// -1 if the pair is filtered out by its tags and never tested.
+static int generateContacts(World* world, Shape* a, Shape* b, float friction, float restitution, dContact contacts[MAX_CONTACTS]) {
+  Collider* colliderA = a->collider;
+  Collider* colliderB = b->collider;
+  uint32_t i = colliderA->tag;
+  uint32_t j = colliderB->tag;
+
+  if (i != NO_TAG && j != NO_TAG && !((world->masks[i] & (1ull << j)) && (world->masks[j] & (1ull << i)))) {
+    return -1;
+  }
+
+  bool tagged = i != NO_TAG && j != NO_TAG;
+
+  // Colliders that haven't been given a friction don't contribute, and contacts between two of them
+  // have infinite friction
+  if (friction < 0.f) {
+    friction = tagged ? world->frictions[i][j] : -1.f;
+    if (friction < 0.f) {
+      float fa = colliderA->friction;
+      float fb = colliderB->friction;
+      if (fa > 0.f && fb > 0.f) {
+        friction = sqrtf(fa * fb);
+      } else {
+        friction = fa > 0.f ? fa : (fb > 0.f ? fb : dInfinity);
+      }
+    }
+  }
+
+  if (restitution < 0.f) {
+    restitution = tagged ? world->restitutions[i][j] : -1.f;
+    if (restitution < 0.f) {
+      restitution = MAX(colliderA->restitution, colliderB->restitution);
+    }
+  }
+
+  for (int i = 0; i < MAX_CONTACTS; i++) {
+    contacts[i].surface.mode = 0;
+    contacts[i].surface.mu = friction;
+    contacts[i].surface.bounce = restitution;
+
+    if (restitution > 0) {
+      contacts[i].surface.mode |= dContactBounce;
     }
   }
+
+  return dCollide(a->id, b->id, MAX_CONTACTS, &contacts[0].geom, sizeof(dContact));
+}
+
+static uint64_t getContactKey(Collider* a, Collider* b) {
+  Collider* pair[2] = { a < b ? a : b, a < b ? b : a };
+  return hash64(pair, sizeof(pair));
+}
+
+// Map values are the update the pair was last seen in (high bits) and its event index (low bits)
+static uint32_t recordContacts(World* world, Shape* a, Shape* b, dContact* contacts, int count) {
+  Collider* colliderA = a->collider;
+  Collider* colliderB = b->collider;
+  uint64_t key = getContactKey(colliderA, colliderB);
+  uint64_t value = map_get(&world->contactMap, key);
+  uint32_t step = value == MAP_NIL ? 0 : (uint32_t) (value >> 32);
+  uint32_t index;
+
+  // Pairs that touch in several steps of one update only get one event
+  if (value != MAP_NIL && step >= world->firstStep) {
+    index = (uint32_t) value;
+    if (step != world->step) {
+      map_set(&world->contactMap, key, ((uint64_t) world->step << 32) | index);
+    }
+  } else {
+    ContactEvent event = {
+      .type = value != MAP_NIL && step == world->step - 1 ? CONTACT_PERSIST : CONTACT_BEGIN,
+      .a = colliderA,
+      .b = colliderB,
+      .depth = -1.f
+    };
+    index = (uint32_t) world->events.length;
+    arr_push(&world->events, event);
+    map_set(&world->contactMap, key, ((uint64_t) world->step << 32) | index);
+  }
+
+  ContactEvent* event = &world->events.data[index];
+  float sign = event->a == colliderA ? 1.f : -1.f;
+  for (int i = 0; i < count; i++) {
+    dContactGeom* g = &contacts[i].geom;
+    if (g->depth > event->depth) {
+      event->position[0] = g->pos[0];
+      event->position[1] = g->pos[1];
+      event->position[2] = g->pos[2];
+      event->normal[0] = g->normal[0] * sign;
+      event->normal[1] = g->normal[1] * sign;
+      event->normal[2] = g->normal[2] * sign;
+      event->depth = g->depth;
+    }
+  }
+
+  return index;
+}
+
+static void attachContacts(World* world, Shape* a, Shape* b, dContact* contacts, int count) {
+  if (count <= 0) {
+    return;
+  }
+
+  uint32_t event = recordContacts(world, a, b, contacts, count);
+
+  if (!a->sensor && !b->sensor) {
+    for (int i = 0; i < count; i++) {
+      dJointID joint = dJointCreateContact(world->id, world->contactGroup, &contacts[i]);
+      dJointAttach(joint, a->collider->body, b->collider->body);
+      ContactJoint contactJoint = { joint, event };
+      arr_push(&world->contactJoints, contactJoint);
+    }
+  }
+}
+
+static void beginContacts(World* world) {
+  world->step++;
+  arr_clear(&world->contactJoints);
+}
+
+// Feedback is hooked up once all contact joints exist, since the array can move while growing
+static void watchContacts(World* world) {
+  arr_reserve(&world->feedback, world->contactJoints.length);
+  for (size_t i = 0; i < world->contactJoints.length; i++) {
+    dJointSetFeedback(world->contactJoints.data[i].joint, &world->feedback.data[i]);
+  }
+}
+
+static void endContacts(World* world, float dt) {
+  for (size_t i = 0; i < world->contactJoints.length; i++) {
+    dJointFeedback* feedback = &world->feedback.data[i];
+    float force = sqrtf(feedback->f1[0] * feedback->f1[0] + feedback->f1[1] * feedback->f1[1] + feedback->f1[2] * feedback->f1[2]);
+    world->events.data[world->contactJoints.data[i].event].impulse += force * dt;
+  }
+
+  for (size_t i = 0; i < world->activeContacts.length; i++) {
+    ActiveContact* active = &world->activeContacts.data[i];
+    uint64_t value = map_get(&world->contactMap, active->key);
+    if (value == MAP_NIL || (uint32_t) (value >> 32) != world->step) {
+      ContactEvent event = { .type = CONTACT_END, .a = active->a, .b = active->b };
+      arr_push(&world->events, event);
+      map_remove(&world->contactMap, active->key);
+    }
+  }
+
+  arr_clear(&world->activeContacts);
+  for (size_t i = 0; i < world->events.length; i++) {
+    ContactEvent* event = &world->events.data[i];
+    if (event->type != CONTACT_END && event->a && event->b) {
+      uint64_t key = getContactKey(event->a, event->b);
+      uint64_t value = map_get(&world->contactMap, key);
+      if (value != MAP_NIL && (uint32_t) (value >> 32) == world->step) {
+        ActiveContact active = { key, event->a, event->b };
+        arr_push(&world->activeContacts, active);
+      }
+    }
+  }
+}
+
+// Called when a Collider is destroyed so events and contact tracking don't point to it anymore
+static void forgetContacts(World* world, Collider* collider) {
+  for (size_t i = world->activeContacts.length; i-- > 0;) {
+    ActiveContact* active = &world->activeContacts.data[i];
+    if (active->a == collider || active->b == collider) {
+      map_remove(&world->contactMap, active->key);
+      arr_splice(&world->activeContacts, i, 1);
+    }
+  }
+
+  // Pairs from the current update aren't active yet, but they still have an entry in the map
+  for (size_t i = 0; i < world->events.length; i++) {
+    ContactEvent* event = &world->events.data[i];
+    if ((event->a == collider || event->b == collider) && event->a && event->b) {
+      map_remove(&world->contactMap, getContactKey(event->a, event->b));
+    }
+    if (event->a == collider) event->a = NULL;
+    if (event->b == collider) event->b = NULL;
+  }
+}
+
+static void collideTask(World* world, uint32_t start, uint32_t end) {
+  for (uint32_t i = start; i < end; i++) {
+    ContactPair* pair = &world->pairs.data[i];
+    pair->count = generateContacts(world, pair->a, pair->b, -1.f, -1.f, pair->contacts);
+  }
+}
+
+#ifdef LOVR_ENABLE_THREAD
+static void runTask(WorkerPool* pool, uint32_t index) {
+  uint32_t n = pool->count + 1;
+  uint32_t start = (uint32_t) ((uint64_t) pool->taskSize * index / n);
+  uint32_t end = (uint32_t) ((uint64_t) pool->taskSize * (index + 1) / n);
+  pool->task(pool->world, start, end);
+}
+
+static int workerThread(void* arg) {
+  WorkerInfo* info = arg;
+  WorkerPool* pool = info->pool;
+  uint32_t generation = 0;
+  dAllocateODEDataForThread(dAllocateMaskAll);
+
+  mtx_lock(&pool->lock);
+  for (;;) {
+    while (!pool->quit && pool->generation == generation) {
+      cnd_wait(&pool->wake, &pool->lock);
+    }
+
+    if (pool->quit) {
+      break;
+    }
+
+    generation = pool->generation;
+    mtx_unlock(&pool->lock);
+    runTask(pool, info->index);
+    mtx_lock(&pool->lock);
+
+    if (--pool->busy == 0) {
+      cnd_signal(&pool->idle);
+    }
+  }
+  mtx_unlock(&pool->lock);
+  dCleanupODEAllDataForThread();
+  return 0;
+}
+
+static void destroyWorkers(World* world) {
+  WorkerPool* pool = world->workers;
+  if (!pool) return;
+  mtx_lock(&pool->lock);
+  pool->quit = true;
+  cnd_broadcast(&pool->wake);
+  mtx_unlock(&pool->lock);
+  for (uint32_t i = 0; i < pool->count; i++) {
+    thrd_join(pool->threads[i], NULL);
+  }
+  mtx_destroy(&pool->lock);
+  cnd_destroy(&pool->wake);
+  cnd_destroy(&pool->idle);
+  free(pool);
+  world->workers = NULL;
+}
+
+static void createWorkers(World* world, uint32_t count) {
+  WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+  lovrAssert(pool, "Out of memory");
+  pool->world = world;
+  mtx_init(&pool->lock, mtx_plain);
+  cnd_init(&pool->wake);
+  cnd_init(&pool->idle);
+  world->workers = pool;
+
+  // Slice 0 belongs to the calling thread
+  for (uint32_t i = 0; i < count; i++) {
+    pool->infos[i] = (WorkerInfo) { .pool = pool, .index = i + 1 };
+    if (thrd_create(&pool->threads[i], workerThread, &pool->infos[i]) != thrd_success) {
+      break;
+    }
+    pool->count++;
+  }
+}
+#endif
+
+// Runs a task over [0, size) on the worker pool, in equal slices, or inline if there is no pool
+static void dispatch(World* world, WorkerTask* task, uint32_t size, uint32_t minSlice) {
+#ifdef LOVR_ENABLE_THREAD
+  WorkerPool* pool = world->workers;
+  if (pool && size >= minSlice * (pool->count + 1)) {
+    mtx_lock(&pool->lock);
+    pool->task = task;
+    pool->taskSize = size;
+    pool->busy = pool->count;
+    pool->generation++;
+    cnd_broadcast(&pool->wake);
+    mtx_unlock(&pool->lock);
+
+    runTask(pool, 0);
+
+    mtx_lock(&pool->lock);
+    while (pool->busy > 0) {
+      cnd_wait(&pool->idle, &pool->lock);
+    }
+    mtx_unlock(&pool->lock);
+    return;
+  }
+#endif
+  task(world, 0, size);
+}
+
+static dSpaceID createSpace(BroadphaseType type) {
+  switch (type) {
+    case BROADPHASE_HASH: {
+      dSpaceID space = dHashSpaceCreate(0);
+      dHashSpaceSetLevels(space, -4, 8);
+      return space;
+    }
+    case BROADPHASE_SAP: return dSweepAndPruneSpaceCreate(0, dSAP_AXES_XZY);
+    case BROADPHASE_QUADTREE: {
+      dVector3 center = { 0.f, 0.f, 0.f };
+      dVector3 extents = { QUADTREE_EXTENT, QUADTREE_EXTENT, QUADTREE_EXTENT };
+      return dQuadTreeSpaceCreate(0, center, extents, QUADTREE_DEPTH);
+    }
+    case BROADPHASE_SIMPLE: return dSimpleSpaceCreate(0);
+    default: lovrThrow("Unreachable");
+  }
+}
+
+// Kinematic colliders live in a separate space that is only ever tested against the main space,
+// since pairs of kinematic colliders never need contacts
+static dSpaceID getColliderSpace(Collider* collider) {
+  return dBodyIsKinematic(collider->body) ? collider->world->staticSpace : collider->world->space;
+}
+
+static void collideSpaces(World* world, dNearCallback* callback) {
+  dSpaceCollide(world->space, world, callback);
+  dSpaceCollide2((dGeomID) world->space, (dGeomID) world->staticSpace, world, callback);
+}
+
+// Tag names are hashed, the name is still compared in case of a collision
+static uint32_t findTag(World* world, const char* name) {
+  uint64_t index = map_get(&world->tagMap, hash64(name, strlen(name)));
+  if (index != MAP_NIL && !strcmp(world->tags[index], name)) {
+    return (uint32_t) index;
+  }
   return NO_TAG;
 }
 
+// Tags are pushed down into ODE's category and collide bits so the broadphase skips filtered pairs.
+// ODE only tests that one of the geoms accepts the other, which matches because masks are kept
+// symmetric.  The bits are an unsigned long, which is 32 bits on some platforms, so tags that
+// don't fit collide with everything there and are only filtered when contacts are generated.
+#define ODE_TAG_BITS (sizeof(unsigned long) * 8)
+
+static void updateGeomBits(Collider* collider, dGeomID geom) {
+  uint32_t tag = collider->tag;
+  if (tag == NO_TAG || tag >= ODE_TAG_BITS) {
+    dGeomSetCategoryBits(geom, ~0ul);
+    dGeomSetCollideBits(geom, ~0ul);
+  } else {
+    dGeomSetCategoryBits(geom, 1ul << tag);
+    dGeomSetCollideBits(geom, (unsigned long) collider->world->masks[tag]);
+  }
+}
+
+static void updateColliderBits(Collider* collider) {
+  for (dGeomID geom = dBodyGetFirstGeom(collider->body); geom; geom = dBodyGetNextGeom(geom)) {
+    updateGeomBits(collider, geom);
+  }
+}
+
+static void updateTagBits(World* world, uint32_t i, uint32_t j) {
+  for (size_t k = 0; k < world->poses.length; k++) {
+    Collider* collider = world->poses.data[k].collider;
+    if (collider->tag == i || collider->tag == j) {
+      updateColliderBits(collider);
+    }
+  }
+}
+
 static bool initialized = false;
 
 bool lovrPhysicsInit() {
@@ -55,20 +680,44 @@ void lovrPhysicsDestroy() {
   initialized = false;
 }
 
-World* lovrWorldInit(World* world, float xg, float yg, float zg, bool allowSleep, const char** tags, uint32_t tagCount) {
+World* lovrWorldInit(World* world, float xg, float yg, float zg, bool allowSleep, const char** tags, uint32_t tagCount, BroadphaseType broadphase) {
+  lovrAssert(tagCount <= MAX_TAGS, "Worlds can only have %d tags", MAX_TAGS);
   world->id = dWorldCreate();
-  world->space = dHashSpaceCreate(0);
-  dHashSpaceSetLevels(world->space, -4, 8);
+  world->space = createSpace(broadphase);
+  world->staticSpace = createSpace(BROADPHASE_HASH);
+  world->broadphase = broadphase;
   world->contactGroup = dJointGroupCreate(0);
   arr_init(&world->overlaps);
+  arr_init(&world->targets);
+  arr_init(&world->hits);
+  arr_init(&world->pairs);
+  arr_init(&world->events);
+  arr_init(&world->contactJoints);
+  arr_init(&world->feedback);
+  arr_init(&world->activeContacts);
+  arr_init(&world->poses);
+  arr_init(&world->colliders);
+  arr_init(&world->islands);
+  map_init(&world->contactMap, 0);
+  map_init(&world->tagMap, 0);
+  world->threadCount = 1;
+  world->maxSteps = 1;
+  world->alpha = 1.f;
   lovrWorldSetGravity(world, xg, yg, zg);
   lovrWorldSetSleepingAllowed(world, allowSleep);
   for (uint32_t i = 0; i < tagCount; i++) {
     size_t size = strlen(tags[i]) + 1;
     world->tags[i] = malloc(size);
     memcpy(world->tags[i], tags[i], size);
+    map_set(&world->tagMap, hash64(tags[i], size - 1), i);
   }
   memset(world->masks, 0xff, sizeof(world->masks));
+  for (uint32_t i = 0; i < MAX_TAGS; i++) {
+    for (uint32_t j = 0; j < MAX_TAGS; j++) {
+      world->frictions[i][j] = -1.f;
+      world->restitutions[i][j] = -1.f;
+    }
+  }
   return world;
 }
 
@@ -76,12 +725,28 @@ void lovrWorldDestroy(void* ref) {
   World* world = ref;
   lovrWorldDestroyData(world);
   arr_free(&world->overlaps);
+  arr_free(&world->targets);
+  arr_free(&world->hits);
+  arr_free(&world->pairs);
+  arr_free(&world->events);
+  arr_free(&world->contactJoints);
+  arr_free(&world->feedback);
+  arr_free(&world->activeContacts);
+  arr_free(&world->poses);
+  arr_free(&world->colliders);
+  arr_free(&world->islands);
+  map_free(&world->contactMap);
+  map_free(&world->tagMap);
   for (uint32_t i = 0; i < MAX_TAGS && world->tags[i]; i++) {
     free(world->tags[i]);
   }
 }
 
 void lovrWorldDestroyData(World* world) {
+  if (world->id) {
+    lovrWorldSetThreadCount(world, 1);
+  }
+
   while (world->head) {
     Collider* next = world->head->next;
     lovrColliderDestroyData(world->head);
@@ -98,86 +763,386 @@ void lovrWorldDestroyData(World* world) {
     world->space = NULL;
   }
 
+  if (world->staticSpace) {
+    dSpaceDestroy(world->staticSpace);
+    world->staticSpace = NULL;
+  }
+
   if (world->id) {
     dWorldDestroy(world->id);
     world->id = NULL;
   }
 }
 
-void lovrWorldUpdate(World* world, float dt, CollisionResolver resolver, void* userdata) {
+BroadphaseType lovrWorldGetBroadphase(World* world) {
+  return world->broadphase;
+}
+
+static void readPose(Collider* collider, float pose[7]) {
+  const dReal* position = dBodyGetPosition(collider->body);
+  const dReal* q = dBodyGetQuaternion(collider->body);
+  pose[0] = position[0];
+  pose[1] = position[1];
+  pose[2] = position[2];
+  pose[3] = q[1];
+  pose[4] = q[2];
+  pose[5] = q[3];
+  pose[6] = q[0];
+}
+
+// Teleporting a Collider shouldn't interpolate from where it used to be
+static void syncPose(Collider* collider) {
+  ColliderPose* pose = &collider->world->poses.data[collider->pose];
+  readPose(collider, pose->current);
+  memcpy(pose->previous, pose->current, sizeof(pose->current));
+  pose->moved = true;
+}
+
+// A Collider changed during a step if it was awake or it was moved since the previous step
+static void updateChanges(World* world) {
+  for (size_t i = 0; i < world->poses.length; i++) {
+    ColliderPose* pose = &world->poses.data[i];
+    pose->changed = pose->moved || dBodyIsEnabled(pose->collider->body);
+    pose->moved = false;
+  }
+}
+
+static uint32_t findIsland(uint32_t* parents, uint32_t i) {
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+static bool isSimulated(dBodyID body) {
+  return dBodyIsEnabled(body) && !dBodyIsKinematic(body);
+}
+
+// Awake Colliders connected by joints (contacts included) are solved together, as an island
+static void countIslands(World* world) {
+  uint32_t count = (uint32_t) world->poses.length;
+  arr_reserve(&world->islands, count);
+  uint32_t* parents = world->islands.data;
+
+  for (uint32_t i = 0; i < count; i++) {
+    parents[i] = i;
+  }
+
+  world->stats.awake = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    dBodyID body = world->poses.data[i].collider->body;
+    if (!isSimulated(body)) {
+      continue;
+    }
+
+    world->stats.awake++;
+    int jointCount = dBodyGetNumJoints(body);
+    for (int j = 0; j < jointCount; j++) {
+      dJointID joint = dBodyGetJoint(body, j);
+      for (int k = 0; k < 2; k++) {
+        dBodyID other = dJointGetBody(joint, k);
+        if (other && other != body && isSimulated(other)) {
+          Collider* collider = dBodyGetData(other);
+          uint32_t a = findIsland(parents, i);
+          uint32_t b = findIsland(parents, collider->pose);
+          parents[a] = b;
+        }
+      }
+    }
+  }
+
+  world->stats.islands = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (isSimulated(world->poses.data[i].collider->body) && findIsland(parents, i) == i) {
+      world->stats.islands++;
+    }
+  }
+}
+
+static void stepWorld(World* world, float dt, CollisionResolver resolver, void* userdata) {
+  beginContacts(world);
+  double time = lovrPlatformGetTime();
+
   if (resolver) {
     resolver(world, userdata);
+    double now = lovrPlatformGetTime();
+    world->stats.narrowphaseTime += now - time;
+    time = now;
   } else {
-    dSpaceCollide(world->space, world, defaultNearCallback);
+    // Pairs are collected first and their joints are created in order afterwards, only contact
+    // generation runs in parallel, so the results match no matter how many threads there are
+    arr_clear(&world->pairs);
+    collideSpaces(world, pairNearCallback);
+    double now = lovrPlatformGetTime();
+    world->stats.broadphaseTime += now - time;
+    world->stats.pairs += (uint32_t) world->pairs.length;
+    time = now;
+
+    dispatch(world, collideTask, (uint32_t) world->pairs.length, MIN_PAIRS_PER_THREAD);
+    now = lovrPlatformGetTime();
+    world->stats.narrowphaseTime += now - time;
+    time = now;
+
+    for (size_t i = 0; i < world->pairs.length; i++) {
+      ContactPair* pair = &world->pairs.data[i];
+      attachContacts(world, pair->a, pair->b, pair->contacts, pair->count);
+      world->stats.tests += pair->count >= 0;
+    }
   }
 
+  watchContacts(world);
+  world->stats.contacts += (uint32_t) world->contactJoints.length;
+  double now = lovrPlatformGetTime();
+  world->stats.contactTime += now - time;
+  time = now;
+
   if (dt > 0) {
     dWorldQuickStep(world->id, dt);
+    world->stats.iterations += dWorldGetQuickStepNumIterations(world->id);
+  }
+
+  world->stats.solverTime += lovrPlatformGetTime() - time;
+  world->stats.steps++;
+
+  // Islands are only counted for Worlds that have had their stats queried, since it's a full pass
+  // over the bodies and joints that the solver doesn't need
+  if (world->trackIslands) {
+    countIslands(world);
   }
 
+  endContacts(world, dt);
   dJointGroupEmpty(world->contactGroup);
 }
 
-void lovrWorldComputeOverlaps(World* world) {
-  arr_clear(&world->overlaps);
-  dSpaceCollide(world->space, world, customNearCallback);
+// With a step size, the World steps at a fixed rate and Collider poses are interpolated between
+// the last two steps.  Otherwise, dt is passed straight to the solver.
+void lovrWorldUpdate(World* world, float dt, CollisionResolver resolver, void* userdata) {
+  memset(&world->stats, 0, sizeof(world->stats));
+  arr_clear(&world->events);
+  world->firstStep = world->step + 1;
+
+  if (world->stepSize <= 0.f) {
+    stepWorld(world, dt, resolver, userdata);
+    updateChanges(world);
+    return;
+  }
+
+  uint32_t steps = 0;
+  world->accumulator += dt;
+  while (world->accumulator >= world->stepSize && steps < world->maxSteps) {
+    for (size_t i = 0; i < world->poses.length; i++) {
+      ColliderPose* pose = &world->poses.data[i];
+      memcpy(pose->previous, pose->current, sizeof(pose->current));
+    }
+
+    stepWorld(world, world->stepSize, resolver, userdata);
+
+    for (size_t i = 0; i < world->poses.length; i++) {
+      readPose(world->poses.data[i].collider, world->poses.data[i].current);
+    }
+
+    updateChanges(world);
+
+    world->accumulator -= world->stepSize;
+    steps++;
+  }
+
+  // Drop whatever the step limit couldn't catch up on, instead of falling further behind
+  if (world->accumulator >= world->stepSize) {
+    world->accumulator = fmod(world->accumulator, world->stepSize);
+  }
+
+  world->alpha = (float) (world->accumulator / world->stepSize);
 }
 
-int lovrWorldGetNextOverlap(World* world, Shape** a, Shape** b) {
-  if (world->overlaps.length == 0) {
-    *a = *b = NULL;
-    return 0;
+void lovrWorldGetStepSize(World* world, float* stepSize, uint32_t* maxSteps) {
+  *stepSize = world->stepSize;
+  *maxSteps = world->maxSteps;
+}
+
+void lovrWorldSetStepSize(World* world, float stepSize, uint32_t maxSteps) {
+  world->stepSize = MAX(stepSize, 0.f);
+  world->maxSteps = MAX(maxSteps, 1);
+  world->accumulator = 0.;
+  world->alpha = 1.f;
+  for (size_t i = 0; i < world->poses.length; i++) {
+    syncPose(world->poses.data[i].collider);
   }
+}
 
-  *a = arr_pop(&world->overlaps);
-  *b = arr_pop(&world->overlaps);
-  return 1;
+float lovrWorldGetInterpolation(World* world) {
+  return world->stepSize > 0.f ? world->alpha : 1.f;
 }
 
-int lovrWorldCollide(World* world, Shape* a, Shape* b, float friction, float restitution) {
-  if (!a || !b) {
-    return false;
+// Colliders in the same order as lovrWorldGetPoses
+Collider** lovrWorldGetColliders(World* world, size_t* count) {
+  arr_clear(&world->colliders);
+  for (size_t i = 0; i < world->poses.length; i++) {
+    arr_push(&world->colliders, world->poses.data[i].collider);
   }
+  *count = world->colliders.length;
+  return world->colliders.data;
+}
+
+// Writes (interpolated) poses of up to capacity Colliders, as a position and quaternion (7 floats)
+// or as a matrix (16 floats).  Returns the total number of Colliders in the World.
+uint32_t lovrWorldGetPoses(World* world, float* data, uint32_t capacity, bool matrices, bool* changed) {
+  uint32_t count = MIN(capacity, (uint32_t) world->poses.length);
+  for (uint32_t i = 0; i < count; i++) {
+    ColliderPose* pose = &world->poses.data[i];
+    float position[3], orientation[4];
+    lovrColliderGetPose(pose->collider, position, orientation);
+
+    if (matrices) {
+      float* m = data + 16 * i;
+      mat4_identity(m);
+      mat4_translate(m, position[0], position[1], position[2]);
+      mat4_rotateQuat(m, orientation);
+    } else {
+      float* p = data + 7 * i;
+      vec3_init(p, position);
+      quat_init(p + 3, orientation);
+    }
 
-  Collider* colliderA = a->collider;
-  Collider* colliderB = b->collider;
-  uint32_t i = colliderA->tag;
-  uint32_t j = colliderB->tag;
+    if (changed) {
+      changed[i] = pose->changed;
+    }
+  }
+  return (uint32_t) world->poses.length;
+}
+
+static void readBodyState(Collider* collider, BodyState* state) {
+  memset(state, 0, sizeof(*state));
+  memcpy(state->position, dBodyGetPosition(collider->body), sizeof(state->position));
+  memcpy(state->orientation, dBodyGetQuaternion(collider->body), sizeof(state->orientation));
+  memcpy(state->linearVelocity, dBodyGetLinearVel(collider->body), sizeof(state->linearVelocity));
+  memcpy(state->angularVelocity, dBodyGetAngularVel(collider->body), sizeof(state->angularVelocity));
+  memcpy(state->force, dBodyGetForce(collider->body), sizeof(state->force));
+  memcpy(state->torque, dBodyGetTorque(collider->body), sizeof(state->torque));
+  state->awake = dBodyIsEnabled(collider->body);
+}
+
+// Snapshots only hold the dynamic state of the Colliders, in the same order as
+// lovrWorldGetColliders.  The World has to have the same Colliders, shapes, and joints when it's
+// restored.  The data is allocated with malloc and belongs to the caller.
+void* lovrWorldSnapshot(World* world, size_t* size) {
+  uint32_t count = (uint32_t) world->poses.length;
+  *size = sizeof(SnapshotHeader) + count * sizeof(BodyState);
+  char* data = malloc(*size);
+  lovrAssert(data, "Out of memory");
+
+  SnapshotHeader* header = (SnapshotHeader*) data;
+  header->magic = SNAPSHOT_MAGIC;
+  header->version = SNAPSHOT_VERSION;
+  header->colliderCount = count;
+  header->seed = (uint32_t) dRandGetSeed();
+  header->accumulator = world->accumulator;
+
+  BodyState* states = (BodyState*) (data + sizeof(SnapshotHeader));
+  for (uint32_t i = 0; i < count; i++) {
+    readBodyState(world->poses.data[i].collider, &states[i]);
+  }
 
-  if (i != NO_TAG && j != NO_TAG && !((world->masks[i] & (1 << j)) && (world->masks[j] & (1 << i)))) {
-    return false;
+  return data;
+}
+
+// The solver's random seed is global in ODE, it's restored too since it decides the order that
+// constraints are solved in.  Sleeping bodies restart their idle timers.
+void lovrWorldRestore(World* world, const void* data, size_t size) {
+  const SnapshotHeader* header = data;
+  lovrAssert(size >= sizeof(SnapshotHeader) && header->magic == SNAPSHOT_MAGIC, "Invalid World snapshot");
+  lovrAssert(header->version == SNAPSHOT_VERSION, "World snapshot version %d is not supported", header->version);
+  lovrAssert(header->colliderCount == world->poses.length, "World snapshot has %d colliders, but the World has %d", header->colliderCount, (uint32_t) world->poses.length);
+  lovrAssert(size >= sizeof(SnapshotHeader) + header->colliderCount * sizeof(BodyState), "World snapshot is truncated");
+
+  const BodyState* states = (const BodyState*) ((const char*) data + sizeof(SnapshotHeader));
+  for (uint32_t i = 0; i < header->colliderCount; i++) {
+    const BodyState* state = &states[i];
+    Collider* collider = world->poses.data[i].collider;
+    dBodySetPosition(collider->body, state->position[0], state->position[1], state->position[2]);
+    dBodySetQuaternion(collider->body, state->orientation);
+    dBodySetLinearVel(collider->body, state->linearVelocity[0], state->linearVelocity[1], state->linearVelocity[2]);
+    dBodySetAngularVel(collider->body, state->angularVelocity[0], state->angularVelocity[1], state->angularVelocity[2]);
+    dBodySetForce(collider->body, state->force[0], state->force[1], state->force[2]);
+    dBodySetTorque(collider->body, state->torque[0], state->torque[1], state->torque[2]);
+    if (state->awake) {
+      dBodyEnable(collider->body);
+    } else {
+      dBodyDisable(collider->body);
+    }
+    syncPose(collider);
   }
 
-  if (friction < 0.f) {
-    friction = sqrtf(colliderA->friction * colliderB->friction);
+  world->accumulator = header->accumulator;
+  world->alpha = world->stepSize > 0.f ? (float) (world->accumulator / world->stepSize) : 1.f;
+  dRandSetSeed(header->seed);
+}
+
+// Hash of every Collider's state, two Worlds that hash the same are bit for bit identical
+uint64_t lovrWorldGetChecksum(World* world) {
+  uint64_t hash = hash64(&world->accumulator, sizeof(world->accumulator));
+  for (size_t i = 0; i < world->poses.length; i++) {
+    BodyState state;
+    readBodyState(world->poses.data[i].collider, &state);
+    hash = (hash ^ hash64(&state, sizeof(state))) * 0x100000001b3;
   }
+  return hash;
+}
 
-  if (restitution < 0.f) {
-    restitution = MAX(colliderA->restitution, colliderB->restitution);
+void lovrWorldGetStats(World* world, WorldStats* stats) {
+  world->trackIslands = true;
+  *stats = world->stats;
+}
+
+// Runs the same steps twice from the current state and compares the results.  The World is left
+// where the second run ended.
+bool lovrWorldCheckDeterminism(World* world, float dt, uint32_t steps, uint64_t* checksum) {
+  size_t size;
+  void* snapshot = lovrWorldSnapshot(world, &size);
+
+  for (uint32_t i = 0; i < steps; i++) {
+    lovrWorldUpdate(world, dt, NULL, NULL);
   }
 
-  dContact contacts[MAX_CONTACTS];
-  for (int i = 0; i < MAX_CONTACTS; i++) {
-    contacts[i].surface.mode = 0;
-    contacts[i].surface.mu = friction;
-    contacts[i].surface.bounce = restitution;
-    contacts[i].surface.mu = dInfinity;
+  uint64_t expected = lovrWorldGetChecksum(world);
+  lovrWorldRestore(world, snapshot, size);
+  free(snapshot);
 
-    if (restitution > 0) {
-      contacts[i].surface.mode |= dContactBounce;
-    }
+  for (uint32_t i = 0; i < steps; i++) {
+    lovrWorldUpdate(world, dt, NULL, NULL);
   }
 
-  int contactCount = dCollide(a->id, b->id, MAX_CONTACTS, &contacts[0].geom, sizeof(dContact));
+  *checksum = lovrWorldGetChecksum(world);
+  return *checksum == expected;
+}
 
-  if (!a->sensor && !b->sensor) {
-    for (int i = 0; i < contactCount; i++) {
-      dJointID joint = dJointCreateContact(world->id, world->contactGroup, &contacts[i]);
-      dJointAttach(joint, colliderA->body, colliderB->body);
-    }
+void lovrWorldComputeOverlaps(World* world) {
+  arr_clear(&world->overlaps);
+  collideSpaces(world, customNearCallback);
+}
+
+int lovrWorldGetNextOverlap(World* world, Shape** a, Shape** b) {
+  if (world->overlaps.length == 0) {
+    *a = *b = NULL;
+    return 0;
+  }
+
+  *a = arr_pop(&world->overlaps);
+  *b = arr_pop(&world->overlaps);
+  return 1;
+}
+
+int lovrWorldCollide(World* world, Shape* a, Shape* b, float friction, float restitution) {
+  if (!a || !b) {
+    return false;
   }
 
-  return contactCount;
+  dContact contacts[MAX_CONTACTS];
+  int contactCount = generateContacts(world, a, b, friction, restitution, contacts);
+  attachContacts(world, a, b, contacts, contactCount);
+  world->stats.tests += contactCount >= 0;
+  return MAX(contactCount, 0);
 }
 
 void lovrWorldGetGravity(World* world, float* x, float* y, float* z) {
@@ -229,9 +1194,123 @@ void lovrWorldRaycast(World* world, float x1, float y1, float z1, float x2, floa
   dGeomID ray = dCreateRay(world->space, length);
   dGeomRaySet(ray, x1, y1, z1, dx, dy, dz);
   dSpaceCollide2(ray, (dGeomID) world->space, &data, raycastCallback);
+  dSpaceCollide2(ray, (dGeomID) world->staticSpace, &data, raycastCallback);
   dGeomDestroy(ray);
 }
 
+static void snapshotSpace(World* world, dSpaceID space, uint64_t tagMask) {
+  dSpaceClean(space);
+  int geomCount = dSpaceGetNumGeoms(space);
+  for (int i = 0; i < geomCount; i++) {
+    dGeomID id = dSpaceGetGeom(space, i);
+    Shape* shape = dGeomGetData(id);
+
+    if (!shape || !dGeomIsEnabled(id)) {
+      continue;
+    }
+
+    uint32_t tag = shape->collider ? shape->collider->tag : NO_TAG;
+    if (tagMask != ~0ull && (tag == NO_TAG || !(tagMask & (1ull << tag)))) {
+      continue;
+    }
+
+    CastTarget target;
+    dReal aabb[6];
+    dGeomGetAABB(id, aabb);
+    target.shape = shape;
+    target.id = id;
+    for (int j = 0; j < 6; j++) {
+      target.aabb[j] = aabb[j];
+    }
+    arr_push(&world->targets, target);
+  }
+}
+
+uint32_t lovrWorldGetThreadCount(World* world) {
+  return world->threadCount;
+}
+
+// Worker threads handle contact generation, and ODE's own thread pool steps islands in parallel
+void lovrWorldSetThreadCount(World* world, uint32_t count) {
+#ifdef LOVR_ENABLE_THREAD
+  count = CLAMP(count, 1, MAX_PHYSICS_THREADS);
+  if (count == world->threadCount) {
+    return;
+  }
+
+  destroyWorkers(world);
+
+  if (world->threading) {
+    dWorldSetStepThreadingImplementation(world->id, NULL, NULL);
+    dThreadingImplementationShutdownProcessing(world->threading);
+    dThreadingThreadPoolWaitIdleState(world->threadPool);
+    dThreadingFreeThreadPool(world->threadPool);
+    dThreadingFreeImplementation(world->threading);
+    world->threading = NULL;
+    world->threadPool = NULL;
+  }
+
+  if (count > 1) {
+    createWorkers(world, count - 1);
+
+    // This is NULL if ODE was built without its threading implementation
+    world->threading = dThreadingAllocateMultiThreadedImplementation();
+    if (world->threading) {
+      world->threadPool = dThreadingAllocateThreadPool(count - 1, 0, dAllocateFlagBasicData, NULL);
+      if (world->threadPool) {
+        dThreadingThreadPoolServeMultiThreadedImplementation(world->threadPool, world->threading);
+        dWorldSetStepThreadingImplementation(world->id, dThreadingImplementationGetFunctions(world->threading), world->threading);
+        dWorldSetStepIslandsProcessingMaxThreadCount(world->id, count);
+      } else {
+        dThreadingFreeImplementation(world->threading);
+        world->threading = NULL;
+      }
+    }
+  }
+
+  world->threadCount = count;
+#endif
+}
+
+// Queries are packed as 6 floats (start and end points).  The space is cleaned up front so all of
+// the AABBs and transforms are current, and then it is treated as read-only while the jobs run.
+uint32_t lovrWorldCast(World* world, CastType type, float size[3], float orientation[4], uint64_t tagMask, const float* queries, uint32_t count, CastHit** hits) {
+  arr_clear(&world->hits);
+  arr_reserve(&world->hits, count);
+  world->hits.length = count;
+  *hits = world->hits.data;
+
+  if (count == 0) {
+    return 0;
+  }
+
+  arr_clear(&world->targets);
+  snapshotSpace(world, world->space, tagMask);
+  snapshotSpace(world, world->staticSpace, tagMask);
+
+  CastJob job = {
+    .type = type,
+    .size = size,
+    .orientation = orientation,
+    .queries = queries
+  };
+
+  world->cast = &job;
+  dispatch(world, castTask, count, CAST_BATCH_SIZE);
+  world->cast = NULL;
+
+  uint32_t hitCount = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    hitCount += world->hits.data[i].shape != NULL;
+  }
+
+  return hitCount;
+}
+
+uint32_t lovrWorldFindTag(World* world, const char* name) {
+  return findTag(world, name);
+}
+
 const char* lovrWorldGetTagName(World* world, uint32_t tag) {
   return (tag == NO_TAG) ? NULL : world->tags[tag];
 }
@@ -243,8 +1322,9 @@ int lovrWorldDisableCollisionBetween(World* world, const char* tag1, const char*
     return NO_TAG;
   }
 
-  world->masks[i] &= ~(1 << j);
-  world->masks[j] &= ~(1 << i);
+  world->masks[i] &= ~(1ull << j);
+  world->masks[j] &= ~(1ull << i);
+  updateTagBits(world, i, j);
   return 0;
 }
 
@@ -255,8 +1335,9 @@ int lovrWorldEnableCollisionBetween(World* world, const char* tag1, const char*
     return NO_TAG;
   }
 
-  world->masks[i] |= (1 << j);
-  world->masks[j] |= (1 << i);
+  world->masks[i] |= (1ull << j);
+  world->masks[j] |= (1ull << i);
+  updateTagBits(world, i, j);
   return 0;
 }
 
@@ -267,7 +1348,37 @@ int lovrWorldIsCollisionEnabledBetween(World* world, const char* tag1, const cha
     return NO_TAG;
   }
 
-  return (world->masks[i] & (1 << j)) && (world->masks[j] & (1 << i));
+  return (world->masks[i] & (1ull << j)) && (world->masks[j] & (1ull << i));
+}
+
+// Overrides the friction and restitution of contacts between two tags, negative values remove it
+bool lovrWorldGetContactProperties(World* world, const char* tag1, const char* tag2, float* friction, float* restitution) {
+  uint32_t i = findTag(world, tag1);
+  uint32_t j = findTag(world, tag2);
+  if (i == NO_TAG || j == NO_TAG) {
+    return false;
+  }
+
+  *friction = world->frictions[i][j];
+  *restitution = world->restitutions[i][j];
+  return true;
+}
+
+bool lovrWorldSetContactProperties(World* world, const char* tag1, const char* tag2, float friction, float restitution) {
+  uint32_t i = findTag(world, tag1);
+  uint32_t j = findTag(world, tag2);
+  if (i == NO_TAG || j == NO_TAG) {
+    return false;
+  }
+
+  world->frictions[i][j] = world->frictions[j][i] = friction;
+  world->restitutions[i][j] = world->restitutions[j][i] = restitution;
+  return true;
+}
+
+ContactEvent* lovrWorldGetContactEvents(World* world, size_t* count) {
+  *count = world->events.length;
+  return world->events.data;
 }
 
 Collider* lovrColliderInit(Collider* collider, World* world, float x, float y, float z) {
@@ -280,6 +1391,10 @@ Collider* lovrColliderInit(Collider* collider, World* world, float x, float y, f
   arr_init(&collider->shapes);
   arr_init(&collider->joints);
 
+  ColliderPose pose = { .collider = collider, .changed = true };
+  collider->pose = (uint32_t) world->poses.length;
+  arr_push(&world->poses, pose);
+
   lovrColliderSetPosition(collider, x, y, z);
 
   // Adjust the world's collider list
@@ -320,6 +1435,14 @@ void lovrColliderDestroyData(Collider* collider) {
     lovrRelease(Joint, joints[i]);
   }
 
+  forgetContacts(collider->world, collider);
+
+  // Swap the last pose into this Collider's slot
+  World* world = collider->world;
+  ColliderPose* last = &world->poses.data[world->poses.length - 1];
+  last->collider->pose = collider->pose;
+  world->poses.data[collider->pose] = *last;
+  world->poses.length--;
   dBodyDestroy(collider->body);
   collider->body = NULL;
 
@@ -345,14 +1468,16 @@ void lovrColliderAddShape(Collider* collider, Shape* shape) {
 
   shape->collider = collider;
   dGeomSetBody(shape->id, collider->body);
-  dSpaceID newSpace = collider->world->space;
-  dSpaceAdd(newSpace, shape->id);
+  updateGeomBits(collider, shape->id);
+  dSpaceAdd(getColliderSpace(collider), shape->id);
 }
 
 void lovrColliderRemoveShape(Collider* collider, Shape* shape) {
   if (shape->collider == collider) {
-    dSpaceRemove(collider->world->space, shape->id);
+    dSpaceRemove(dGeomGetSpace(shape->id), shape->id);
     dGeomSetBody(shape->id, 0);
+    dGeomSetCategoryBits(shape->id, ~0ul);
+    dGeomSetCollideBits(shape->id, ~0ul);
     shape->collider = NULL;
     lovrRelease(Shape, shape);
   }
@@ -398,10 +1523,12 @@ const char* lovrColliderGetTag(Collider* collider) {
 bool lovrColliderSetTag(Collider* collider, const char* tag) {
   if (!tag) {
     collider->tag = NO_TAG;
+    updateColliderBits(collider);
     return true;
   }
 
   collider->tag = findTag(collider->world, tag);
+  updateColliderBits(collider);
   return collider->tag != NO_TAG;
 }
 
@@ -426,11 +1553,21 @@ bool lovrColliderIsKinematic(Collider* collider) {
 }
 
 void lovrColliderSetKinematic(Collider* collider, bool kinematic) {
+  dSpaceID oldSpace = getColliderSpace(collider);
+
   if (kinematic) {
     dBodySetKinematic(collider->body);
   } else {
     dBodySetDynamic(collider->body);
   }
+
+  dSpaceID newSpace = getColliderSpace(collider);
+  if (newSpace != oldSpace) {
+    for (dGeomID geom = dBodyGetFirstGeom(collider->body); geom; geom = dBodyGetNextGeom(geom)) {
+      dSpaceRemove(oldSpace, geom);
+      dSpaceAdd(newSpace, geom);
+    }
+  }
 }
 
 bool lovrColliderIsGravityIgnored(Collider* collider) {
@@ -509,6 +1646,7 @@ void lovrColliderGetPosition(Collider* collider, float* x, float* y, float* z) {
 
 void lovrColliderSetPosition(Collider* collider, float x, float y, float z) {
   dBodySetPosition(collider->body, x, y, z);
+  syncPose(collider);
 }
 
 void lovrColliderGetOrientation(Collider* collider, float* angle, float* x, float* y, float* z) {
@@ -522,6 +1660,28 @@ void lovrColliderSetOrientation(Collider* collider, float angle, float x, float
   quat_fromAngleAxis(quaternion, angle, x, y, z);
   float q[4] = { quaternion[3], quaternion[0], quaternion[1], quaternion[2] };
   dBodySetQuaternion(collider->body, q);
+  syncPose(collider);
+}
+
+// Interpolated between the last two fixed steps, or the current pose if there is no step size
+void lovrColliderGetPose(Collider* collider, float position[3], float orientation[4]) {
+  World* world = collider->world;
+  float pose[7];
+
+  if (world->stepSize > 0.f) {
+    ColliderPose* p = &world->poses.data[collider->pose];
+    float t = world->alpha;
+    for (int i = 0; i < 3; i++) {
+      pose[i] = p->previous[i] + (p->current[i] - p->previous[i]) * t;
+    }
+    quat_init(pose + 3, p->previous + 3);
+    quat_slerp(pose + 3, p->current + 3, t);
+  } else {
+    readPose(collider, pose);
+  }
+
+  vec3_init(position, pose);
+  quat_init(orientation, pose + 3);
 }
 
 void lovrColliderGetLinearVelocity(Collider* collider, float* x, float* y, float* z) {
@@ -659,6 +1819,19 @@ void lovrColliderGetAABB(Collider* collider, float aabb[6]) {
 void lovrShapeDestroy(void* ref) {
   Shape* shape = ref;
   lovrShapeDestroyData(shape);
+
+  // Triangle data is kept around until the last reference goes away since clones share it
+  if (shape->parent) {
+    lovrRelease(Shape, shape->parent);
+  } else if (shape->mesh) {
+    dGeomTriMeshDataDestroy(shape->mesh);
+    free(shape->vertices);
+    free(shape->indices);
+  }
+
+  if (shape->heightfield) {
+    dGeomHeightfieldDataDestroy(shape->heightfield);
+  }
 }
 
 void lovrShapeDestroyData(Shape* shape) {
@@ -758,6 +1931,14 @@ void lovrShapeGetMass(Shape* shape, float density, float* cx, float* cy, float*
       dMassSetCylinder(&m, density, 3, radius, length);
       break;
     }
+
+    case SHAPE_MESH: {
+      dMassSetTrimesh(&m, density, shape->id);
+      break;
+    }
+
+    // Terrain is always static, it has no mass
+    case SHAPE_TERRAIN: break;
   }
 
   const dReal* position = dGeomGetOffsetPosition(shape->id);
@@ -873,6 +2054,142 @@ void lovrCylinderShapeSetLength(CylinderShape* cylinder, float length) {
   dGeomCylinderSetParams(cylinder->id, lovrCylinderShapeGetRadius(cylinder), length);
 }
 
+typedef arr_t(float) arr_float_t;
+typedef arr_t(uint32_t) arr_index_t;
+
+static void appendTriangles(ModelData* model, uint32_t nodeIndex, mat4 parentTransform, arr_float_t* vertices, arr_index_t* indices) {
+  ModelNode* node = &model->nodes[nodeIndex];
+
+  float transform[16];
+  mat4_init(transform, parentTransform);
+  if (node->matrix) {
+    mat4_multiply(transform, node->transform);
+  } else {
+    mat4_translate(transform, node->translation[0], node->translation[1], node->translation[2]);
+    mat4_rotateQuat(transform, node->rotation);
+    mat4_scale(transform, node->scale[0], node->scale[1], node->scale[2]);
+  }
+
+  for (uint32_t i = 0; i < node->primitiveCount; i++) {
+    ModelPrimitive* primitive = &model->primitives[node->primitiveIndex + i];
+    ModelAttribute* position = primitive->attributes[ATTR_POSITION];
+
+    if (!position || primitive->mode != DRAW_TRIANGLES) {
+      continue;
+    }
+
+    lovrAssert(position->type == F32 && position->components >= 3, "MeshShape vertex positions must be 3 component floats");
+    ModelBuffer* buffer = &model->buffers[position->buffer];
+    size_t stride = buffer->stride ? buffer->stride : position->components * sizeof(float);
+    char* data = buffer->data + position->offset;
+    uint32_t base = (uint32_t) (vertices->length / 3);
+
+    arr_reserve(vertices, vertices->length + 3 * position->count);
+    for (uint32_t j = 0; j < position->count; j++, data += stride) {
+      float v[4];
+      memcpy(v, data, 3 * sizeof(float));
+      mat4_transform(transform, v);
+      vertices->data[vertices->length++] = v[0];
+      vertices->data[vertices->length++] = v[1];
+      vertices->data[vertices->length++] = v[2];
+    }
+
+    ModelAttribute* index = primitive->indices;
+    if (index) {
+      ModelBuffer* indexBuffer = &model->buffers[index->buffer];
+      AttributeData indexData = { .raw = indexBuffer->data + index->offset };
+      arr_reserve(indices, indices->length + index->count);
+      for (uint32_t j = 0; j < index->count; j++) {
+        switch (index->type) {
+          case U8: indices->data[indices->length++] = base + indexData.u8[j]; break;
+          case U16: indices->data[indices->length++] = base + indexData.u16[j]; break;
+          case U32: indices->data[indices->length++] = base + indexData.u32[j]; break;
+          default: lovrThrow("Unreachable");
+        }
+      }
+    } else {
+      arr_reserve(indices, indices->length + position->count);
+      for (uint32_t j = 0; j < position->count; j++) {
+        indices->data[indices->length++] = base + j;
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < node->childCount; i++) {
+    appendTriangles(model, node->children[i], transform, vertices, indices);
+  }
+}
+
+MeshShape* lovrMeshShapeInit(MeshShape* mesh, ModelData* modelData) {
+  arr_float_t vertices;
+  arr_index_t indices;
+  arr_init(&vertices);
+  arr_init(&indices);
+
+  float transform[16];
+  mat4_identity(transform);
+  appendTriangles(modelData, modelData->rootNode, transform, &vertices, &indices);
+  lovrAssert(indices.length >= 3, "MeshShape needs at least one triangle");
+
+  mesh->type = SHAPE_MESH;
+  mesh->vertices = vertices.data;
+  mesh->indices = indices.data;
+  mesh->vertexCount = (uint32_t) (vertices.length / 3);
+  mesh->indexCount = (uint32_t) (indices.length - indices.length % 3);
+
+  // Building the data creates the BVH, preprocessing also bakes the edge angles used for contacts
+  mesh->mesh = dGeomTriMeshDataCreate();
+  dGeomTriMeshDataBuildSingle(mesh->mesh, mesh->vertices, 3 * sizeof(float), mesh->vertexCount, mesh->indices, mesh->indexCount, 3 * sizeof(uint32_t));
+  dGeomTriMeshDataPreprocess2(mesh->mesh, 1U << dTRIDATAPREPROCESS_BUILD_FACE_ANGLES, NULL);
+
+  mesh->id = dCreateTriMesh(0, mesh->mesh, NULL, NULL, NULL);
+  dGeomSetData(mesh->id, mesh);
+  return mesh;
+}
+
+MeshShape* lovrMeshShapeClone(MeshShape* mesh) {
+  MeshShape* clone = lovrAlloc(MeshShape);
+  clone->type = SHAPE_MESH;
+  clone->parent = mesh->parent ? mesh->parent : mesh;
+  clone->vertices = mesh->vertices;
+  clone->indices = mesh->indices;
+  clone->vertexCount = mesh->vertexCount;
+  clone->indexCount = mesh->indexCount;
+  clone->mesh = mesh->mesh;
+  clone->id = dCreateTriMesh(0, clone->mesh, NULL, NULL, NULL);
+  dGeomSetData(clone->id, clone);
+  lovrRetain(clone->parent);
+  return clone;
+}
+
+uint32_t lovrMeshShapeGetVertexCount(MeshShape* mesh) {
+  return mesh->vertexCount;
+}
+
+uint32_t lovrMeshShapeGetTriangleCount(MeshShape* mesh) {
+  return mesh->indexCount / 3;
+}
+
+TerrainShape* lovrTerrainShapeInit(TerrainShape* terrain, float width, float depth, uint32_t samplesX, uint32_t samplesZ, const float* heights, float scale) {
+  lovrAssert(samplesX >= 2 && samplesZ >= 2, "TerrainShape needs at least 2 samples on each axis");
+
+  float min = heights[0];
+  float max = heights[0];
+  for (uint32_t i = 1; i < samplesX * samplesZ; i++) {
+    min = MIN(min, heights[i]);
+    max = MAX(max, heights[i]);
+  }
+
+  // ODE copies the heights, and the bounds keep it from scanning them again for the AABB
+  terrain->type = SHAPE_TERRAIN;
+  terrain->heightfield = dGeomHeightfieldDataCreate();
+  dGeomHeightfieldDataBuildSingle(terrain->heightfield, heights, 1, width, depth, samplesX, samplesZ, scale, 0.f, 1.f, 0);
+  dGeomHeightfieldDataSetBounds(terrain->heightfield, min * scale, max * scale);
+  terrain->id = dCreateHeightfield(0, terrain->heightfield, 1);
+  dGeomSetData(terrain->id, terrain);
+  return terrain;
+}
+
 void lovrJointDestroy(void* ref) {
   Joint* joint = ref;
   lovrJointDestroyData(joint);
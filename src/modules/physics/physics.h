@@ -1,21 +1,46 @@
 #include "core/arr.h"
+#include "core/map.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <ode/ode.h>
 
 #pragma once
 
+struct ModelData;
+
 #define MAX_CONTACTS 4
-#define MAX_TAGS 16
+#define MAX_TAGS 64
 #define NO_TAG ~0u
+#define MAX_PHYSICS_THREADS 16
 
 typedef enum {
   SHAPE_SPHERE,
   SHAPE_BOX,
   SHAPE_CAPSULE,
-  SHAPE_CYLINDER
+  SHAPE_CYLINDER,
+  SHAPE_MESH,
+  SHAPE_TERRAIN
 } ShapeType;
 
+typedef enum {
+  BROADPHASE_HASH,
+  BROADPHASE_SAP,
+  BROADPHASE_QUADTREE,
+  BROADPHASE_SIMPLE
+} BroadphaseType;
+
+typedef enum {
+  CAST_RAY,
+  CAST_SPHERE,
+  CAST_BOX
+} CastType;
+
+typedef enum {
+  CONTACT_BEGIN,
+  CONTACT_PERSIST,
+  CONTACT_END
+} ContactEventType;
+
 typedef enum {
   JOINT_BALL,
   JOINT_DISTANCE,
@@ -26,20 +51,94 @@ typedef enum {
 typedef struct Collider Collider;
 typedef struct Shape Shape;
 typedef struct Joint Joint;
+typedef struct CastTarget CastTarget;
+typedef struct ContactPair ContactPair;
+typedef struct ContactJoint ContactJoint;
+typedef struct ActiveContact ActiveContact;
+typedef struct ColliderPose ColliderPose;
+typedef struct WorkerPool WorkerPool;
+typedef struct CastJob CastJob;
+
+// Collider pairs that touched during the last update, with their deepest contact.  End events only
+// have the colliders set.  Colliders are NULL if they were destroyed after the update.
+typedef struct {
+  ContactEventType type;
+  Collider* a;
+  Collider* b;
+  float position[3];
+  float normal[3];
+  float depth;
+  float impulse;
+} ContactEvent;
+
+// Shape is NULL when a query didn't hit anything, fraction is how far along the query the hit is
+typedef struct {
+  Shape* shape;
+  float position[3];
+  float normal[3];
+  float fraction;
+} CastHit;
+
+// Counters and timings (in seconds) for the last update, summed over its steps.  Tests are pairs
+// that made it past tag filtering to the narrowphase.  Awake bodies and islands are from the last
+// step, and are only counted after the stats have been queried once.
+typedef struct {
+  uint32_t steps;
+  uint32_t pairs;
+  uint32_t tests;
+  uint32_t contacts;
+  uint32_t awake;
+  uint32_t islands;
+  uint32_t iterations;
+  double broadphaseTime;
+  double narrowphaseTime;
+  double contactTime;
+  double solverTime;
+} WorldStats;
 
 typedef struct {
   dWorldID id;
   dSpaceID space;
+  dSpaceID staticSpace;
+  BroadphaseType broadphase;
   dJointGroupID contactGroup;
   arr_t(Shape*) overlaps;
+  arr_t(CastTarget) targets;
+  arr_t(CastHit) hits;
+  CastJob* cast;
+  arr_t(ContactPair) pairs;
+  WorkerPool* workers;
+  dThreadingImplementationID threading;
+  dThreadingThreadPoolID threadPool;
+  uint32_t threadCount;
   char* tags[MAX_TAGS];
-  uint16_t masks[MAX_TAGS];
+  uint64_t masks[MAX_TAGS];
+  map_t tagMap;
+  float frictions[MAX_TAGS][MAX_TAGS];
+  float restitutions[MAX_TAGS][MAX_TAGS];
+  arr_t(ContactEvent) events;
+  arr_t(ContactJoint) contactJoints;
+  arr_t(dJointFeedback) feedback;
+  arr_t(ActiveContact) activeContacts;
+  map_t contactMap;
+  uint32_t step;
+  uint32_t firstStep;
+  arr_t(ColliderPose) poses;
+  arr_t(Collider*) colliders;
+  float stepSize;
+  uint32_t maxSteps;
+  double accumulator;
+  float alpha;
+  WorldStats stats;
+  bool trackIslands;
+  arr_t(uint32_t) islands;
   Collider* head;
 } World;
 
 struct Collider {
   dBodyID body;
   World* world;
+  uint32_t pose;
   Collider* prev;
   Collider* next;
   void* userdata;
@@ -56,12 +155,21 @@ struct Shape {
   Collider* collider;
   void* userdata;
   bool sensor;
+  Shape* parent;
+  float* vertices;
+  uint32_t* indices;
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  dTriMeshDataID mesh;
+  dHeightfieldDataID heightfield;
 };
 
 typedef Shape SphereShape;
 typedef Shape BoxShape;
 typedef Shape CapsuleShape;
 typedef Shape CylinderShape;
+typedef Shape MeshShape;
+typedef Shape TerrainShape;
 
 struct Joint {
   JointType type;
@@ -85,11 +193,22 @@ typedef struct {
 bool lovrPhysicsInit(void);
 void lovrPhysicsDestroy(void);
 
-World* lovrWorldInit(World* world, float xg, float yg, float zg, bool allowSleep, const char** tags, uint32_t tagCount);
+World* lovrWorldInit(World* world, float xg, float yg, float zg, bool allowSleep, const char** tags, uint32_t tagCount, BroadphaseType broadphase);
 #define lovrWorldCreate(...) lovrWorldInit(lovrAlloc(World), __VA_ARGS__)
 void lovrWorldDestroy(void* ref);
 void lovrWorldDestroyData(World* world);
+BroadphaseType lovrWorldGetBroadphase(World* world);
 void lovrWorldUpdate(World* world, float dt, CollisionResolver resolver, void* userdata);
+void lovrWorldGetStepSize(World* world, float* stepSize, uint32_t* maxSteps);
+void lovrWorldSetStepSize(World* world, float stepSize, uint32_t maxSteps);
+float lovrWorldGetInterpolation(World* world);
+Collider** lovrWorldGetColliders(World* world, size_t* count);
+uint32_t lovrWorldGetPoses(World* world, float* data, uint32_t capacity, bool matrices, bool* changed);
+void* lovrWorldSnapshot(World* world, size_t* size);
+void lovrWorldRestore(World* world, const void* data, size_t size);
+uint64_t lovrWorldGetChecksum(World* world);
+void lovrWorldGetStats(World* world, WorldStats* stats);
+bool lovrWorldCheckDeterminism(World* world, float dt, uint32_t steps, uint64_t* checksum);
 void lovrWorldComputeOverlaps(World* world);
 int lovrWorldGetNextOverlap(World* world, Shape** a, Shape** b);
 int lovrWorldCollide(World* world, Shape* a, Shape* b, float friction, float restitution);
@@ -101,11 +220,18 @@ void lovrWorldGetAngularDamping(World* world, float* damping, float* threshold);
 void lovrWorldSetAngularDamping(World* world, float damping, float threshold);
 bool lovrWorldIsSleepingAllowed(World* world);
 void lovrWorldSetSleepingAllowed(World* world, bool allowed);
+uint32_t lovrWorldGetThreadCount(World* world);
+void lovrWorldSetThreadCount(World* world, uint32_t count);
 void lovrWorldRaycast(World* world, float x1, float y1, float z1, float x2, float y2, float z2, RaycastCallback callback, void* userdata);
+uint32_t lovrWorldCast(World* world, CastType type, float size[3], float orientation[4], uint64_t tagMask, const float* queries, uint32_t count, CastHit** hits);
+uint32_t lovrWorldFindTag(World* world, const char* name);
 const char* lovrWorldGetTagName(World* world, uint32_t tag);
 int lovrWorldDisableCollisionBetween(World* world, const char* tag1, const char* tag2);
 int lovrWorldEnableCollisionBetween(World* world, const char* tag1, const char* tag2);
 int lovrWorldIsCollisionEnabledBetween(World* world, const char* tag1, const char* tag);
+bool lovrWorldGetContactProperties(World* world, const char* tag1, const char* tag2, float* friction, float* restitution);
+bool lovrWorldSetContactProperties(World* world, const char* tag1, const char* tag2, float friction, float restitution);
+ContactEvent* lovrWorldGetContactEvents(World* world, size_t* count);
 
 Collider* lovrColliderInit(Collider* collider, World* world, float x, float y, float z);
 #define lovrColliderCreate(...) lovrColliderInit(lovrAlloc(Collider), __VA_ARGS__)
@@ -140,6 +266,7 @@ void lovrColliderGetPosition(Collider* collider, float* x, float* y, float* z);
 void lovrColliderSetPosition(Collider* collider, float x, float y, float z);
 void lovrColliderGetOrientation(Collider* collider, float* angle, float* x, float* y, float* z);
 void lovrColliderSetOrientation(Collider* collider, float angle, float x, float y, float z);
+void lovrColliderGetPose(Collider* collider, float position[3], float orientation[4]);
 void lovrColliderGetLinearVelocity(Collider* collider, float* x, float* y, float* z);
 void lovrColliderSetLinearVelocity(Collider* collider, float x, float y, float z);
 void lovrColliderGetAngularVelocity(Collider* collider, float* x, float* y, float* z);
@@ -205,6 +332,17 @@ void lovrCylinderShapeSetRadius(CylinderShape* cylinder, float radius);
 float lovrCylinderShapeGetLength(CylinderShape* cylinder);
 void lovrCylinderShapeSetLength(CylinderShape* cylinder, float length);
 
+MeshShape* lovrMeshShapeInit(MeshShape* mesh, struct ModelData* modelData);
+#define lovrMeshShapeCreate(...) lovrMeshShapeInit(lovrAlloc(MeshShape), __VA_ARGS__)
+#define lovrMeshShapeDestroy lovrShapeDestroy
+MeshShape* lovrMeshShapeClone(MeshShape* mesh);
+uint32_t lovrMeshShapeGetVertexCount(MeshShape* mesh);
+uint32_t lovrMeshShapeGetTriangleCount(MeshShape* mesh);
+
+TerrainShape* lovrTerrainShapeInit(TerrainShape* terrain, float width, float depth, uint32_t samplesX, uint32_t samplesZ, const float* heights, float scale);
+#define lovrTerrainShapeCreate(...) lovrTerrainShapeInit(lovrAlloc(TerrainShape), __VA_ARGS__)
+#define lovrTerrainShapeDestroy lovrShapeDestroy
+
 void lovrJointDestroy(void* ref);
 void lovrJointDestroyData(Joint* joint);
 JointType lovrJointGetType(Joint* joint);
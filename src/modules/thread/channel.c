@@ -1,13 +1,24 @@
 #include "thread/channel.h"
 #include "event/event.h"
 #include "core/arr.h"
+#include "core/atomic.h"
 #include "core/ref.h"
 #include "util.h"
 #include "lib/tinycthread/tinycthread.h"
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <math.h>
 
+// Bounded Channels are a lock-free ring of slots (Vyukov's MPMC queue).  A slot's sequence says
+// whose turn it is: it's twice the push position when the slot is free and one more than that once
+// it holds a message.  Doubling keeps a full slot from looking free for the next position, which
+// happens with a single slot otherwise.  Positions are 64 bits so they never wrap.
+typedef struct {
+  volatile uint64_t sequence;
+  Variant value;
+} Slot;
+
 struct Channel {
   mtx_t lock;
   cnd_t cond;
@@ -16,34 +27,200 @@ struct Channel {
   uint64_t sent;
   uint64_t received;
   uint64_t hash;
+  volatile uint64_t highWater;
+  uint32_t capacity;
+  Slot* slots;
+  cnd_t readable;
+  cnd_t writable;
+  volatile uint32_t poppers;
+  volatile uint32_t pushers;
+  uint8_t padding0[64];
+  volatile uint64_t pushPosition;
+  uint8_t padding1[64];
+  volatile uint64_t popPosition;
+  uint8_t padding2[64];
 };
 
-Channel* lovrChannelCreate(uint64_t hash) {
+Channel* lovrChannelCreate(uint64_t hash, uint32_t capacity) {
   Channel* channel = lovrAlloc(Channel);
   arr_init(&channel->messages);
   mtx_init(&channel->lock, mtx_plain | mtx_timed);
   cnd_init(&channel->cond);
   channel->hash = hash;
+
+  if (capacity > 0) {
+    channel->capacity = capacity;
+    channel->slots = malloc(capacity * sizeof(Slot));
+    lovrAssert(channel->slots, "Out of memory");
+    for (uint32_t i = 0; i < capacity; i++) {
+      channel->slots[i].sequence = 2 * (uint64_t) i;
+    }
+    cnd_init(&channel->readable);
+    cnd_init(&channel->writable);
+  }
+
   return channel;
 }
 
 extern void lovrThreadRemoveChannel(uint64_t hash);
 void lovrChannelDestroy(void* ref) {
   Channel* channel = ref;
-  lovrThreadRemoveChannel(channel->hash);
+  if (channel->hash) {
+    lovrThreadRemoveChannel(channel->hash);
+  }
   lovrChannelClear(channel);
   arr_free(&channel->messages);
   mtx_destroy(&channel->lock);
   cnd_destroy(&channel->cond);
+  if (channel->slots) {
+    free(channel->slots);
+    cnd_destroy(&channel->readable);
+    cnd_destroy(&channel->writable);
+  }
 }
 
+// Waits on a condition variable for up to timeout seconds (forever if it's infinite), subtracting
+// the time spent waiting from the timeout
+static void waitFor(cnd_t* cond, mtx_t* lock, double* timeout) {
+  if (isinf(*timeout)) {
+    cnd_wait(cond, lock);
+  } else {
+    struct timespec start;
+    struct timespec until;
+    struct timespec stop;
+    timespec_get(&start, TIME_UTC);
+    double whole, fraction;
+    fraction = modf(*timeout, &whole);
+    until.tv_sec = start.tv_sec + whole;
+    until.tv_nsec = start.tv_nsec + fraction * 1e9;
+    if (until.tv_nsec >= 1000000000) {
+      until.tv_sec++;
+      until.tv_nsec -= 1000000000;
+    }
+    cnd_timedwait(cond, lock, &until);
+    timespec_get(&stop, TIME_UTC);
+    *timeout -= (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+  }
+}
+
+static void updateHighWater(Channel* channel, uint64_t count) {
+  uint64_t highWater = atomic_load64(&channel->highWater);
+  while (count > highWater && !atomic_cas64(&channel->highWater, &highWater, count)) {
+    continue;
+  }
+}
+
+static bool tryPush(Channel* channel, Variant* variant, uint64_t* id) {
+  uint64_t position = atomic_load64(&channel->pushPosition);
+  for (;;) {
+    Slot* slot = &channel->slots[position % channel->capacity];
+    int64_t difference = (int64_t) (atomic_load64(&slot->sequence) - 2 * position);
+    if (difference == 0) {
+      if (atomic_cas64(&channel->pushPosition, &position, position + 1)) {
+        slot->value = *variant;
+        atomic_store64(&slot->sequence, 2 * position + 1);
+        *id = position + 1;
+        return true;
+      }
+    } else if (difference < 0) {
+      return false;
+    } else {
+      position = atomic_load64(&channel->pushPosition);
+    }
+  }
+}
+
+static bool tryPop(Channel* channel, Variant* variant) {
+  uint64_t position = atomic_load64(&channel->popPosition);
+  for (;;) {
+    Slot* slot = &channel->slots[position % channel->capacity];
+    int64_t difference = (int64_t) (atomic_load64(&slot->sequence) - (2 * position + 1));
+    if (difference == 0) {
+      if (atomic_cas64(&channel->popPosition, &position, position + 1)) {
+        *variant = slot->value;
+        atomic_store64(&slot->sequence, 2 * (position + channel->capacity));
+        return true;
+      }
+    } else if (difference < 0) {
+      return false;
+    } else {
+      position = atomic_load64(&channel->popPosition);
+    }
+  }
+}
+
+// Waiters announce themselves before checking the ring one last time under the lock, and the other
+// side checks for waiters after a full fence, so one of them always sees the other.  Only one
+// waiter is woken up per message or free slot.
+static void wakeOne(Channel* channel, cnd_t* cond, volatile uint32_t* waiters) {
+  atomic_fence();
+  if (atomic_load32(waiters) > 0) {
+    mtx_lock(&channel->lock);
+    cnd_signal(cond);
+    mtx_unlock(&channel->lock);
+  }
+}
+
+// Pushing to a full bounded Channel waits for space for up to timeout seconds, and fails if there
+// still isn't any.  The id is 0 when the push fails.
+static bool pushBounded(Channel* channel, Variant* variant, double timeout, uint64_t* id) {
+  *id = 0;
+  bool pushed = tryPush(channel, variant, id);
+
+  if (!pushed && !isnan(timeout) && timeout >= 0) {
+    atomic_add32(&channel->pushers, 1);
+    mtx_lock(&channel->lock);
+    while (!(pushed = tryPush(channel, variant, id)) && timeout >= 0) {
+      waitFor(&channel->writable, &channel->lock, &timeout);
+    }
+    mtx_unlock(&channel->lock);
+    atomic_add32(&channel->pushers, -1);
+  }
+
+  if (pushed) {
+    uint64_t popped = atomic_load64(&channel->popPosition);
+    if (*id > popped) {
+      updateHighWater(channel, *id - popped);
+    }
+    wakeOne(channel, &channel->readable, &channel->poppers);
+  }
+
+  return pushed;
+}
+
+static bool popBounded(Channel* channel, Variant* variant, double timeout) {
+  bool popped = tryPop(channel, variant);
+
+  if (!popped && !isnan(timeout) && timeout >= 0) {
+    atomic_add32(&channel->poppers, 1);
+    mtx_lock(&channel->lock);
+    while (!(popped = tryPop(channel, variant)) && timeout >= 0) {
+      waitFor(&channel->readable, &channel->lock, &timeout);
+    }
+    mtx_unlock(&channel->lock);
+    atomic_add32(&channel->poppers, -1);
+  }
+
+  if (popped) {
+    wakeOne(channel, &channel->writable, &channel->pushers);
+  }
+
+  return popped;
+}
+
+// For unbounded Channels, a timeout waits for the message to be read
 bool lovrChannelPush(Channel* channel, Variant* variant, double timeout, uint64_t* id) {
+  if (channel->slots) {
+    return pushBounded(channel, variant, timeout, id);
+  }
+
   mtx_lock(&channel->lock);
   if (channel->messages.length == 0) {
     lovrRetain(channel);
   }
   arr_push(&channel->messages, *variant);
   *id = ++channel->sent;
+  channel->highWater = MAX(channel->highWater, channel->messages.length - channel->head);
   cnd_broadcast(&channel->cond);
 
   if (isnan(timeout) || timeout < 0) {
@@ -52,21 +229,7 @@ bool lovrChannelPush(Channel* channel, Variant* variant, double timeout, uint64_
   }
 
   while (channel->received < *id && timeout >= 0) {
-    if (isinf(timeout)) {
-      cnd_wait(&channel->cond, &channel->lock);
-    } else {
-      struct timespec start;
-      struct timespec until;
-      struct timespec stop;
-      timespec_get(&start, TIME_UTC);
-      double whole, fraction;
-      fraction = modf(timeout, &whole);
-      until.tv_sec = start.tv_sec + whole;
-      until.tv_nsec = start.tv_nsec + fraction * 1e9;
-      cnd_timedwait(&channel->cond, &channel->lock, &until);
-      timespec_get(&stop, TIME_UTC);
-      timeout -= (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
-    }
+    waitFor(&channel->cond, &channel->lock, &timeout);
   }
 
   bool read = channel->received >= *id;
@@ -75,6 +238,10 @@ bool lovrChannelPush(Channel* channel, Variant* variant, double timeout, uint64_
 }
 
 bool lovrChannelPop(Channel* channel, Variant* variant, double timeout) {
+  if (channel->slots) {
+    return popBounded(channel, variant, timeout);
+  }
+
   mtx_lock(&channel->lock);
 
   do {
@@ -93,25 +260,122 @@ bool lovrChannelPop(Channel* channel, Variant* variant, double timeout) {
       return false;
     }
 
-    if (isinf(timeout)) {
-      cnd_wait(&channel->cond, &channel->lock);
-    } else {
-      struct timespec start;
-      struct timespec until;
-      struct timespec stop;
-      timespec_get(&start, TIME_UTC);
-      double whole, fraction;
-      fraction = modf(timeout, &whole);
-      until.tv_sec = start.tv_sec + whole;
-      until.tv_nsec = start.tv_nsec + fraction * 1e9;
-      cnd_timedwait(&channel->cond, &channel->lock, &until);
-      timespec_get(&stop, TIME_UTC);
-      timeout -= (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / (double) 1e9;
-    }
+    waitFor(&channel->cond, &channel->lock, &timeout);
   } while (1);
 }
 
+// Batches take the lock and wake waiters once for the whole batch.  Bounded Channels push as many
+// as they can, waiting for space up to the timeout, and return how many were pushed.  For unbounded
+// Channels, a timeout waits for the last message to be read.
+uint32_t lovrChannelPushMany(Channel* channel, Variant* variants, uint32_t count, double timeout, uint64_t* id) {
+  *id = 0;
+
+  if (channel->slots) {
+    uint32_t pushed = 0;
+    while (pushed < count && tryPush(channel, &variants[pushed], id)) {
+      pushed++;
+    }
+
+    if (pushed < count && !isnan(timeout) && timeout >= 0) {
+      atomic_add32(&channel->pushers, 1);
+      mtx_lock(&channel->lock);
+      while (pushed < count && timeout >= 0) {
+        if (tryPush(channel, &variants[pushed], id)) {
+          pushed++;
+        } else {
+          cnd_broadcast(&channel->readable);
+          waitFor(&channel->writable, &channel->lock, &timeout);
+        }
+      }
+      mtx_unlock(&channel->lock);
+      atomic_add32(&channel->pushers, -1);
+    }
+
+    if (pushed > 0) {
+      uint64_t popped = atomic_load64(&channel->popPosition);
+      if (*id > popped) {
+        updateHighWater(channel, *id - popped);
+      }
+      atomic_fence();
+      if (atomic_load32(&channel->poppers) > 0) {
+        mtx_lock(&channel->lock);
+        cnd_broadcast(&channel->readable);
+        mtx_unlock(&channel->lock);
+      }
+    }
+
+    return pushed;
+  }
+
+  if (count == 0) {
+    return 0;
+  }
+
+  mtx_lock(&channel->lock);
+  if (channel->messages.length == 0) {
+    lovrRetain(channel);
+  }
+  arr_append(&channel->messages, variants, count);
+  channel->sent += count;
+  *id = channel->sent;
+  channel->highWater = MAX(channel->highWater, channel->messages.length - channel->head);
+  cnd_broadcast(&channel->cond);
+
+  while (!isnan(timeout) && timeout >= 0 && channel->received < *id) {
+    waitFor(&channel->cond, &channel->lock, &timeout);
+  }
+
+  mtx_unlock(&channel->lock);
+  return count;
+}
+
+// Waits up to timeout for the first message, then takes whatever else is already there
+uint32_t lovrChannelPopMany(Channel* channel, Variant* variants, uint32_t count, double timeout) {
+  if (count == 0 || !lovrChannelPop(channel, &variants[0], timeout)) {
+    return 0;
+  }
+
+  uint32_t popped = 1;
+
+  if (channel->slots) {
+    while (popped < count && tryPop(channel, &variants[popped])) {
+      popped++;
+    }
+
+    if (popped > 1) {
+      atomic_fence();
+      if (atomic_load32(&channel->pushers) > 0) {
+        mtx_lock(&channel->lock);
+        cnd_broadcast(&channel->writable);
+        mtx_unlock(&channel->lock);
+      }
+    }
+
+    return popped;
+  }
+
+  mtx_lock(&channel->lock);
+  size_t available = channel->messages.length - channel->head;
+  uint32_t n = (uint32_t) MIN(available, count - popped);
+  if (n > 0) {
+    memcpy(variants + popped, channel->messages.data + channel->head, n * sizeof(Variant));
+    channel->head += n;
+    channel->received += n;
+    popped += n;
+    if (channel->head == channel->messages.length) {
+      channel->head = channel->messages.length = 0;
+      lovrRelease(Channel, channel);
+    }
+    cnd_broadcast(&channel->cond);
+  }
+  mtx_unlock(&channel->lock);
+  return popped;
+}
+
+// Bounded Channels are popped without the lock, so another thread could pop and destroy the message
+// while it's being peeked
 bool lovrChannelPeek(Channel* channel, Variant* variant) {
+  lovrAssert(!channel->slots, "Bounded Channels can not be peeked");
   mtx_lock(&channel->lock);
 
   if (channel->head < channel->messages.length) {
@@ -125,6 +389,20 @@ bool lovrChannelPeek(Channel* channel, Variant* variant) {
 }
 
 void lovrChannelClear(Channel* channel) {
+  if (channel->slots) {
+    Variant variant;
+    while (tryPop(channel, &variant)) {
+      lovrVariantDestroy(&variant);
+    }
+    atomic_fence();
+    if (atomic_load32(&channel->pushers) > 0) {
+      mtx_lock(&channel->lock);
+      cnd_broadcast(&channel->writable);
+      mtx_unlock(&channel->lock);
+    }
+    return;
+  }
+
   mtx_lock(&channel->lock);
   for (size_t i = channel->head; i < channel->messages.length; i++) {
     lovrVariantDestroy(&channel->messages.data[i]);
@@ -137,6 +415,12 @@ void lovrChannelClear(Channel* channel) {
 }
 
 uint64_t lovrChannelGetCount(Channel* channel) {
+  if (channel->slots) {
+    uint64_t popped = atomic_load64(&channel->popPosition);
+    uint64_t pushed = atomic_load64(&channel->pushPosition);
+    return pushed > popped ? pushed - popped : 0;
+  }
+
   mtx_lock(&channel->lock);
   uint64_t length = channel->messages.length - channel->head;
   mtx_unlock(&channel->lock);
@@ -144,8 +428,21 @@ uint64_t lovrChannelGetCount(Channel* channel) {
 }
 
 bool lovrChannelHasRead(Channel* channel, uint64_t id) {
+  if (channel->slots) {
+    return atomic_load64(&channel->popPosition) >= id;
+  }
+
   mtx_lock(&channel->lock);
   bool received = channel->received >= id;
   mtx_unlock(&channel->lock);
   return received;
 }
+
+uint32_t lovrChannelGetCapacity(Channel* channel) {
+  return channel->capacity;
+}
+
+// Most messages the Channel has held at once
+uint64_t lovrChannelGetHighWater(Channel* channel) {
+  return atomic_load64(&channel->highWater);
+}
@@ -6,11 +6,15 @@
 struct Variant;
 
 typedef struct Channel Channel;
-Channel* lovrChannelCreate(uint64_t hash);
+Channel* lovrChannelCreate(uint64_t hash, uint32_t capacity);
 void lovrChannelDestroy(void* ref);
 bool lovrChannelPush(Channel* channel, struct Variant* variant, double timeout, uint64_t* id);
 bool lovrChannelPop(Channel* channel, struct Variant* variant, double timeout);
+uint32_t lovrChannelPushMany(Channel* channel, struct Variant* variants, uint32_t count, double timeout, uint64_t* id);
+uint32_t lovrChannelPopMany(Channel* channel, struct Variant* variants, uint32_t count, double timeout);
 bool lovrChannelPeek(Channel* channel, struct Variant* variant);
 void lovrChannelClear(Channel* channel);
 uint64_t lovrChannelGetCount(Channel* channel);
 bool lovrChannelHasRead(Channel* channel, uint64_t id);
+uint32_t lovrChannelGetCapacity(Channel* channel);
+uint64_t lovrChannelGetHighWater(Channel* channel);
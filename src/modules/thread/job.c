@@ -0,0 +1,380 @@
+#include "thread/job.h"
+#include "core/arr.h"
+#include "core/atomic.h"
+#include "core/platform.h"
+#include "core/ref.h"
+#include "util.h"
+#include "lib/tinycthread/tinycthread.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define DEQUE_SIZE 1024
+
+// A Job is blocked until its dependencies finish and it gets submitted, and it's unfinished until
+// it runs and all of its children finish.
+struct Job {
+  jobFn* fn;
+  void* context;
+  uint32_t start;
+  uint32_t count;
+  Job* parent;
+  arr_t(Job*) dependents;
+  bool submitted;
+  bool finished;
+  volatile uint32_t blockers;
+  volatile uint32_t unfinished;
+};
+
+// Each worker owns a Chase-Lev deque: the owner pushes and pops at the bottom, everyone else steals
+// from the top.  Positions start at 1 so the owner's speculative decrement never wraps.
+typedef struct {
+  thrd_t thread;
+  uint8_t padding0[64];
+  volatile uint64_t top;
+  uint8_t padding1[64];
+  volatile uint64_t bottom;
+  uint8_t padding2[64];
+  Job* volatile jobs[DEQUE_SIZE];
+} Worker;
+
+static struct {
+  bool initialized;
+  bool quit;
+  uint32_t workerCount;
+  Worker* workers;
+  mtx_t lock;
+  cnd_t wake;
+  mtx_t dependencyLock;
+  arr_t(Job*) queue;
+  size_t queueHead;
+  volatile uint32_t external;
+  volatile uint32_t queued;
+  volatile uint32_t sleeping;
+} state;
+
+// The thread that initializes the job system gets the first deque, threads that aren't workers
+// submit to a shared queue instead
+static LOVR_THREAD_LOCAL Worker* worker;
+static LOVR_THREAD_LOCAL uint32_t victim;
+
+static bool dequePush(Worker* w, Job* job) {
+  uint64_t bottom = w->bottom;
+  if (bottom - atomic_load64(&w->top) >= DEQUE_SIZE) {
+    return false;
+  }
+
+  w->jobs[bottom & (DEQUE_SIZE - 1)] = job;
+  atomic_store64(&w->bottom, bottom + 1);
+  return true;
+}
+
+static Job* dequePop(Worker* w) {
+  uint64_t bottom = w->bottom - 1;
+  atomic_store64(&w->bottom, bottom);
+  atomic_fence();
+  uint64_t top = atomic_load64(&w->top);
+
+  if (top > bottom) {
+    atomic_store64(&w->bottom, bottom + 1);
+    return NULL;
+  }
+
+  Job* job = w->jobs[bottom & (DEQUE_SIZE - 1)];
+
+  // Race thieves for the last job
+  if (top == bottom) {
+    if (!atomic_cas64(&w->top, &top, top + 1)) {
+      job = NULL;
+    }
+    atomic_store64(&w->bottom, bottom + 1);
+  }
+
+  return job;
+}
+
+static Job* dequeSteal(Worker* w) {
+  uint64_t top = atomic_load64(&w->top);
+  atomic_fence();
+  uint64_t bottom = atomic_load64(&w->bottom);
+
+  if (top >= bottom) {
+    return NULL;
+  }
+
+  Job* job = w->jobs[top & (DEQUE_SIZE - 1)];
+  return atomic_cas64(&w->top, &top, top + 1) ? job : NULL;
+}
+
+static Job* take() {
+  Job* job = NULL;
+
+  if (worker) {
+    job = dequePop(worker);
+  }
+
+  if (!job && atomic_load32(&state.external) > 0) {
+    mtx_lock(&state.lock);
+    if (state.queueHead < state.queue.length) {
+      job = state.queue.data[state.queueHead++];
+      atomic_add32(&state.external, (uint32_t) -1);
+      if (state.queueHead == state.queue.length) {
+        arr_clear(&state.queue);
+        state.queueHead = 0;
+      }
+    }
+    mtx_unlock(&state.lock);
+  }
+
+  uint32_t count = state.workerCount + 1;
+  for (uint32_t i = 0; !job && i < count && state.workers; i++) {
+    Worker* w = &state.workers[victim++ % count];
+    if (w != worker) {
+      job = dequeSteal(w);
+    }
+  }
+
+  if (job) {
+    atomic_add32(&state.queued, (uint32_t) -1);
+  }
+
+  return job;
+}
+
+static void run(Job* job);
+
+static void enqueue(Job* job) {
+  if (state.workerCount == 0) {
+    run(job);
+    return;
+  }
+
+  atomic_add32(&state.queued, 1);
+
+  if (!worker || !dequePush(worker, job)) {
+    mtx_lock(&state.lock);
+    arr_push(&state.queue, job);
+    atomic_add32(&state.external, 1);
+    mtx_unlock(&state.lock);
+  }
+
+  // Sleeping workers bump the sleep count before checking the queue, so one side always sees the other
+  atomic_fence();
+  if (atomic_load32(&state.sleeping) > 0) {
+    mtx_lock(&state.lock);
+    cnd_signal(&state.wake);
+    mtx_unlock(&state.lock);
+  }
+}
+
+static void finish(Job* job) {
+  if (atomic_add32(&job->unfinished, (uint32_t) -1) > 0) {
+    return;
+  }
+
+  mtx_lock(&state.dependencyLock);
+  job->finished = true;
+  mtx_unlock(&state.dependencyLock);
+
+  for (size_t i = 0; i < job->dependents.length; i++) {
+    Job* dependent = job->dependents.data[i];
+    if (atomic_add32(&dependent->blockers, (uint32_t) -1) == 0) {
+      enqueue(dependent);
+    }
+    lovrRelease(Job, dependent);
+  }
+  arr_clear(&job->dependents);
+
+  if (job->parent) {
+    finish(job->parent);
+  }
+
+  lovrRelease(Job, job);
+}
+
+static void run(Job* job) {
+  if (job->fn) {
+    job->fn(job->context, job->start, job->count);
+  }
+
+  finish(job);
+}
+
+static int workerLoop(void* arg) {
+  worker = arg;
+
+  for (;;) {
+    Job* job = take();
+
+    if (job) {
+      run(job);
+      continue;
+    }
+
+    mtx_lock(&state.lock);
+    atomic_add32(&state.sleeping, 1);
+    atomic_fence();
+    while (atomic_load32(&state.queued) == 0 && !state.quit) {
+      cnd_wait(&state.wake, &state.lock);
+    }
+    atomic_add32(&state.sleeping, (uint32_t) -1);
+    bool quit = state.quit && atomic_load32(&state.queued) == 0;
+    mtx_unlock(&state.lock);
+
+    if (quit) {
+      return 0;
+    }
+  }
+}
+
+// A worker count of zero uses one worker for each core besides the current one
+bool lovrJobsInit(uint32_t workerCount) {
+  if (state.initialized) return false;
+
+  if (workerCount == 0) {
+    uint32_t cores = lovrPlatformGetCoreCount();
+    workerCount = cores > 1 ? cores - 1 : 0;
+  }
+
+  state.workerCount = MIN(workerCount, MAX_WORKERS);
+  state.workers = calloc(state.workerCount + 1, sizeof(Worker));
+  lovrAssert(state.workers, "Out of memory");
+  mtx_init(&state.lock, mtx_plain);
+  mtx_init(&state.dependencyLock, mtx_plain);
+  cnd_init(&state.wake);
+  arr_init(&state.queue);
+
+  for (uint32_t i = 0; i <= state.workerCount; i++) {
+    state.workers[i].top = state.workers[i].bottom = 1;
+  }
+
+  worker = &state.workers[0];
+
+  for (uint32_t i = 1; i <= state.workerCount; i++) {
+    lovrAssert(thrd_create(&state.workers[i].thread, workerLoop, &state.workers[i]) == thrd_success, "Could not create job worker");
+  }
+
+  return state.initialized = true;
+}
+
+// Workers finish any queued jobs before they exit
+void lovrJobsDestroy() {
+  if (!state.initialized) return;
+
+  mtx_lock(&state.lock);
+  state.quit = true;
+  cnd_broadcast(&state.wake);
+  mtx_unlock(&state.lock);
+
+  for (uint32_t i = 1; i <= state.workerCount; i++) {
+    thrd_join(state.workers[i].thread, NULL);
+  }
+
+  free(state.workers);
+  arr_free(&state.queue);
+  mtx_destroy(&state.lock);
+  mtx_destroy(&state.dependencyLock);
+  cnd_destroy(&state.wake);
+  worker = NULL;
+  memset(&state, 0, sizeof(state));
+}
+
+uint32_t lovrJobsGetWorkerCount() {
+  return state.workerCount;
+}
+
+// Splits a range into jobs of grain indices each and helps run them.  A grain of zero makes about 4
+// jobs per thread.  Runs inline when there are no workers (or no job system) or the range fits in
+// one job.
+void lovrJobsParallelFor(jobFn* fn, void* context, uint32_t count, uint32_t grain) {
+  if (count == 0) {
+    return;
+  }
+
+  if (grain == 0) {
+    grain = MAX(count / (4 * (state.workerCount + 1)), 1);
+  }
+
+  if (state.workerCount == 0 || count <= grain) {
+    fn(context, 0, count);
+    return;
+  }
+
+  Job* root = lovrJobCreate(NULL, NULL, 0, 0, NULL);
+
+  for (uint32_t start = 0; start < count; start += grain) {
+    Job* job = lovrJobCreate(fn, context, start, MIN(grain, count - start), root);
+    lovrJobSubmit(job);
+    lovrRelease(Job, job);
+  }
+
+  lovrJobSubmit(root);
+  lovrJobWait(root);
+  lovrRelease(Job, root);
+}
+
+// Children have to be created before their parent finishes, usually before it's submitted or while
+// it's running
+Job* lovrJobCreate(jobFn* fn, void* context, uint32_t start, uint32_t count, Job* parent) {
+  lovrAssert(state.initialized, "The job system is not initialized");
+  Job* job = lovrAlloc(Job);
+  job->fn = fn;
+  job->context = context;
+  job->start = start;
+  job->count = count;
+  job->blockers = 1;
+  job->unfinished = 1;
+  arr_init(&job->dependents);
+
+  if (parent) {
+    lovrAssert(atomic_add32(&parent->unfinished, 1) > 1, "Parent job has already finished");
+    lovrRetain(parent);
+    job->parent = parent;
+  }
+
+  return job;
+}
+
+void lovrJobDestroy(void* ref) {
+  Job* job = ref;
+  arr_free(&job->dependents);
+  lovrRelease(Job, job->parent);
+}
+
+// Dependencies have to be added before the job is submitted
+void lovrJobDepend(Job* job, Job* dependency) {
+  lovrAssert(!job->submitted, "Dependencies must be added before a job is submitted");
+  mtx_lock(&state.dependencyLock);
+  if (!dependency->finished) {
+    atomic_add32(&job->blockers, 1);
+    arr_push(&dependency->dependents, job);
+    lovrRetain(job);
+  }
+  mtx_unlock(&state.dependencyLock);
+}
+
+// The job system holds a reference until the job finishes
+void lovrJobSubmit(Job* job) {
+  lovrAssert(!job->submitted, "Job has already been submitted");
+  job->submitted = true;
+  lovrRetain(job);
+  if (atomic_add32(&job->blockers, (uint32_t) -1) == 0) {
+    enqueue(job);
+  }
+}
+
+// Waiting threads run other jobs instead of sleeping
+void lovrJobWait(Job* job) {
+  lovrAssert(job->submitted, "Job must be submitted before waiting for it");
+  while (atomic_load32(&job->unfinished) > 0) {
+    Job* next = take();
+    if (next) {
+      run(next);
+    } else {
+      thrd_yield();
+    }
+  }
+}
+
+bool lovrJobIsDone(Job* job) {
+  return atomic_load32(&job->unfinished) == 0;
+}
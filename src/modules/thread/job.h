@@ -0,0 +1,24 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#pragma once
+
+#define MAX_WORKERS 32
+
+// Jobs run a function over a range of indices.  They must not throw, since workers have nowhere to
+// unwind to.
+typedef void jobFn(void* context, uint32_t start, uint32_t count);
+
+typedef struct Job Job;
+
+bool lovrJobsInit(uint32_t workerCount);
+void lovrJobsDestroy(void);
+uint32_t lovrJobsGetWorkerCount(void);
+void lovrJobsParallelFor(jobFn* fn, void* context, uint32_t count, uint32_t grain);
+
+Job* lovrJobCreate(jobFn* fn, void* context, uint32_t start, uint32_t count, Job* parent);
+void lovrJobDestroy(void* ref);
+void lovrJobDepend(Job* job, Job* dependency);
+void lovrJobSubmit(Job* job);
+void lovrJobWait(Job* job);
+bool lovrJobIsDone(Job* job);
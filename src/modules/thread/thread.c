@@ -1,28 +1,223 @@
 #include "thread/thread.h"
 #include "thread/channel.h"
+#include "thread/job.h"
 #include "core/arr.h"
 #include "core/hash.h"
 #include "core/map.h"
+#include "core/platform.h"
 #include "core/ref.h"
 #include "util.h"
 #include <stdlib.h>
 #include <string.h>
 
+// Pool threads that finish a run while this many others are idle exit instead of staying around
+#define MAX_IDLE_THREADS 32
+
+// The pool lives on the heap and is shared by its threads, so threads still busy at shutdown can
+// be detached and clean it up after their run, even if the module is initialized again
+typedef struct {
+  mtx_t lock;
+  cnd_t cond;
+  bool quit;
+  uint32_t refs;
+  uint32_t idle;
+  arr_t(struct PoolThread*) threads;
+  arr_t(Thread*) pending;
+  size_t pendingHead;
+} ThreadPool;
+
+typedef struct PoolThread {
+  thrd_t handle;
+  ThreadPool* pool;
+  int (*warmup)(void*);
+  bool busy;
+} PoolThread;
+
 static struct {
   bool initialized;
   arr_t(Channel*) channels;
   map_t channelMap;
+  ThreadPool* pool;
 } state;
 
+static void finishThread(Thread* thread) {
+  mtx_lock(&thread->lock);
+  thread->running = false;
+  cnd_broadcast(&thread->finished);
+  mtx_unlock(&thread->lock);
+  lovrRelease(Thread, thread);
+}
+
+// Must be called with the pool lock held, returns whether the pool was destroyed (and unlocked)
+static bool releasePool(ThreadPool* pool) {
+  if (--pool->refs > 0) {
+    return false;
+  }
+
+  mtx_unlock(&pool->lock);
+  mtx_destroy(&pool->lock);
+  cnd_destroy(&pool->cond);
+  arr_free(&pool->threads);
+  arr_free(&pool->pending);
+  free(pool);
+  return true;
+}
+
+// Pool threads count as idle from the moment they're spawned, so a burst of starts doesn't spawn
+// more threads than it needs
+static int poolLoop(void* arg) {
+  PoolThread* self = arg;
+  ThreadPool* pool = self->pool;
+
+  if (self->warmup) {
+    self->warmup(NULL);
+  }
+
+  mtx_lock(&pool->lock);
+  for (;;) {
+    while (pool->pendingHead == pool->pending.length && !pool->quit) {
+      cnd_wait(&pool->cond, &pool->lock);
+    }
+
+    if (pool->quit) {
+      break;
+    }
+
+    Thread* thread = pool->pending.data[pool->pendingHead++];
+    if (pool->pendingHead == pool->pending.length) {
+      arr_clear(&pool->pending);
+      pool->pendingHead = 0;
+    }
+
+    pool->idle--;
+    self->busy = true;
+    mtx_unlock(&pool->lock);
+
+    thread->runner(thread);
+
+    // Back in the pool before anyone waiting on the Thread wakes up and starts another one.  If the
+    // pool already has plenty of idle threads, this one leaves it and detaches itself instead.
+    mtx_lock(&pool->lock);
+    self->busy = false;
+    bool leave = pool->idle >= MAX_IDLE_THREADS && !pool->quit;
+    if (leave) {
+      for (size_t i = 0; i < pool->threads.length; i++) {
+        if (pool->threads.data[i] == self) {
+          pool->threads.data[i] = pool->threads.data[--pool->threads.length];
+          break;
+        }
+      }
+    } else {
+      pool->idle++;
+    }
+    mtx_unlock(&pool->lock);
+
+    finishThread(thread);
+
+    if (leave) {
+      thrd_detach(thrd_current());
+      free(self);
+      return 0;
+    }
+
+    mtx_lock(&pool->lock);
+  }
+
+  // Threads that got detached at shutdown own themselves, joined ones are freed by the joiner
+  bool detached = self->pool == NULL;
+  if (detached) {
+    free(self);
+  }
+
+  if (!detached || !releasePool(pool)) {
+    mtx_unlock(&pool->lock);
+  }
+  return 0;
+}
+
+// Must be called with the pool lock held, so it returns whether it worked instead of throwing and
+// leaves the error to the caller once the lock is released
+static bool spawn(ThreadPool* pool, int (*warmup)(void*)) {
+  PoolThread* thread = malloc(sizeof(PoolThread));
+  if (!thread) {
+    return false;
+  }
+
+  thread->pool = pool;
+  thread->warmup = warmup;
+  thread->busy = false;
+  arr_push(&pool->threads, thread);
+  pool->idle++;
+
+  if (thrd_create(&thread->handle, poolLoop, thread) != thrd_success) {
+    pool->threads.length--;
+    pool->idle--;
+    free(thread);
+    return false;
+  }
+
+  return true;
+}
+
 bool lovrThreadModuleInit() {
   if (state.initialized) return false;
   arr_init(&state.channels);
   map_init(&state.channelMap, 0);
+  state.pool = calloc(1, sizeof(ThreadPool));
+  lovrAssert(state.pool, "Out of memory");
+  mtx_init(&state.pool->lock, mtx_plain);
+  cnd_init(&state.pool->cond);
+  arr_init(&state.pool->threads);
+  arr_init(&state.pool->pending);
+  state.pool->refs = 1;
+  lovrJobsInit(0);
   return state.initialized = true;
 }
 
+// Idle pool threads are joined, busy ones are detached and left to finish on their own, like threads
+// that were still running at exit used to be.  Each detached thread holds a reference to the pool.
 void lovrThreadModuleDestroy() {
   if (!state.initialized) return;
+  lovrJobsDestroy();
+
+  ThreadPool* pool = state.pool;
+  arr_t(PoolThread*) joinable;
+  arr_init(&joinable);
+
+  mtx_lock(&pool->lock);
+  pool->quit = true;
+  cnd_broadcast(&pool->cond);
+  for (size_t i = 0; i < pool->threads.length; i++) {
+    PoolThread* thread = pool->threads.data[i];
+    if (thread->busy) {
+      thrd_detach(thread->handle);
+      thread->pool = NULL;
+      pool->refs++;
+    } else {
+      arr_push(&joinable, thread);
+    }
+  }
+  arr_clear(&pool->threads);
+  mtx_unlock(&pool->lock);
+
+  for (size_t i = 0; i < joinable.length; i++) {
+    thrd_join(joinable.data[i]->handle, NULL);
+    free(joinable.data[i]);
+  }
+  arr_free(&joinable);
+
+  // Nothing takes pending Threads once quit is set
+  mtx_lock(&pool->lock);
+  for (size_t i = pool->pendingHead; i < pool->pending.length; i++) {
+    finishThread(pool->pending.data[i]);
+  }
+  arr_clear(&pool->pending);
+  pool->pendingHead = 0;
+  if (!releasePool(pool)) {
+    mtx_unlock(&pool->lock);
+  }
+  state.pool = NULL;
+
   for (size_t i = 0; i < state.channels.length; i++) {
     lovrRelease(Channel, state.channels.data[i]);
   }
@@ -38,7 +233,7 @@ Channel* lovrThreadGetChannel(const char* name) {
   if (index == MAP_NIL) {
     index = state.channels.length;
     map_set(&state.channelMap, hash, index);
-    arr_push(&state.channels, lovrChannelCreate(hash));
+    arr_push(&state.channels, lovrChannelCreate(hash, 0));
   }
 
   return state.channels.data[index];
@@ -55,36 +250,87 @@ void lovrThreadRemoveChannel(uint64_t hash) {
   arr_splice(&state.channels, index, 1);
 }
 
+// Makes sure at least count pool threads are idle (up to the idle limit), new ones call the runner
+// with NULL to warm up
+void lovrThreadPrewarm(uint32_t count, int (*runner)(void*)) {
+  ThreadPool* pool = state.pool;
+  bool spawned = true;
+  count = MIN(count, MAX_IDLE_THREADS);
+  mtx_lock(&pool->lock);
+  while (pool->idle < count && spawned) {
+    spawned = spawn(pool, runner);
+  }
+  mtx_unlock(&pool->lock);
+  lovrAssert(spawned, "Could not create thread...sorry");
+}
+
+void lovrThreadGetPoolSize(uint32_t* total, uint32_t* idle) {
+  ThreadPool* pool = state.pool;
+  mtx_lock(&pool->lock);
+  *total = (uint32_t) pool->threads.length;
+  *idle = pool->idle;
+  mtx_unlock(&pool->lock);
+}
+
 Thread* lovrThreadInit(Thread* thread, int (*runner)(void*), Blob* body) {
   lovrRetain(body);
   thread->runner = runner;
   thread->body = body;
   mtx_init(&thread->lock, mtx_plain);
+  cnd_init(&thread->finished);
   return thread;
 }
 
 void lovrThreadDestroy(void* ref) {
   Thread* thread = ref;
   mtx_destroy(&thread->lock);
-  thrd_detach(thread->handle);
+  cnd_destroy(&thread->finished);
   lovrRelease(Blob, thread->body);
   free(thread->error);
 }
 
+// The pool holds a reference to the Thread until it finishes running
 void lovrThreadStart(Thread* thread) {
-  bool running = lovrThreadIsRunning(thread);
-
-  if (running) {
+  mtx_lock(&thread->lock);
+  if (thread->running) {
+    mtx_unlock(&thread->lock);
     return;
   }
 
+  thread->running = true;
   free(thread->error);
   thread->error = NULL;
-  lovrAssert(thrd_create(&thread->handle, thread->runner, thread) == thrd_success, "Could not create thread...sorry");
+  thread->startTime = lovrPlatformGetTime();
+  thread->startupTime = 0.;
+  mtx_unlock(&thread->lock);
+
+  lovrRetain(thread);
+  ThreadPool* pool = state.pool;
+  bool spawned = true;
+  mtx_lock(&pool->lock);
+  arr_push(&pool->pending, thread);
+  if (pool->idle < pool->pending.length - pool->pendingHead) {
+    spawned = spawn(pool, NULL);
+  }
+  if (spawned) {
+    cnd_signal(&pool->cond);
+  } else {
+    pool->pending.length--;
+  }
+  mtx_unlock(&pool->lock);
+
+  if (!spawned) {
+    finishThread(thread);
+    lovrThrow("Could not create thread...sorry");
+  }
 }
 
 void lovrThreadWait(Thread* thread) {
-  thrd_join(thread->handle, NULL);
+  mtx_lock(&thread->lock);
+  while (thread->running) {
+    cnd_wait(&thread->finished, &thread->lock);
+  }
+  mtx_unlock(&thread->lock);
 }
 
 bool lovrThreadIsRunning(Thread* thread) {
@@ -97,3 +343,11 @@ bool lovrThreadIsRunning(Thread* thread) {
 const char* lovrThreadGetError(Thread* thread) {
   return thread->error;
 }
+
+// Time from the start call until the body began running, including any compilation
+double lovrThreadGetStartupTime(Thread* thread) {
+  mtx_lock(&thread->lock);
+  double time = thread->startupTime;
+  mtx_unlock(&thread->lock);
+  return time;
+}
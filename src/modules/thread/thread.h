@@ -7,19 +7,25 @@
 
 struct Channel;
 
+// Threads run on a pool of OS threads that stay alive between runs.  The runner is called on a
+// pool thread for each run, and once with NULL when a thread is pre-warmed.
 typedef struct Thread {
-  thrd_t handle;
   mtx_t lock;
+  cnd_t finished;
   Blob* body;
   int (*runner)(void*);
   char* error;
   bool running;
+  double startTime;
+  double startupTime;
 } Thread;
 
 bool lovrThreadModuleInit(void);
 void lovrThreadModuleDestroy(void);
 struct Channel* lovrThreadGetChannel(const char* name);
 void lovrThreadRemoveChannel(uint64_t hash);
+void lovrThreadPrewarm(uint32_t count, int (*runner)(void*));
+void lovrThreadGetPoolSize(uint32_t* total, uint32_t* idle);
 
 Thread* lovrThreadInit(Thread* thread, int (*runner)(void*), Blob* body);
 #define lovrThreadCreate(...) lovrThreadInit(lovrAlloc(Thread), __VA_ARGS__)
@@ -28,3 +34,4 @@ void lovrThreadStart(Thread* thread);
 void lovrThreadWait(Thread* thread);
 const char* lovrThreadGetError(Thread* thread);
 bool lovrThreadIsRunning(Thread* thread);
+double lovrThreadGetStartupTime(Thread* thread);
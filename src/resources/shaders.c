@@ -335,23 +335,23 @@ const char* lovrFillVertexShader = ""
 "  return lovrVertex; \n"
 "}";
 
-const char* lovrShaderScalarUniforms[] = {
-  "lovrMetalness",
-  "lovrRoughness"
+istr_t lovrShaderScalarUniforms[] = {
+  { .string = "lovrMetalness" },
+  { .string = "lovrRoughness" }
 };
 
-const char* lovrShaderColorUniforms[] = {
-  "lovrDiffuseColor",
-  "lovrEmissiveColor"
+istr_t lovrShaderColorUniforms[] = {
+  { .string = "lovrDiffuseColor" },
+  { .string = "lovrEmissiveColor" }
 };
 
-const char* lovrShaderTextureUniforms[] = {
-  "lovrDiffuseTexture",
-  "lovrEmissiveTexture",
-  "lovrMetalnessTexture",
-  "lovrRoughnessTexture",
-  "lovrOcclusionTexture",
-  "lovrNormalTexture"
+istr_t lovrShaderTextureUniforms[] = {
+  { .string = "lovrDiffuseTexture" },
+  { .string = "lovrEmissiveTexture" },
+  { .string = "lovrMetalnessTexture" },
+  { .string = "lovrRoughnessTexture" },
+  { .string = "lovrOcclusionTexture" },
+  { .string = "lovrNormalTexture" }
 };
 
 const char* lovrShaderAttributeNames[] = {
@@ -1,3 +1,5 @@
+#include "core/hash.h"
+
 #pragma once
 
 extern const char* lovrShaderVertexPrefix;
@@ -16,7 +18,7 @@ extern const char* lovrPanoFragmentShader;
 extern const char* lovrFontFragmentShader;
 extern const char* lovrFillVertexShader;
 
-extern const char* lovrShaderScalarUniforms[];
-extern const char* lovrShaderColorUniforms[];
-extern const char* lovrShaderTextureUniforms[];
+extern istr_t lovrShaderScalarUniforms[];
+extern istr_t lovrShaderColorUniforms[];
+extern istr_t lovrShaderTextureUniforms[];
 extern const char* lovrShaderAttributeNames[];
@@ -0,0 +1,173 @@
+#include "thread/channel.h"
+#include "event/event.h"
+#include "core/ref.h"
+#include "lib/tinycthread/tinycthread.h"
+#include "test.h"
+#include <math.h>
+
+// Checks that Channels keep every message in order and times them, with numbers and with strings
+// (which are copied when they're converted to a Variant, like Lua strings are)
+
+#define BATCH 64
+#define PRODUCERS 4
+
+// The Channels here aren't named, and nothing pushes Thread events or polls the platform
+void lovrThreadRemoveChannel(uint64_t hash) {}
+void lovrThreadDestroy(void* ref) {}
+void lovrPlatformPollEvents(void) {}
+
+static Variant number(double x) {
+  return (Variant) { .type = TYPE_NUMBER, .value.number = x };
+}
+
+static Variant string(const char* s) {
+  size_t length = strlen(s);
+  Variant variant = { .type = TYPE_STRING };
+  variant.value.string.pointer = malloc(length + 1);
+  variant.value.string.length = length;
+  memcpy(variant.value.string.pointer, s, length + 1);
+  return variant;
+}
+
+static void testOrder(uint32_t capacity) {
+  Channel* channel = lovrChannelCreate(0, capacity);
+  uint32_t count = capacity ? capacity : 1000;
+  uint64_t id;
+
+  for (uint32_t i = 0; i < count; i++) {
+    Variant variant = number(i);
+    bool pushed = lovrChannelPush(channel, &variant, NAN, &id);
+    CHECK(capacity == 0 || pushed, "push %u to a Channel with room failed", i);
+  }
+
+  CHECK(lovrChannelGetCount(channel) == count, "count: got %u, expected %u", (uint32_t) lovrChannelGetCount(channel), count);
+
+  if (capacity > 0) {
+    Variant extra = number(-1.);
+    CHECK(!lovrChannelPush(channel, &extra, NAN, &id) && id == 0, "push to a full Channel worked");
+    CHECK(!lovrChannelPush(channel, &extra, .001, &id) && id == 0, "push to a full Channel worked after waiting");
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    Variant variant;
+    bool popped = lovrChannelPop(channel, &variant, NAN);
+    CHECK(popped && variant.value.number == i, "pop %u: got %g", i, popped ? variant.value.number : -1.);
+  }
+
+  Variant variant;
+  CHECK(!lovrChannelPop(channel, &variant, NAN), "pop from an empty Channel worked");
+  lovrRelease(Channel, channel);
+}
+
+typedef struct {
+  Channel* channel;
+  uint32_t producer;
+  uint32_t count;
+  uint64_t sum;
+  bool ordered;
+} Worker;
+
+// Messages are producer * 2^24 + index, so consumers can check that each producer's messages are
+// in order
+static int produce(void* arg) {
+  Worker* worker = arg;
+  uint64_t id;
+  for (uint32_t i = 0; i < worker->count; i++) {
+    Variant variant = number((double) worker->producer * (1 << 24) + i);
+    lovrChannelPush(worker->channel, &variant, INFINITY, &id);
+  }
+  return 0;
+}
+
+static int consume(void* arg) {
+  Worker* worker = arg;
+  uint32_t next[PRODUCERS] = { 0 };
+  worker->ordered = true;
+  for (uint32_t i = 0; i < worker->count; i++) {
+    Variant variant;
+    lovrChannelPop(worker->channel, &variant, INFINITY);
+    uint32_t value = (uint32_t) variant.value.number;
+    uint32_t producer = value >> 24;
+    uint32_t index = value & ((1 << 24) - 1);
+    worker->ordered &= index >= next[producer];
+    next[producer] = index + 1;
+    worker->sum += value;
+  }
+  return 0;
+}
+
+// Runs producers and consumers on their own threads and returns the time per message
+static double stress(uint32_t capacity, uint32_t count) {
+  Channel* channel = lovrChannelCreate(0, capacity);
+  Worker producers[PRODUCERS];
+  Worker consumers[PRODUCERS];
+  thrd_t threads[2 * PRODUCERS];
+  uint64_t expected = 0;
+
+  double start = testTime();
+  for (uint32_t i = 0; i < PRODUCERS; i++) {
+    producers[i] = (Worker) { channel, i, count, 0, true };
+    consumers[i] = (Worker) { channel, i, count, 0, true };
+    thrd_create(&threads[2 * i + 0], consume, &consumers[i]);
+    thrd_create(&threads[2 * i + 1], produce, &producers[i]);
+    for (uint32_t j = 0; j < count; j++) {
+      expected += (uint64_t) i * (1 << 24) + j;
+    }
+  }
+
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < PRODUCERS; i++) {
+    thrd_join(threads[2 * i + 0], NULL);
+    thrd_join(threads[2 * i + 1], NULL);
+    CHECK(consumers[i].ordered, "capacity %u: consumer %u got a producer's messages out of order", capacity, i);
+    sum += consumers[i].sum;
+  }
+  double time = testTime() - start;
+
+  CHECK(sum == expected, "capacity %u: messages were lost or duplicated", capacity);
+  CHECK(lovrChannelGetCount(channel) == 0, "capacity %u: Channel isn't empty", capacity);
+  lovrRelease(Channel, channel);
+  return time / (PRODUCERS * count);
+}
+
+static void pushPop(Channel* channel, Variant variant) {
+  uint64_t id;
+  lovrChannelPush(channel, &variant, NAN, &id);
+  lovrChannelPop(channel, &variant, NAN);
+  lovrVariantDestroy(&variant);
+}
+
+static void pushPopMany(Channel* channel, Variant* variants) {
+  uint64_t id;
+  for (uint32_t i = 0; i < BATCH; i++) {
+    variants[i] = number(i);
+  }
+  lovrChannelPushMany(channel, variants, BATCH, NAN, &id);
+  lovrChannelPopMany(channel, variants, BATCH, NAN);
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 20000, 2000000);
+  Variant variants[BATCH];
+
+  testOrder(0);
+  testOrder(1);
+  testOrder(100);
+
+  Channel* unbounded = lovrChannelCreate(0, 0);
+  Channel* bounded = lovrChannelCreate(0, 1024);
+  BENCH("unbounded push/pop number", count, pushPop(unbounded, number(iteration)));
+  BENCH("bounded push/pop number", count, pushPop(bounded, number(iteration)));
+  BENCH("unbounded push/pop string", count, pushPop(unbounded, string("a short message")));
+  BENCH("bounded push/pop string", count, pushPop(bounded, string("a short message")));
+  BENCH("unbounded pushMany/popMany (per batch)", count / BATCH, pushPopMany(unbounded, variants));
+  BENCH("bounded pushMany/popMany (per batch)", count / BATCH, pushPopMany(bounded, variants));
+  lovrRelease(Channel, unbounded);
+  lovrRelease(Channel, bounded);
+
+  printf("%-40s %10.1f ns\n", "unbounded 4x4 threads (per message)", stress(0, count) * 1e9);
+  printf("%-40s %10.1f ns\n", "bounded(64) 4x4 threads (per message)", stress(64, count) * 1e9);
+  printf("%-40s %10.1f ns\n", "bounded(1024) 4x4 threads (per message)", stress(1024, count) * 1e9);
+
+  return testResult();
+}
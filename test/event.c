@@ -0,0 +1,110 @@
+#include "event/event.h"
+#include "lib/tinycthread/tinycthread.h"
+#include "test.h"
+
+// Pushes events from several threads while this one drains them, and checks that none are lost or
+// repeated and that each producer's events arrive in the order it pushed them.  Draining stalls now
+// and then so the ring fills up and events go through the overflow list too.
+
+#define PRODUCERS 8
+#define DRAIN_SIZE 64
+
+// Nothing pushes Thread events or polls the platform here
+void lovrThreadDestroy(void* ref) {}
+void lovrPlatformPollEvents(void) {}
+
+typedef struct {
+  uint32_t index;
+  uint32_t count;
+} Producer;
+
+static int produce(void* arg) {
+  Producer* producer = arg;
+  for (uint32_t i = 0; i < producer->count; i++) {
+    Event event = { .type = EVENT_CUSTOM };
+    event.data.custom.count = 2;
+    event.data.custom.data[0] = (Variant) { .type = TYPE_NUMBER, .value.number = producer->index };
+    event.data.custom.data[1] = (Variant) { .type = TYPE_NUMBER, .value.number = i };
+    lovrEventPush(event);
+  }
+  return 0;
+}
+
+// Returns the time per event
+static double stress(uint32_t count, bool stall) {
+  Producer producers[PRODUCERS];
+  thrd_t threads[PRODUCERS];
+  uint32_t next[PRODUCERS] = { 0 };
+  uint32_t total = PRODUCERS * count;
+  uint32_t received = 0;
+  uint32_t drains = 0;
+  Event events[DRAIN_SIZE];
+
+  lovrEventInit();
+  double start = testTime();
+
+  for (uint32_t i = 0; i < PRODUCERS; i++) {
+    producers[i] = (Producer) { i, count };
+    thrd_create(&threads[i], produce, &producers[i]);
+  }
+
+  while (received < total) {
+    uint32_t n = lovrEventDrain(events, DRAIN_SIZE);
+
+    for (uint32_t i = 0; i < n; i++) {
+      Event* event = &events[i];
+      if (event->type != EVENT_CUSTOM || event->data.custom.count != 2) {
+        CHECK(false, "got an event that was never pushed");
+        continue;
+      }
+
+      uint32_t producer = (uint32_t) event->data.custom.data[0].value.number;
+      uint32_t index = (uint32_t) event->data.custom.data[1].value.number;
+      CHECK(producer < PRODUCERS && index == next[producer], "producer %u: got event %u, expected %u", producer, index, producer < PRODUCERS ? next[producer] : 0);
+      if (producer < PRODUCERS) {
+        next[producer] = index + 1;
+      }
+    }
+
+    received += n;
+
+    if (n == 0 || (stall && ++drains % 16 == 0)) {
+      thrd_yield();
+    }
+
+    if (testFailures > 0) {
+      break;
+    }
+  }
+
+  for (uint32_t i = 0; i < PRODUCERS; i++) {
+    thrd_join(threads[i], NULL);
+  }
+
+  double time = testTime() - start;
+  Event extra;
+  CHECK(!lovrEventPoll(&extra), "got more events than were pushed");
+  lovrEventDestroy();
+  return time / total;
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 20000, 1000000);
+
+  // Single threaded, through the ring and then past it into the overflow list
+  lovrEventInit();
+  for (uint32_t i = 0; i < 1000; i++) {
+    lovrEventPush((Event) { .type = EVENT_FOCUS, .data.boolean.value = i & 1 });
+  }
+  for (uint32_t i = 0; i < 1000; i++) {
+    Event event;
+    bool polled = lovrEventPoll(&event);
+    CHECK(polled && event.type == EVENT_FOCUS && event.data.boolean.value == (bool) (i & 1), "event %u was lost or reordered", i);
+  }
+  lovrEventDestroy();
+
+  printf("%-40s %10.1f ns\n", "8 producers (per event)", stress(count, false) * 1e9);
+  printf("%-40s %10.1f ns\n", "8 producers, stalling (per event)", stress(count, true) * 1e9);
+
+  return testResult();
+}
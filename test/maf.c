@@ -0,0 +1,109 @@
+#include "core/maf.h"
+#include "test.h"
+
+// Checks that the SIMD maf functions give bitwise identical results to the scalar ones, which are
+// built from maf_reference.c with SIMD turned off, and times both
+
+#define COUNT 256
+
+quat ref_quat_mul(quat q, quat r);
+mat4 ref_mat4_invert(mat4 m);
+mat4 ref_mat4_multiply(mat4 m, mat4 n);
+float* ref_mat4_multiplyVec4(mat4 m, float* v);
+void ref_mat4_transform(mat4 m, vec3 v);
+void ref_mat4_transformDirection(mat4 m, vec3 v);
+
+// Every function as (output, input, matrix or quaternion), so they can be checked and timed the same
+// way.  Both sides are called through pointers, so neither gets inlined into the benchmark.
+typedef void Kernel(float* x, float* y);
+
+static void quatMul(float* q, float* r) { quat_mul(q, r); }
+static void refQuatMul(float* q, float* r) { ref_quat_mul(q, r); }
+static void mat4Invert(float* m, float* unused) { mat4_invert(m); }
+static void refMat4Invert(float* m, float* unused) { ref_mat4_invert(m); }
+static void mat4Multiply(float* m, float* n) { mat4_multiply(m, n); }
+static void refMat4Multiply(float* m, float* n) { ref_mat4_multiply(m, n); }
+static void mat4MultiplyVec4(float* v, float* m) { mat4_multiplyVec4(m, v); }
+static void refMat4MultiplyVec4(float* v, float* m) { ref_mat4_multiplyVec4(m, v); }
+static void mat4Transform(float* v, float* m) { mat4_transform(m, v); }
+static void refMat4Transform(float* v, float* m) { ref_mat4_transform(m, v); }
+static void mat4TransformDirection(float* v, float* m) { mat4_transformDirection(m, v); }
+static void refMat4TransformDirection(float* v, float* m) { ref_mat4_transformDirection(m, v); }
+
+static float quats[COUNT][4];
+static float matrices[COUNT][16];
+static float vectors[COUNT][4];
+
+static float random11(uint32_t* seed) {
+  *seed = *seed * 1664525u + 1013904223u;
+  return (*seed >> 8) / 8388608.f - 1.f;
+}
+
+// Runs a function and its reference on each input with every 17th argument
+static void compare(const char* name, Kernel* kernel, Kernel* reference, float* inputs, size_t size, float* arguments, size_t stride) {
+  for (uint32_t i = 0; i < COUNT; i++) {
+    for (uint32_t j = 0; j < COUNT; j += 17) {
+      float a[16], b[16];
+      memcpy(a, inputs + i * size, size * sizeof(float));
+      memcpy(b, inputs + i * size, size * sizeof(float));
+      kernel(a, arguments + j * stride);
+      reference(b, arguments + j * stride);
+      CHECK(!memcmp(a, b, size * sizeof(float)), "%s %u, %u: results differ", name, i, j);
+    }
+  }
+}
+
+static void bench(const char* name, Kernel* kernel, Kernel* reference, float* inputs, size_t size, float* argument, uint32_t count) {
+  Kernel* volatile kernels[2] = { kernel, reference };
+  float x[16];
+  for (int k = 0; k < 2; k++) {
+    Kernel* f = kernels[k];
+    BENCH(k == 0 ? name : "  scalar", count, memcpy(x, inputs + (iteration % COUNT) * size, size * sizeof(float)); f(x, argument));
+    testSink = (uint64_t) x[0];
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 20000, 20000000);
+  uint32_t seed = 1;
+
+  for (uint32_t i = 0; i < COUNT; i++) {
+    quat_fromAngleAxis(quats[i], random11(&seed) * 3.f, random11(&seed), random11(&seed), random11(&seed));
+    for (int j = 0; j < 16; j++) {
+      matrices[i][j] = random11(&seed) * 10.f;
+    }
+    for (int j = 0; j < 4; j++) {
+      vectors[i][j] = random11(&seed) * (j == 3 ? 1.f : 100.f);
+    }
+  }
+
+  // Some edge cases: identity, a singular matrix, and transforms like the engine uses
+  mat4_identity(matrices[0]);
+  memset(matrices[1], 0, sizeof(matrices[1]));
+  for (uint32_t i = 2; i < 32; i++) {
+    mat4_identity(matrices[i]);
+    mat4_translate(matrices[i], vectors[i][0], vectors[i][1], vectors[i][2]);
+    mat4_rotateQuat(matrices[i], quats[i]);
+    mat4_scale(matrices[i], 1.f + i, 2.f, .5f);
+  }
+  mat4_perspective(matrices[32], .01f, 100.f, 1.f, 1.5f);
+
+  float* q = quats[0];
+  float* m = matrices[0];
+  float* v = vectors[0];
+  compare("quat_mul", quatMul, refQuatMul, q, 4, q, 4);
+  compare("mat4_invert", mat4Invert, refMat4Invert, m, 16, m, 0);
+  compare("mat4_multiply", mat4Multiply, refMat4Multiply, m, 16, m, 16);
+  compare("mat4_multiplyVec4", mat4MultiplyVec4, refMat4MultiplyVec4, v, 4, m, 16);
+  compare("mat4_transform", mat4Transform, refMat4Transform, v, 4, m, 16);
+  compare("mat4_transformDirection", mat4TransformDirection, refMat4TransformDirection, v, 4, m, 16);
+
+  bench("quat_mul", quatMul, refQuatMul, q, 4, quats[3], count);
+  bench("mat4_invert", mat4Invert, refMat4Invert, m, 16, NULL, count);
+  bench("mat4_multiply", mat4Multiply, refMat4Multiply, m, 16, matrices[3], count);
+  bench("mat4_multiplyVec4", mat4MultiplyVec4, refMat4MultiplyVec4, v, 4, matrices[3], count);
+  bench("mat4_transform", mat4Transform, refMat4Transform, v, 4, matrices[40], count);
+  bench("mat4_transformDirection", mat4TransformDirection, refMat4TransformDirection, v, 4, matrices[3], count);
+
+  return testResult();
+}
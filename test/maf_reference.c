@@ -0,0 +1,13 @@
+// The scalar maf functions, whatever the rest of the test is built with, for test/maf.c to compare
+// the SIMD paths against
+#undef __SSE2__
+#undef __ARM_NEON
+#undef __ARM_NEON__
+#include "core/maf.h"
+
+quat ref_quat_mul(quat q, quat r) { return quat_mul(q, r); }
+mat4 ref_mat4_invert(mat4 m) { return mat4_invert(m); }
+mat4 ref_mat4_multiply(mat4 m, mat4 n) { return mat4_multiply(m, n); }
+float* ref_mat4_multiplyVec4(mat4 m, float* v) { return mat4_multiplyVec4(m, v); }
+void ref_mat4_transform(mat4 m, vec3 v) { mat4_transform(m, v); }
+void ref_mat4_transformDirection(mat4 m, vec3 v) { mat4_transformDirection(m, v); }
@@ -0,0 +1,183 @@
+#include "core/map.h"
+#include "core/hash.h"
+#include "test.h"
+
+// Checks map_t against a plain array and times it against the FNV1a + linear probing map it
+// replaced, which is copied below.  Keys are uniform style names, hashed on every lookup like
+// Shader:send did, and pre-hashed like istr_t does.  The old map_remove cleared the empty slot at
+// the end of the cluster instead of the one it emptied, so the removed key stayed in the map, that
+// is fixed in the copy so it can be timed.
+
+#define NAMES 64
+
+static uint64_t fnv64(const void* data, size_t length) {
+  const uint8_t* bytes = data;
+  uint64_t hash = 0xcbf29ce484222325;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3;
+  }
+  return hash;
+}
+
+typedef map_t old_map_t;
+
+static void old_map_rehash(old_map_t* map) {
+  old_map_t old = *map;
+  map->size <<= 1;
+  map->hashes = malloc(2 * map->size * sizeof(uint64_t));
+  map->values = map->hashes + map->size;
+  memset(map->hashes, 0xff, 2 * map->size * sizeof(uint64_t));
+
+  if (old.hashes) {
+    uint64_t mask = map->size - 1;
+    for (uint32_t i = 0; i < old.size; i++) {
+      if (old.hashes[i] != MAP_NIL) {
+        uint64_t index = old.hashes[i] & mask;
+        while (map->hashes[index] != MAP_NIL) {
+          index = (index + 1) & mask;
+        }
+        map->hashes[index] = old.hashes[i];
+        map->values[index] = old.values[i];
+      }
+    }
+    free(old.hashes);
+  }
+}
+
+static uint64_t old_map_find(old_map_t* map, uint64_t hash) {
+  uint64_t mask = map->size - 1;
+  uint64_t h = hash & mask;
+  while (map->hashes[h] != hash && map->hashes[h] != MAP_NIL) {
+    h = (h + 1) & mask;
+  }
+  return h;
+}
+
+static void old_map_init(old_map_t* map) {
+  map->size = 1;
+  map->used = 0;
+  map->hashes = NULL;
+  old_map_rehash(map);
+}
+
+static uint64_t old_map_get(old_map_t* map, uint64_t hash) {
+  return map->values[old_map_find(map, hash)];
+}
+
+static void old_map_set(old_map_t* map, uint64_t hash, uint64_t value) {
+  if (map->used >= (map->size >> 1) + (map->size >> 2)) {
+    old_map_rehash(map);
+  }
+  uint64_t h = old_map_find(map, hash);
+  map->used += map->hashes[h] == MAP_NIL;
+  map->hashes[h] = hash;
+  map->values[h] = value;
+}
+
+static void old_map_remove(old_map_t* map, uint64_t hash) {
+  uint64_t h = old_map_find(map, hash);
+  if (map->hashes[h] == MAP_NIL) {
+    return;
+  }
+  uint64_t mask = map->size - 1;
+  uint64_t i = h;
+  do {
+    i = (i + 1) & mask;
+    uint64_t x = map->hashes[i] & mask;
+    if ((i > h && (x <= h || x > i)) || (i < h && (x <= h && x > i))) {
+      map->hashes[h] = map->hashes[i];
+      map->values[h] = map->values[i];
+      h = i;
+    }
+  } while (map->hashes[i] != MAP_NIL);
+  map->hashes[h] = MAP_NIL;
+  map->values[h] = MAP_NIL;
+  map->used--;
+}
+
+static char names[2 * NAMES][32];
+static size_t lengths[2 * NAMES];
+static uint64_t hashes[2][2 * NAMES];
+
+// Inserts and removes random keys and checks every key against an array after each step
+static void testRandom(uint32_t steps) {
+  enum { KEYS = 300 };
+  uint64_t values[KEYS];
+  uint32_t seed = 7;
+  map_t map;
+  map_init(&map, 0);
+
+  for (uint32_t i = 0; i < KEYS; i++) {
+    values[i] = MAP_NIL;
+  }
+
+  for (uint32_t step = 0; step < steps; step++) {
+    seed = seed * 1664525u + 1013904223u;
+    uint32_t key = (seed >> 8) % KEYS;
+    // Small hashes collide in the low bits a lot, which makes for long clusters
+    uint64_t hash = key * 64 + 3;
+    if (seed & 1) {
+      map_set(&map, hash, step);
+      values[key] = step;
+    } else {
+      map_remove(&map, hash);
+      values[key] = MAP_NIL;
+    }
+
+    if (step % 97 == 0 || step == steps - 1) {
+      uint32_t used = 0;
+      for (uint32_t i = 0; i < KEYS; i++) {
+        uint64_t value = map_get(&map, i * 64 + 3);
+        CHECK(value == values[i], "step %u key %u: got %llu, expected %llu", step, i, (unsigned long long) value, (unsigned long long) values[i]);
+        used += values[i] != MAP_NIL;
+      }
+      CHECK(map.used == used, "step %u: map has %u keys, expected %u", step, map.used, used);
+    }
+  }
+
+  map_free(&map);
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 20000, 5000000);
+  testRandom(100000);
+
+  // The first half of the names are in the maps, the second half are misses
+  static const char* words[] = { "lovr", "Model", "View", "Projection", "Material", "Texture", "Color", "Pose" };
+  for (uint32_t i = 0; i < 2 * NAMES; i++) {
+    lengths[i] = snprintf(names[i], sizeof(names[i]), "%s%s%u", i < NAMES ? "" : "u", words[i % 8], i);
+    hashes[0][i] = fnv64(names[i], lengths[i]);
+    hashes[1][i] = hash64(names[i], lengths[i]);
+  }
+
+  old_map_t old;
+  map_t map;
+  old_map_init(&old);
+  map_init(&map, 0);
+  for (uint32_t i = 0; i < NAMES; i++) {
+    old_map_set(&old, hashes[0][i], i);
+    map_set(&map, hashes[1][i], i);
+  }
+
+  for (uint32_t i = 0; i < 2 * NAMES; i++) {
+    uint64_t expected = i < NAMES ? i : MAP_NIL;
+    CHECK(map_get(&map, hash64(names[i], lengths[i])) == expected, "%s: lookup failed", names[i]);
+  }
+
+  uint64_t sum = 0;
+  BENCH("FNV1a hash", count, sum += fnv64(names[iteration % NAMES], lengths[iteration % NAMES]));
+  BENCH("wyhash hash", count, sum += hash64(names[iteration % NAMES], lengths[iteration % NAMES]));
+  BENCH("linear probing get, hit", count, sum += old_map_get(&old, hashes[0][iteration % NAMES]));
+  BENCH("Robin Hood get, hit", count, sum += map_get(&map, hashes[1][iteration % NAMES]));
+  BENCH("linear probing get, miss", count, sum += old_map_get(&old, hashes[0][NAMES + iteration % NAMES]));
+  BENCH("Robin Hood get, miss", count, sum += map_get(&map, hashes[1][NAMES + iteration % NAMES]));
+  BENCH("FNV1a + linear probing, by name", count, sum += old_map_get(&old, fnv64(names[iteration % NAMES], lengths[iteration % NAMES])));
+  BENCH("wyhash + Robin Hood, by name", count, sum += map_get(&map, hash64(names[iteration % NAMES], lengths[iteration % NAMES])));
+  BENCH("linear probing remove/set", count, old_map_remove(&old, hashes[0][iteration % NAMES]); old_map_set(&old, hashes[0][iteration % NAMES], iteration));
+  BENCH("Robin Hood remove/set", count, map_remove(&map, hashes[1][iteration % NAMES]); map_set(&map, hashes[1][iteration % NAMES], iteration));
+  testSink = sum;
+
+  free(old.hashes);
+  map_free(&map);
+  return testResult();
+}
@@ -0,0 +1,182 @@
+#include "math/math.h"
+#include "core/maf.h"
+#include "test.h"
+#include <math.h>
+
+// Checks the batch math kernels against the single value maf functions and times both.  The
+// kernels and maf can round differently (ARM fuses multiply-adds, NEON normalizes with a refined
+// reciprocal square root estimate), so results are compared with a small relative tolerance.
+
+#define COUNT 1023
+
+static float points[3 * COUNT];
+static float output[3 * COUNT];
+static float matrices[16 * COUNT];
+static float products[16 * COUNT];
+static float quats[2][4 * COUNT];
+static float slerps[4 * COUNT];
+
+// Points at the eye of the projection come out as inf or nan, depending on rounding
+static bool similar(float x, float y) {
+  return fabsf(x - y) <= 1e-6f * MAX(1.f, fabsf(y)) || (!isfinite(x) && !isfinite(y));
+}
+
+static float random01(uint32_t* seed) {
+  *seed = *seed * 1664525u + 1013904223u;
+  return (*seed >> 8) / 16777216.f;
+}
+
+static void testTransform(mat4 m, uint32_t count) {
+  lovrMathTransformPoints(m, points, output, count);
+  for (uint32_t i = 0; i < count; i++) {
+    float v[4] = { points[3 * i + 0], points[3 * i + 1], points[3 * i + 2] };
+    mat4_transform(m, v);
+    for (int j = 0; j < 3; j++) {
+      CHECK(similar(output[3 * i + j], v[j]), "transform %u/%u [%d]: got %g, expected %g", i, count, j, output[3 * i + j], v[j]);
+    }
+  }
+}
+
+static void testNormalize(uint32_t count) {
+  lovrMathNormalizeVectors(points, output, count);
+  for (uint32_t i = 0; i < count; i++) {
+    float v[4] = { points[3 * i + 0], points[3 * i + 1], points[3 * i + 2] };
+    vec3_normalize(v);
+    for (int j = 0; j < 3; j++) {
+      CHECK(similar(output[3 * i + j], v[j]), "normalize %u/%u [%d]: got %g, expected %g", i, count, j, output[3 * i + j], v[j]);
+    }
+  }
+}
+
+static void testMultiply(mat4 m, uint32_t count) {
+  lovrMathMultiplyMatrices(m, matrices, products, count);
+  for (uint32_t i = 0; i < count; i++) {
+    float n[16];
+    memcpy(n, m, sizeof(n));
+    mat4_multiply(n, matrices + 16 * i);
+    for (int j = 0; j < 16; j++) {
+      CHECK(similar(products[16 * i + j], n[j]), "multiply %u [%d]: got %g, expected %g", i, j, products[16 * i + j], n[j]);
+    }
+  }
+}
+
+static void testBoundingBox(uint32_t count) {
+  float aabb[6];
+  float expected[6] = { points[0], points[0], points[1], points[1], points[2], points[2] };
+  lovrMathGetBoundingBox(points, count, aabb);
+  for (uint32_t i = 0; i < count; i++) {
+    for (int j = 0; j < 3; j++) {
+      expected[2 * j + 0] = MIN(expected[2 * j + 0], points[3 * i + j]);
+      expected[2 * j + 1] = MAX(expected[2 * j + 1], points[3 * i + j]);
+    }
+  }
+  for (int j = 0; j < 6; j++) {
+    CHECK(aabb[j] == expected[j], "bounding box of %u [%d]: got %g, expected %g", count, j, aabb[j], expected[j]);
+  }
+}
+
+static void testSlerp(float t) {
+  lovrMathSlerpQuaternions(quats[0], quats[1], t, slerps, COUNT);
+  for (uint32_t i = 0; i < COUNT; i++) {
+    float q[4];
+    memcpy(q, quats[0] + 4 * i, sizeof(q));
+    quat_slerp(q, quats[1] + 4 * i, t);
+    CHECK(!memcmp(q, slerps + 4 * i, sizeof(q)), "slerp %u: results differ", i);
+  }
+}
+
+// The loops the kernels replace, for timing
+static void transformEach(mat4 m, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    float v[4] = { points[3 * i + 0], points[3 * i + 1], points[3 * i + 2] };
+    mat4_transform(m, v);
+    memcpy(output + 3 * i, v, 3 * sizeof(float));
+  }
+}
+
+static void normalizeEach(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    float v[4] = { points[3 * i + 0], points[3 * i + 1], points[3 * i + 2] };
+    vec3_normalize(v);
+    memcpy(output + 3 * i, v, 3 * sizeof(float));
+  }
+}
+
+static void multiplyEach(mat4 m, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    float* n = products + 16 * i;
+    memcpy(n, m, 16 * sizeof(float));
+    mat4_multiply(n, matrices + 16 * i);
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 20, 20000);
+  uint32_t seed = 1;
+
+  for (uint32_t i = 0; i < 3 * COUNT; i++) {
+    points[i] = random01(&seed) * 200.f - 100.f;
+  }
+
+  // Some zero length vectors, in and out of the SIMD blocks
+  memset(points + 3 * 5, 0, 3 * sizeof(float));
+  memset(points + 3 * (COUNT - 1), 0, 3 * sizeof(float));
+
+  for (uint32_t i = 0; i < 16 * COUNT; i++) {
+    matrices[i] = random01(&seed) * 2.f - 1.f;
+  }
+
+  for (uint32_t i = 0; i < COUNT; i++) {
+    float axis[3] = { random01(&seed) - .5f, random01(&seed) - .5f, random01(&seed) - .5f };
+    quat_fromAngleAxis(quats[0] + 4 * i, random01(&seed) * 6.f, axis[0], axis[1], axis[2]);
+    quat_fromAngleAxis(quats[1] + 4 * i, random01(&seed) * 6.f, axis[2], axis[0], axis[1]);
+  }
+
+  float m[16];
+  mat4_identity(m);
+  mat4_translate(m, 1.f, 2.f, 3.f);
+  mat4_rotate(m, 1.f, .3f, .5f, .7f);
+  mat4_scale(m, 2.f, 3.f, 4.f);
+  float projection[16];
+  mat4_perspective(projection, .01f, 100.f, 1.f, 1.5f);
+
+  // Counts that end inside and on the edge of a block of 4
+  for (uint32_t n = 0; n <= 9; n++) {
+    testTransform(m, n);
+    testTransform(projection, n);
+    testNormalize(n);
+    testMultiply(m, n);
+    testBoundingBox(n ? n : 1);
+  }
+
+  testTransform(m, COUNT);
+  testTransform(projection, COUNT);
+  testNormalize(COUNT);
+  testMultiply(m, COUNT);
+  testBoundingBox(COUNT);
+  testSlerp(0.f);
+  testSlerp(.3f);
+  testSlerp(1.f);
+
+  // In place
+  memcpy(output, points, sizeof(points));
+  lovrMathNormalizeVectors(output, output, COUNT);
+  for (uint32_t i = 0; i < 3 * COUNT; i++) {
+    float v[4] = { points[i - i % 3 + 0], points[i - i % 3 + 1], points[i - i % 3 + 2] };
+    vec3_normalize(v);
+    CHECK(similar(output[i], v[i % 3]), "in place normalize [%u]: got %g, expected %g", i, output[i], v[i % 3]);
+  }
+
+  float aabb[6];
+  BENCH("transform points (1023)", count, lovrMathTransformPoints(projection, points, output, COUNT));
+  BENCH("  mat4_transform loop", count, transformEach(projection, COUNT));
+  BENCH("normalize vectors (1023)", count, lovrMathNormalizeVectors(points, output, COUNT));
+  BENCH("  vec3_normalize loop", count, normalizeEach(COUNT));
+  BENCH("multiply matrices (1023)", count, lovrMathMultiplyMatrices(m, matrices, products, COUNT));
+  BENCH("  mat4_multiply loop", count, multiplyEach(m, COUNT));
+  BENCH("bounding box (1023)", count, lovrMathGetBoundingBox(points, COUNT, aabb));
+  BENCH("slerp quaternions (1023)", count, lovrMathSlerpQuaternions(quats[0], quats[1], .3f, slerps, COUNT));
+  testSink = (uint64_t) (output[0] + products[0] + aabb[0] + slerps[0]);
+
+  return testResult();
+}
@@ -0,0 +1,75 @@
+#include "audio/mixer.h"
+#include "test.h"
+#include <math.h>
+
+// Checks the mixer kernels against plain loops and times them for one block of output
+
+#define FRAMES MIXER_FRAMES
+
+static float input[MIXER_INPUT_FRAMES];
+static float mono[FRAMES];
+static float stereo[2 * FRAMES];
+static float expected[2 * FRAMES];
+static int16_t samples[2 * FRAMES];
+
+static void testResample(double position, double step) {
+  lovrMixerResample(mono, input, FRAMES, position, step);
+  for (uint32_t i = 0; i < FRAMES; i++) {
+    double p = position + i * step;
+    uint32_t k = (uint32_t) p;
+    float t = (float) (p - k);
+    float x = input[k] + (input[k + 1] - input[k]) * t;
+    CHECK(mono[i] == x, "resample(%g, %g) frame %u: got %g, expected %g", position, step, i, mono[i], x);
+  }
+}
+
+static void testAccumulate(void) {
+  for (uint32_t i = 0; i < 2 * FRAMES; i++) {
+    stereo[i] = expected[i] = (float) i / FRAMES;
+  }
+  lovrMixerAccumulate(stereo, input, FRAMES, .25f, .75f);
+  for (uint32_t i = 0; i < FRAMES; i++) {
+    expected[2 * i + 0] += input[i] * .25f;
+    expected[2 * i + 1] += input[i] * .75f;
+  }
+  for (uint32_t i = 0; i < 2 * FRAMES; i++) {
+    CHECK(fabsf(stereo[i] - expected[i]) <= 1e-6f, "accumulate sample %u: got %g, expected %g", i, stereo[i], expected[i]);
+  }
+}
+
+static void testConvert(void) {
+  for (uint32_t i = 0; i < 2 * FRAMES; i++) {
+    stereo[i] = (i % 7) * .4f - 1.3f;
+  }
+  lovrMixerConvert(samples, stereo, 2 * FRAMES);
+  for (uint32_t i = 0; i < 2 * FRAMES; i++) {
+    float x = stereo[i] < -1.f ? -1.f : (stereo[i] > 1.f ? 1.f : stereo[i]);
+    CHECK(samples[i] == (int16_t) (x * 32767.f), "convert sample %u: got %d, expected %d", i, samples[i], (int16_t) (x * 32767.f));
+  }
+}
+
+int main(int argc, char** argv) {
+  uint32_t count = testIterations(argc, argv, 2000, 200000);
+
+  for (uint32_t i = 0; i < MIXER_INPUT_FRAMES; i++) {
+    input[i] = sinf(i * .05f);
+  }
+
+  testResample(0., 1.);
+  testResample(3., 1.);
+  testResample(.5, 1.);
+  testResample(.25, .75);
+  testResample(1.125, 1.5);
+  testResample(0., 4.);
+  testAccumulate();
+  testConvert();
+
+  BENCH("resample 1:1", count, lovrMixerResample(mono, input, FRAMES, 0., 1.));
+  BENCH("resample 0.75", count, lovrMixerResample(mono, input, FRAMES, .25, .75));
+  BENCH("resample 1.5", count, lovrMixerResample(mono, input, FRAMES, .25, 1.5));
+  BENCH("accumulate", count, lovrMixerAccumulate(stereo, mono, FRAMES, .5f, .5f));
+  BENCH("convert", count, lovrMixerConvert(samples, stereo, 2 * FRAMES));
+  testSink = samples[0];
+
+  return testResult();
+}
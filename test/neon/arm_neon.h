@@ -0,0 +1,267 @@
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#pragma once
+
+// A plain C stand-in for the NEON intrinsics LÖVR uses, so the NEON paths can be compiled and
+// checked on machines without an ARM compiler.  The tests that use it build with __ARM_NEON defined
+// and this folder on the include path.  Multiply-accumulates round after the multiply, like vmla
+// does.  The reciprocal estimates keep 8 bits of mantissa, about as much as the hardware gives, so
+// the refinement steps have something to do.
+
+typedef struct { float v[4]; } float32x4_t;
+typedef struct { float v[2]; } float32x2_t;
+typedef struct { int32_t v[4]; } int32x4_t;
+typedef struct { uint32_t v[4]; } uint32x4_t;
+typedef struct { int16_t v[4]; } int16x4_t;
+typedef struct { int16_t v[8]; } int16x8_t;
+typedef struct { float32x4_t val[2]; } float32x4x2_t;
+typedef struct { float32x4_t val[3]; } float32x4x3_t;
+typedef struct { float32x4_t val[4]; } float32x4x4_t;
+
+#define NEON_MAP(r, expression) for (int i = 0; i < 4; i++) { r.v[i] = (expression); }
+
+static inline float32x4_t vld1q_f32(const float* p) {
+  float32x4_t r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
+}
+
+static inline void vst1q_f32(float* p, float32x4_t a) {
+  memcpy(p, a.v, sizeof(a.v));
+}
+
+static inline float32x4x2_t vld2q_f32(const float* p) {
+  float32x4x2_t r;
+  for (int i = 0; i < 4; i++) {
+    r.val[0].v[i] = p[2 * i + 0];
+    r.val[1].v[i] = p[2 * i + 1];
+  }
+  return r;
+}
+
+static inline void vst2q_f32(float* p, float32x4x2_t a) {
+  for (int i = 0; i < 4; i++) {
+    p[2 * i + 0] = a.val[0].v[i];
+    p[2 * i + 1] = a.val[1].v[i];
+  }
+}
+
+static inline float32x4x3_t vld3q_f32(const float* p) {
+  float32x4x3_t r;
+  for (int i = 0; i < 4; i++) {
+    r.val[0].v[i] = p[3 * i + 0];
+    r.val[1].v[i] = p[3 * i + 1];
+    r.val[2].v[i] = p[3 * i + 2];
+  }
+  return r;
+}
+
+static inline void vst3q_f32(float* p, float32x4x3_t a) {
+  for (int i = 0; i < 4; i++) {
+    p[3 * i + 0] = a.val[0].v[i];
+    p[3 * i + 1] = a.val[1].v[i];
+    p[3 * i + 2] = a.val[2].v[i];
+  }
+}
+
+static inline float32x4x4_t vld4q_f32(const float* p) {
+  float32x4x4_t r;
+  for (int i = 0; i < 4; i++) {
+    for (int j = 0; j < 4; j++) {
+      r.val[j].v[i] = p[4 * i + j];
+    }
+  }
+  return r;
+}
+
+static inline float32x2_t vdup_n_f32(float x) {
+  float32x2_t r = { { x, x } };
+  return r;
+}
+
+static inline float32x4_t vdupq_n_f32(float x) {
+  float32x4_t r;
+  NEON_MAP(r, x);
+  return r;
+}
+
+static inline float32x4_t vdupq_laneq_f32(float32x4_t a, int lane) {
+  return vdupq_n_f32(a.v[lane]);
+}
+
+static inline float32x4_t vaddq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] + b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vsubq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] - b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vmulq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] * b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vdivq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] / b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vmulq_n_f32(float32x4_t a, float x) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] * x);
+  return r;
+}
+
+static inline float32x4_t vmlaq_f32(float32x4_t a, float32x4_t b, float32x4_t c) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] + (float) (b.v[i] * c.v[i]));
+  return r;
+}
+
+static inline float32x4_t vmlsq_f32(float32x4_t a, float32x4_t b, float32x4_t c) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] - (float) (b.v[i] * c.v[i]));
+  return r;
+}
+
+static inline float32x4_t vmlaq_n_f32(float32x4_t a, float32x4_t b, float x) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] + (float) (b.v[i] * x));
+  return r;
+}
+
+static inline float32x4_t vnegq_f32(float32x4_t a) {
+  float32x4_t r;
+  NEON_MAP(r, -a.v[i]);
+  return r;
+}
+
+static inline float32x4_t vminq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] < b.v[i] ? a.v[i] : b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vmaxq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, a.v[i] > b.v[i] ? a.v[i] : b.v[i]);
+  return r;
+}
+
+static inline uint32x4_t vceqq_f32(float32x4_t a, float32x4_t b) {
+  uint32x4_t r;
+  NEON_MAP(r, a.v[i] == b.v[i] ? ~0u : 0u);
+  return r;
+}
+
+static inline float32x4_t vbslq_f32(uint32x4_t mask, float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  for (int i = 0; i < 4; i++) {
+    uint32_t x, y, z;
+    memcpy(&x, &a.v[i], 4);
+    memcpy(&y, &b.v[i], 4);
+    z = (x & mask.v[i]) | (y & ~mask.v[i]);
+    memcpy(&r.v[i], &z, 4);
+  }
+  return r;
+}
+
+// Lane shuffles, lanes are numbered from the start of a like the hardware does
+static inline float32x4_t vextq_f32(float32x4_t a, float32x4_t b, int n) {
+  float32x4_t r;
+  NEON_MAP(r, i + n < 4 ? a.v[i + n] : b.v[i + n - 4]);
+  return r;
+}
+
+static inline float32x4_t vrev64q_f32(float32x4_t a) {
+  float32x4_t r = { { a.v[1], a.v[0], a.v[3], a.v[2] } };
+  return r;
+}
+
+static inline float32x2_t vget_low_f32(float32x4_t a) {
+  float32x2_t r = { { a.v[0], a.v[1] } };
+  return r;
+}
+
+static inline float32x2_t vget_high_f32(float32x4_t a) {
+  float32x2_t r = { { a.v[2], a.v[3] } };
+  return r;
+}
+
+static inline float32x4_t vcombine_f32(float32x2_t a, float32x2_t b) {
+  float32x4_t r = { { a.v[0], a.v[1], b.v[0], b.v[1] } };
+  return r;
+}
+
+static inline float vgetq_lane_f32(float32x4_t a, int lane) {
+  return a.v[lane];
+}
+
+static inline float32x4_t vsetq_lane_f32(float x, float32x4_t a, int lane) {
+  a.v[lane] = x;
+  return a;
+}
+
+static inline int32x4_t vcvtq_s32_f32(float32x4_t a) {
+  int32x4_t r;
+  NEON_MAP(r, (int32_t) a.v[i]);
+  return r;
+}
+
+static inline int16x4_t vqmovn_s32(int32x4_t a) {
+  int16x4_t r;
+  NEON_MAP(r, (int16_t) (a.v[i] < INT16_MIN ? INT16_MIN : (a.v[i] > INT16_MAX ? INT16_MAX : a.v[i])));
+  return r;
+}
+
+static inline int16x8_t vcombine_s16(int16x4_t a, int16x4_t b) {
+  int16x8_t r;
+  memcpy(r.v + 0, a.v, sizeof(a.v));
+  memcpy(r.v + 4, b.v, sizeof(b.v));
+  return r;
+}
+
+static inline void vst1q_s16(int16_t* p, int16x8_t a) {
+  memcpy(p, a.v, sizeof(a.v));
+}
+
+static inline float neonEstimate(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, 4);
+  bits &= ~((1u << 15) - 1);
+  memcpy(&x, &bits, 4);
+  return x;
+}
+
+static inline float32x4_t vrecpeq_f32(float32x4_t a) {
+  float32x4_t r;
+  NEON_MAP(r, neonEstimate(1.f / a.v[i]));
+  return r;
+}
+
+static inline float32x4_t vrecpsq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, 2.f - a.v[i] * b.v[i]);
+  return r;
+}
+
+static inline float32x4_t vrsqrteq_f32(float32x4_t a) {
+  float32x4_t r;
+  NEON_MAP(r, neonEstimate(1.f / sqrtf(a.v[i])));
+  return r;
+}
+
+static inline float32x4_t vrsqrtsq_f32(float32x4_t a, float32x4_t b) {
+  float32x4_t r;
+  NEON_MAP(r, (3.f - a.v[i] * b.v[i]) / 2.f);
+  return r;
+}
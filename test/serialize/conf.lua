@@ -0,0 +1,7 @@
+function lovr.conf(t)
+  t.modules.audio = false
+  t.modules.graphics = false
+  t.modules.headset = false
+  t.modules.physics = false
+  t.window = nil
+end
@@ -0,0 +1,77 @@
+-- Sends values through Channels and checks they come back the same, then times the round trip.
+-- Strings are copied, and tables and vectors are packed into a single buffer and unpacked again.
+-- Run with `lovr test/serialize`, or `lovr test/serialize bench` for longer runs.
+
+local bench = false
+for _, value in pairs(arg or {}) do
+  if value == 'bench' then bench = true end
+end
+
+local count = bench and 200000 or 2000
+local failures = 0
+
+local function equal(a, b)
+  if type(a) ~= type(b) then return false end
+  if type(a) == 'userdata' then return tostring(a) == tostring(b) end
+  if type(a) ~= 'table' then return a == b end
+  for k, v in pairs(a) do
+    if not equal(v, b[k]) then return false end
+  end
+  for k in pairs(b) do
+    if a[k] == nil then return false end
+  end
+  return true
+end
+
+local flat = {}
+for i = 1, 16 do flat[i] = i * .5 end
+
+local values = {
+  { 'number', 42 },
+  { 'string', 'a short message' },
+  { 'flat table', flat },
+  { 'nested table', { name = 'player', position = { 1, 2, 3 }, flags = { alive = true, team = 2 } } },
+  { 'vec3', lovr.math.newVec3(1, 2, 3) },
+  { 'mat4', lovr.math.newMat4():translate(1, 2, 3) }
+}
+
+local function time(name, n, fn)
+  local best = math.huge
+  for _ = 1, 3 do
+    local start = lovr.timer.getTime()
+    for _ = 1, n do fn() end
+    best = math.min(best, lovr.timer.getTime() - start)
+  end
+  print(string.format('%-40s %10.1f ns', name, best / n * 1e9))
+end
+
+function lovr.run()
+  local unbounded = lovr.thread.getChannel('serialize')
+  local bounded = lovr.thread.newChannel(1024)
+
+  for _, entry in ipairs(values) do
+    local name, value = entry[1], entry[2]
+    unbounded:push(value)
+    if not equal(unbounded:pop(), value) then
+      print(name .. ' changed after a round trip')
+      failures = failures + 1
+    end
+  end
+
+  for _, entry in ipairs(values) do
+    local name, value = entry[1], entry[2]
+    time('unbounded ' .. name, count, function() unbounded:push(value) unbounded:pop() end)
+    time('bounded ' .. name, count, function() bounded:push(value) bounded:pop() end)
+  end
+
+  local batch = {}
+  for i = 1, 64 do batch[i] = flat end
+  time('bounded pushMany/popMany flat (per batch)', count / 64, function()
+    bounded:pushMany(batch)
+    bounded:popMany(64)
+  end)
+
+  return function()
+    return failures > 0 and 1 or 0
+  end
+end
@@ -0,0 +1,58 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#pragma once
+
+// Tests are small programs that exit with a nonzero status when a check fails.  Benchmarks time a
+// block of code and print the best of a few runs, they're run with a short iteration count by ctest
+// and a longer one when the program is passed "bench".
+
+static int testFailures;
+
+#define CHECK(x, ...) do {\
+  if (!(x)) {\
+    fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);\
+    fprintf(stderr, __VA_ARGS__);\
+    fprintf(stderr, "\n");\
+    testFailures++;\
+  }\
+} while (0)
+
+static inline double testTime(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static inline uint32_t testIterations(int argc, char** argv, uint32_t quick, uint32_t full) {
+  return (argc > 1 && !strcmp(argv[1], "bench")) ? full : quick;
+}
+
+// Runs a statement count times, 3 rounds, and prints the best time per iteration
+#define BENCH(name, count, ...) do {\
+  double best = 1e30;\
+  for (int round = 0; round < 3; round++) {\
+    double start = testTime();\
+    for (uint32_t iteration = 0; iteration < (count); iteration++) {\
+      __VA_ARGS__;\
+    }\
+    double time = testTime() - start;\
+    best = time < best ? time : best;\
+  }\
+  printf("%-40s %10.1f ns\n", name, best / (count) * 1e9);\
+} while (0)
+
+// Keeps the compiler from throwing away benchmark results
+static volatile uint64_t testSink;
+
+static inline int testResult(void) {
+  if (testFailures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", testFailures);
+    return 1;
+  }
+  return 0;
+}